@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "alloc.h"
+#include "betree.h"
 
 #ifdef NIF
 #include "erl_nif.h"
@@ -17,6 +18,38 @@ void* enif_calloc(size_t size)
 }
 #endif
 
+static void* default_malloc(void* context, size_t size)
+{
+    (void)context;
+    return bmalloc(size);
+}
+
+static void* default_calloc(void* context, size_t size)
+{
+    (void)context;
+    return bcalloc(size);
+}
+
+static void* default_realloc(void* context, void* ptr, size_t size)
+{
+    (void)context;
+    return brealloc(ptr, size);
+}
+
+static void default_free(void* context, void* ptr)
+{
+    (void)context;
+    bfree(ptr);
+}
+
+const struct betree_allocator default_allocator = {
+    .malloc = default_malloc,
+    .calloc = default_calloc,
+    .realloc = default_realloc,
+    .free = default_free,
+    .context = NULL,
+};
+
 char* bstrdup(const char *s1)
 {
     char *str;
@@ -16,6 +16,11 @@ void* enif_calloc(size_t size);
 
 #include <stdarg.h>
 
+struct betree_allocator;
+
+// Forwards to the macros above
+extern const struct betree_allocator default_allocator;
+
 char* bstrdup(const char *s1);
 int bvasprintf(char **buf, const char *format, va_list va);
 int basprintf(char **buf, const char *format, ...);
@@ -0,0 +1,235 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "arena.h"
+
+// Every block is preceded by its size so that arena_realloc can copy it
+#define ARENA_ALIGN 16
+#define ARENA_HEADER ARENA_ALIGN
+
+static __thread struct betree_event_arena* active_arena = NULL;
+
+static struct betree_event_arena* live_arenas = NULL;
+static bool live_arenas_lock = false;
+
+static void lock_live_arenas()
+{
+    while(__atomic_test_and_set(&live_arenas_lock, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+static void unlock_live_arenas()
+{
+    __atomic_clear(&live_arenas_lock, __ATOMIC_RELEASE);
+}
+
+static struct arena_chunk* make_arena_chunk(size_t size)
+{
+    struct arena_chunk* chunk = bmalloc(sizeof(*chunk));
+    if(chunk == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    chunk->data = bmalloc(size);
+    if(chunk->data == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+struct betree_event_arena* make_event_arena(size_t chunk_size)
+{
+    struct betree_event_arena* arena = bcalloc(sizeof(*arena));
+    if(arena == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    arena->chunk_size = chunk_size < 1024 ? 1024 : chunk_size;
+    arena->chunks = make_arena_chunk(arena->chunk_size);
+    arena->current = arena->chunks;
+    lock_live_arenas();
+    arena->next = live_arenas;
+    if(live_arenas != NULL) {
+        live_arenas->prev = arena;
+    }
+    __atomic_store_n(&live_arenas, arena, __ATOMIC_RELEASE);
+    unlock_live_arenas();
+    return arena;
+}
+
+void reset_event_arena(struct betree_event_arena* arena)
+{
+    for(struct arena_chunk* chunk = arena->chunks; chunk != NULL; chunk = chunk->next) {
+        chunk->used = 0;
+    }
+    arena->current = arena->chunks;
+}
+
+void free_event_arena(struct betree_event_arena* arena)
+{
+    if(arena == NULL) {
+        return;
+    }
+    if(active_arena == arena) {
+        active_arena = NULL;
+    }
+    lock_live_arenas();
+    if(arena->prev != NULL) {
+        arena->prev->next = arena->next;
+    }
+    else {
+        __atomic_store_n(&live_arenas, arena->next, __ATOMIC_RELEASE);
+    }
+    if(arena->next != NULL) {
+        arena->next->prev = arena->prev;
+    }
+    unlock_live_arenas();
+    struct arena_chunk* chunk = arena->chunks;
+    while(chunk != NULL) {
+        struct arena_chunk* next = chunk->next;
+        bfree(chunk->data);
+        bfree(chunk);
+        chunk = next;
+    }
+    bfree(arena);
+}
+
+struct betree_event_arena* use_event_arena(struct betree_event_arena* arena)
+{
+    struct betree_event_arena* previous = active_arena;
+    active_arena = arena;
+    return previous;
+}
+
+struct betree_event_arena* active_event_arena()
+{
+    return active_arena;
+}
+
+static size_t align_size(size_t size)
+{
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static void* arena_alloc(struct betree_event_arena* arena, size_t size)
+{
+    size_t needed = ARENA_HEADER + align_size(size);
+    struct arena_chunk* chunk = arena->current;
+    while(chunk->used + needed > chunk->size) {
+        if(chunk->next == NULL || needed > chunk->next->size) {
+            size_t chunk_size = needed > arena->chunk_size ? needed : arena->chunk_size;
+            struct arena_chunk* added = make_arena_chunk(chunk_size);
+            added->next = chunk->next;
+            lock_live_arenas();
+            chunk->next = added;
+            unlock_live_arenas();
+        }
+        chunk = chunk->next;
+    }
+    arena->current = chunk;
+    unsigned char* block = chunk->data + chunk->used;
+    chunk->used += needed;
+    *(size_t*)block = size;
+    return block + ARENA_HEADER;
+}
+
+void* arena_malloc(size_t size)
+{
+    if(active_arena == NULL) {
+        return bmalloc(size);
+    }
+    return arena_alloc(active_arena, size);
+}
+
+void* arena_calloc(size_t size)
+{
+    if(active_arena == NULL) {
+        return bcalloc(size);
+    }
+    void* ptr = arena_alloc(active_arena, size);
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+static bool arena_owns(const struct betree_event_arena* arena, const void* ptr)
+{
+    for(const struct arena_chunk* chunk = arena->chunks; chunk != NULL; chunk = chunk->next) {
+        if((const unsigned char*)ptr >= chunk->data
+            && (const unsigned char*)ptr < chunk->data + chunk->size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The arena a pointer was carved from, or NULL for heap pointers
+static struct betree_event_arena* find_origin(const void* ptr)
+{
+    if(active_arena != NULL && arena_owns(active_arena, ptr)) {
+        return active_arena;
+    }
+    if(__atomic_load_n(&live_arenas, __ATOMIC_ACQUIRE) == NULL) {
+        return NULL;
+    }
+    struct betree_event_arena* origin = NULL;
+    lock_live_arenas();
+    for(struct betree_event_arena* arena = live_arenas; arena != NULL; arena = arena->next) {
+        if(arena != active_arena && arena_owns(arena, ptr)) {
+            origin = arena;
+            break;
+        }
+    }
+    unlock_live_arenas();
+    return origin;
+}
+
+void* arena_realloc(void* ptr, size_t size)
+{
+    if(ptr == NULL) {
+        return arena_malloc(size);
+    }
+    struct betree_event_arena* origin = find_origin(ptr);
+    if(origin == NULL) {
+        return brealloc(ptr, size);
+    }
+    unsigned char* block = (unsigned char*)ptr - ARENA_HEADER;
+    size_t old_size = *(size_t*)block;
+    struct arena_chunk* chunk = origin->current;
+    bool is_last = origin == active_arena
+        && block + ARENA_HEADER + align_size(old_size) == chunk->data + chunk->used;
+    if(is_last && (size_t)(block - chunk->data) + ARENA_HEADER + align_size(size) <= chunk->size) {
+        chunk->used = (block - chunk->data) + ARENA_HEADER + align_size(size);
+        *(size_t*)block = size;
+        return ptr;
+    }
+    void* copy = arena_malloc(size);
+    if(copy != NULL) {
+        memcpy(copy, ptr, old_size < size ? old_size : size);
+    }
+    return copy;
+}
+
+void arena_free(void* ptr)
+{
+    if(ptr != NULL && find_origin(ptr) == NULL) {
+        bfree(ptr);
+    }
+}
+
+char* arena_strdup(const char* string)
+{
+    size_t size = strlen(string) + 1;
+    char* copy = arena_malloc(size);
+    if(copy != NULL) {
+        memcpy(copy, string, size);
+    }
+    return copy;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+struct arena_chunk {
+    struct arena_chunk* next;
+    size_t size;
+    size_t used;
+    unsigned char* data;
+};
+
+// Bump allocator, released all at once by reset_event_arena
+struct betree_event_arena {
+    size_t chunk_size;
+    struct arena_chunk* chunks;
+    struct arena_chunk* current;
+    // Live arenas are linked so that a pointer can be traced back to its arena
+    struct betree_event_arena* prev;
+    struct betree_event_arena* next;
+};
+
+struct betree_event_arena* make_event_arena(size_t chunk_size);
+void reset_event_arena(struct betree_event_arena* arena);
+void free_event_arena(struct betree_event_arena* arena);
+
+// Returns the previously active arena
+struct betree_event_arena* use_event_arena(struct betree_event_arena* arena);
+struct betree_event_arena* active_event_arena();
+
+// Allocate from the calling thread's active arena, or from the heap when none is active.
+// arena_realloc and arena_free look at where the pointer came from, not at the active arena.
+void* arena_malloc(size_t size);
+void* arena_calloc(size_t size);
+void* arena_realloc(void* ptr, size_t size);
+void arena_free(void* ptr);
+char* arena_strdup(const char* string);
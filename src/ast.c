@@ -13,6 +13,7 @@
 #include "hashmap.h"
 #include "memoize.h"
 #include "printer.h"
+#include "slab.h"
 #include "special.h"
 #include "utils.h"
 #include "value.h"
@@ -20,7 +21,7 @@
 
 struct ast_node* ast_node_create()
 {
-    struct ast_node* node = bcalloc(sizeof(*node));
+    struct ast_node* node = slab_calloc(active_node_slab(), NODE_KIND_AST, sizeof(*node));
     if(node == NULL) {
         fprintf(stderr, "%s bcalloc failed", __func__);
         abort();
@@ -234,6 +235,7 @@ struct ast_node* ast_special_geo_create(const enum ast_special_geo_e op,
         .radius = radius,
         .latitude_var = make_attr_var("latitude", NULL),
         .longitude_var = make_attr_var("longitude", NULL) };
+    init_geo_circle(&geo);
     node->special_expr.type = AST_SPECIAL_GEO;
     node->special_expr.geo = geo;
     return node;
@@ -244,7 +246,10 @@ struct ast_node* ast_special_string_create(
 {
     struct ast_node* node = ast_special_expr_create();
     struct ast_special_string string
-        = { .op = op, .attr_var = make_attr_var(name, NULL), .pattern = bstrdup(pattern) };
+        = { .op = op,
+              .attr_var = make_attr_var(name, NULL),
+              .pattern = bstrdup(pattern),
+              .pattern_length = strlen(pattern) };
     node->special_expr.type = AST_SPECIAL_STRING;
     node->special_expr.string = string;
     return node;
@@ -370,7 +375,7 @@ void free_ast_node(struct ast_node* node)
             break;
         default: abort();
     }
-    bfree(node);
+    slab_free(node);
 }
 
 static void invalid_expr(const char* msg)
@@ -613,8 +618,7 @@ static bool match_special_expr(
                         return false;
                     }
 
-                    return geo_within_radius(
-                        g->latitude, g->longitude, latitude_var, longitude_var, g->radius);
+                    return geo_within_circle(g, latitude_var, longitude_var);
                 }
                 default: abort();
             }
@@ -629,11 +633,11 @@ static bool match_special_expr(
             }
             switch(s->op) {
                 case AST_SPECIAL_CONTAINS:
-                    return contains(value.string, s->pattern);
+                    return contains(value.string, value.length, s->pattern, s->pattern_length);
                 case AST_SPECIAL_STARTSWITH:
-                    return starts_with(value.string, s->pattern);
+                    return starts_with(value.string, value.length, s->pattern, s->pattern_length);
                 case AST_SPECIAL_ENDSWITH:
-                    return ends_with(value.string, s->pattern);
+                    return ends_with(value.string, value.length, s->pattern, s->pattern_length);
                 default: abort();
             }
             return false;
@@ -708,8 +712,7 @@ static bool match_special_expr_counting(
                     }
 
                     (*ops_count)++;
-                    return geo_within_radius(
-                        g->latitude, g->longitude, latitude_var, longitude_var, g->radius);
+                    return geo_within_circle(g, latitude_var, longitude_var);
                 }
                 default: abort();
             }
@@ -725,11 +728,11 @@ static bool match_special_expr_counting(
             (*ops_count)++;
             switch(s->op) {
                 case AST_SPECIAL_CONTAINS:
-                    return contains(value.string, s->pattern);
+                    return contains(value.string, value.length, s->pattern, s->pattern_length);
                 case AST_SPECIAL_STARTSWITH:
-                    return starts_with(value.string, s->pattern);
+                    return starts_with(value.string, value.length, s->pattern, s->pattern_length);
                 case AST_SPECIAL_ENDSWITH:
-                    return ends_with(value.string, s->pattern);
+                    return ends_with(value.string, value.length, s->pattern, s->pattern_length);
                 default: abort();
             }
             return false;
@@ -1344,37 +1347,125 @@ static bool match_equality_expr(
     }
 }
 
-static bool match_node_inner(const struct betree_variable** preds,
+static bool match_opcode_expr(const struct betree_variable** preds, const struct ast_node* node)
+{
+    const struct betree_variable* pred;
+    switch(node->opcode) {
+        case AST_OPCODE_INTEGER_LT:
+            pred = preds[node->compare_expr.attr_var.var];
+            return pred != NULL && pred->value.integer_value < node->compare_expr.value.integer_value;
+        case AST_OPCODE_INTEGER_LE:
+            pred = preds[node->compare_expr.attr_var.var];
+            return pred != NULL && pred->value.integer_value <= node->compare_expr.value.integer_value;
+        case AST_OPCODE_INTEGER_GT:
+            pred = preds[node->compare_expr.attr_var.var];
+            return pred != NULL && pred->value.integer_value > node->compare_expr.value.integer_value;
+        case AST_OPCODE_INTEGER_GE:
+            pred = preds[node->compare_expr.attr_var.var];
+            return pred != NULL && pred->value.integer_value >= node->compare_expr.value.integer_value;
+        case AST_OPCODE_FLOAT_LT:
+            pred = preds[node->compare_expr.attr_var.var];
+            return pred != NULL && pred->value.float_value < node->compare_expr.value.float_value;
+        case AST_OPCODE_FLOAT_LE:
+            pred = preds[node->compare_expr.attr_var.var];
+            return pred != NULL && pred->value.float_value <= node->compare_expr.value.float_value;
+        case AST_OPCODE_FLOAT_GT:
+            pred = preds[node->compare_expr.attr_var.var];
+            return pred != NULL && pred->value.float_value > node->compare_expr.value.float_value;
+        case AST_OPCODE_FLOAT_GE:
+            pred = preds[node->compare_expr.attr_var.var];
+            return pred != NULL && pred->value.float_value >= node->compare_expr.value.float_value;
+        case AST_OPCODE_INTEGER_EQ:
+            pred = preds[node->equality_expr.attr_var.var];
+            return pred != NULL
+                && pred->value.integer_value == node->equality_expr.value.integer_value;
+        case AST_OPCODE_INTEGER_NE:
+            pred = preds[node->equality_expr.attr_var.var];
+            return pred != NULL
+                && pred->value.integer_value != node->equality_expr.value.integer_value;
+        case AST_OPCODE_FLOAT_EQ:
+            pred = preds[node->equality_expr.attr_var.var];
+            return pred != NULL
+                && feq(pred->value.float_value, node->equality_expr.value.float_value);
+        case AST_OPCODE_FLOAT_NE:
+            pred = preds[node->equality_expr.attr_var.var];
+            return pred != NULL
+                && fne(pred->value.float_value, node->equality_expr.value.float_value);
+        case AST_OPCODE_STRING_EQ:
+            pred = preds[node->equality_expr.attr_var.var];
+            return pred != NULL
+                && pred->value.string_value.str == node->equality_expr.value.string_value.str;
+        case AST_OPCODE_STRING_NE:
+            pred = preds[node->equality_expr.attr_var.var];
+            return pred != NULL
+                && pred->value.string_value.str != node->equality_expr.value.string_value.str;
+        case AST_OPCODE_INTEGER_ENUM_EQ:
+            pred = preds[node->equality_expr.attr_var.var];
+            return pred != NULL
+                && pred->value.integer_enum_value.ienum
+                == node->equality_expr.value.integer_enum_value.ienum;
+        case AST_OPCODE_INTEGER_ENUM_NE:
+            pred = preds[node->equality_expr.attr_var.var];
+            return pred != NULL
+                && pred->value.integer_enum_value.ienum
+                != node->equality_expr.value.integer_enum_value.ienum;
+        case AST_OPCODE_GENERIC:
+        default: abort();
+    }
+}
+
+static bool match_node_untracked(const struct betree_variable** preds,
     const struct ast_node* node,
     struct memoize* memoize,
     struct report* report);
 
-static bool match_bool_expr(const struct betree_variable** preds,
+static bool match_node_tracked(const struct betree_variable** preds,
+    const struct ast_node* node,
+    struct memoize* memoize,
+    struct report* report,
+    struct match_reason* reason);
+
+// Searches without reasons get their own copy of the evaluator, free of the reason checks
+static inline __attribute__((always_inline)) bool match_node_inner(
+    const struct betree_variable** preds,
+    const struct ast_node* node,
+    struct memoize* memoize,
+    struct report* report,
+    struct match_reason* reason)
+{
+    if(reason == NULL) {
+        return match_node_untracked(preds, node, memoize, report);
+    }
+    return match_node_tracked(preds, node, memoize, report, reason);
+}
+
+static inline __attribute__((always_inline)) bool match_bool_expr(const struct betree_variable** preds,
     const struct ast_bool_expr bool_expr,
     struct memoize* memoize,
-    struct report* report)
+    struct report* report,
+    struct match_reason* reason)
 {
     switch(bool_expr.op) {
         case AST_BOOL_LITERAL:
             return bool_expr.literal;
         case AST_BOOL_AND: {
-            bool lhs = match_node_inner(preds, bool_expr.binary.lhs, memoize, report);
+            bool lhs = match_node_inner(preds, bool_expr.binary.lhs, memoize, report, reason);
             if(lhs == false) {
                 return false;
             }
-            bool rhs = match_node_inner(preds, bool_expr.binary.rhs, memoize, report);
+            bool rhs = match_node_inner(preds, bool_expr.binary.rhs, memoize, report, reason);
             return rhs;
         }
         case AST_BOOL_OR: {
-            bool lhs = match_node_inner(preds, bool_expr.binary.lhs, memoize, report);
+            bool lhs = match_node_inner(preds, bool_expr.binary.lhs, memoize, report, reason);
             if(lhs == true) {
                 return true;
             }
-            bool rhs = match_node_inner(preds, bool_expr.binary.rhs, memoize, report);
+            bool rhs = match_node_inner(preds, bool_expr.binary.rhs, memoize, report, reason);
             return rhs;
         }
         case AST_BOOL_NOT: {
-            bool result = match_node_inner(preds, bool_expr.unary.expr, memoize, report);
+            bool result = match_node_inner(preds, bool_expr.unary.expr, memoize, report, reason);
             return !result;
         }
         case AST_BOOL_VARIABLE: {
@@ -1446,67 +1537,155 @@ static bool match_is_null_expr(const struct betree_variable** preds,
     }
 }
 
-static bool match_node_inner(const struct betree_variable** preds,
+static betree_var_t set_expr_var(const struct ast_set_expr* set_expr)
+{
+    if(set_expr->left_value.value_type == AST_SET_LEFT_VALUE_VARIABLE) {
+        return set_expr->left_value.variable_value.var;
+    }
+    return set_expr->right_value.variable_value.var;
+}
+
+static void set_leaf_reason(const struct ast_node* node, struct match_reason* reason)
+{
+    switch(node->type) {
+        case AST_TYPE_IS_NULL_EXPR:
+            reason->last = node->is_null_expr.attr_var.var;
+            break;
+        case AST_TYPE_SPECIAL_EXPR:
+            switch(node->special_expr.type) {
+                case AST_SPECIAL_FREQUENCY:
+                    reason->last = node->special_expr.frequency.attr_var.var;
+                    break;
+                case AST_SPECIAL_SEGMENT:
+                    reason->last = node->special_expr.segment.attr_var.var;
+                    break;
+                case AST_SPECIAL_GEO:
+                    reason->last = reason->geo;
+                    break;
+                case AST_SPECIAL_STRING:
+                    reason->last = node->special_expr.string.attr_var.var;
+                    break;
+                default: abort();
+            }
+            break;
+        case AST_TYPE_BOOL_EXPR:
+            if(node->bool_expr.op == AST_BOOL_VARIABLE) {
+                reason->last = node->bool_expr.variable.var;
+            }
+            break;
+        case AST_TYPE_LIST_EXPR:
+            reason->last = node->list_expr.attr_var.var;
+            break;
+        case AST_TYPE_SET_EXPR:
+            reason->last = set_expr_var(&node->set_expr);
+            break;
+        case AST_TYPE_COMPARE_EXPR:
+            reason->last = node->compare_expr.attr_var.var;
+            break;
+        case AST_TYPE_EQUALITY_EXPR:
+            reason->last = node->equality_expr.attr_var.var;
+            break;
+        default: abort();
+    }
+}
+
+static inline __attribute__((always_inline)) bool match_node_body(
+    const struct betree_variable** preds,
     const struct ast_node* node,
     struct memoize* memoize,
-    struct report* report)
+    struct report* report,
+    struct match_reason* reason)
 {
     if(node->memoize_id != INVALID_PRED) {
         if(test_bit(memoize->pass, node->memoize_id)) {
             if(report != NULL) {
                 report->memoized++;
             }
+            if(reason != NULL) {
+                reason->last = reason->memoized[node->memoize_id];
+            }
             return true;
         }
         if(test_bit(memoize->fail, node->memoize_id)) {
             if(report != NULL) {
                 report->memoized++;
             }
+            if(reason != NULL) {
+                reason->last = reason->memoized[node->memoize_id];
+            }
             return false;
         }
     }
+    if(reason != NULL) {
+        set_leaf_reason(node, reason);
+    }
     bool result;
-    switch(node->type) {
-        case AST_TYPE_IS_NULL_EXPR:
-            result = match_is_null_expr(preds, node->is_null_expr);
-            break;
-        case AST_TYPE_SPECIAL_EXPR: {
-            result = match_special_expr(preds, node->special_expr);
-            break;
-        }
-        case AST_TYPE_BOOL_EXPR: {
-            result = match_bool_expr(preds, node->bool_expr, memoize, report);
-            break;
-        }
-        case AST_TYPE_LIST_EXPR: {
-            result = match_list_expr(preds, node->list_expr);
-            break;
-        }
-        case AST_TYPE_SET_EXPR: {
-            result = match_set_expr(preds, node->set_expr);
-            break;
-        }
-        case AST_TYPE_COMPARE_EXPR: {
-            result = match_compare_expr(preds, node->compare_expr);
-            break;
-        }
-        case AST_TYPE_EQUALITY_EXPR: {
-            result = match_equality_expr(preds, node->equality_expr);
-            break;
+    if(node->opcode != AST_OPCODE_GENERIC) {
+        result = match_opcode_expr(preds, node);
+    }
+    else {
+        switch(node->type) {
+            case AST_TYPE_IS_NULL_EXPR:
+                result = match_is_null_expr(preds, node->is_null_expr);
+                break;
+            case AST_TYPE_SPECIAL_EXPR: {
+                result = match_special_expr(preds, node->special_expr);
+                break;
+            }
+            case AST_TYPE_BOOL_EXPR: {
+                result = match_bool_expr(preds, node->bool_expr, memoize, report, reason);
+                break;
+            }
+            case AST_TYPE_LIST_EXPR: {
+                result = match_list_expr(preds, node->list_expr);
+                break;
+            }
+            case AST_TYPE_SET_EXPR: {
+                result = match_set_expr(preds, node->set_expr);
+                break;
+            }
+            case AST_TYPE_COMPARE_EXPR: {
+                result = match_compare_expr(preds, node->compare_expr);
+                break;
+            }
+            case AST_TYPE_EQUALITY_EXPR: {
+                result = match_equality_expr(preds, node->equality_expr);
+                break;
+            }
+            default: abort();
         }
-        default: abort();
     }
     if(node->memoize_id != INVALID_PRED) {
         if(result) {
-            set_bit(memoize->pass, node->memoize_id);
+            set_memoize_pass(memoize, node->memoize_id);
         }
         else {
-            set_bit(memoize->fail, node->memoize_id);
+            set_memoize_fail(memoize, node->memoize_id);
+        }
+        if(reason != NULL) {
+            reason->memoized[node->memoize_id] = reason->last;
         }
     }
     return result;
 }
 
+static bool match_node_untracked(const struct betree_variable** preds,
+    const struct ast_node* node,
+    struct memoize* memoize,
+    struct report* report)
+{
+    return match_node_body(preds, node, memoize, report, NULL);
+}
+
+static bool match_node_tracked(const struct betree_variable** preds,
+    const struct ast_node* node,
+    struct memoize* memoize,
+    struct report* report,
+    struct match_reason* reason)
+{
+    return match_node_body(preds, node, memoize, report, reason);
+}
+
 bool match_node_counting(const struct betree_variable** preds,
     const struct ast_node* node,
     struct memoize* memoize,
@@ -1563,10 +1742,10 @@ bool match_node_counting(const struct betree_variable** preds,
     }
     if(node->memoize_id != INVALID_PRED) {
         if(result) {
-            set_bit(memoize->pass, node->memoize_id);
+            set_memoize_pass(memoize, node->memoize_id);
         }
         else {
-            set_bit(memoize->fail, node->memoize_id);
+            set_memoize_fail(memoize, node->memoize_id);
         }
     }
     return result;
@@ -1577,7 +1756,16 @@ bool match_node(const struct betree_variable** preds,
     struct memoize* memoize,
     struct report* report)
 {
-    return match_node_inner(preds, node, memoize, report);
+    return match_node_untracked(preds, node, memoize, report);
+}
+
+bool match_node_with_reason(const struct betree_variable** preds,
+    const struct ast_node* node,
+    struct memoize* memoize,
+    struct report* report,
+    struct match_reason* reason)
+{
+    return match_node_inner(preds, node, memoize, report, reason);
 }
 
 struct bound_dirty {
@@ -1613,6 +1801,7 @@ static void get_variable_bound_ast_bool_or(const struct attr_domain* domain,
                 break;
             case BETREE_INTEGER:
             case BETREE_INTEGER_LIST:
+            case BETREE_SEGMENTS:
                 bound->imin = d64min(lbound.imin, rbound.imin);
                 break;
             case BETREE_FLOAT:
@@ -1623,7 +1812,6 @@ static void get_variable_bound_ast_bool_or(const struct attr_domain* domain,
             case BETREE_INTEGER_ENUM:
                 bound->smin = smin(lbound.smin, rbound.smin);
                 break;
-            case BETREE_SEGMENTS:
             case BETREE_FREQUENCY_CAPS:
             default:
                 break;
@@ -1637,6 +1825,7 @@ static void get_variable_bound_ast_bool_or(const struct attr_domain* domain,
                 break;
             case BETREE_INTEGER:
             case BETREE_INTEGER_LIST:
+            case BETREE_SEGMENTS:
                 bound->imax = d64max(lbound.imax, rbound.imax);
                 break;
             case BETREE_FLOAT:
@@ -1647,7 +1836,6 @@ static void get_variable_bound_ast_bool_or(const struct attr_domain* domain,
             case BETREE_INTEGER_ENUM:
                 bound->smax = smax(lbound.smax, rbound.smax);
                 break;
-            case BETREE_SEGMENTS:
             case BETREE_FREQUENCY_CAPS:
             default:
                 break;
@@ -1686,6 +1874,7 @@ static void get_variable_bound_ast_bool_and(const struct attr_domain* domain,
                 break;
             case BETREE_INTEGER:
             case BETREE_INTEGER_LIST:
+            case BETREE_SEGMENTS:
                 if(ldirty.min_dirty == true && rdirty.min_dirty == true) {
                     bound->imin = d64min(lbound.imin, rbound.imin);
                 }
@@ -1720,7 +1909,6 @@ static void get_variable_bound_ast_bool_and(const struct attr_domain* domain,
                     bound->smin = rbound.smin;
                 }
                 break;
-            case BETREE_SEGMENTS:
             case BETREE_FREQUENCY_CAPS:
             default:
                 break;
@@ -1742,6 +1930,7 @@ static void get_variable_bound_ast_bool_and(const struct attr_domain* domain,
                 break;
             case BETREE_INTEGER:
             case BETREE_INTEGER_LIST:
+            case BETREE_SEGMENTS:
                 if(ldirty.max_dirty == true && rdirty.max_dirty == true) {
                     bound->imax = d64max(lbound.imax, rbound.imax);
                 }
@@ -1776,7 +1965,6 @@ static void get_variable_bound_ast_bool_and(const struct attr_domain* domain,
                     bound->smax = rbound.smax;
                 }
                 break;
-            case BETREE_SEGMENTS:
             case BETREE_FREQUENCY_CAPS:
             default:
                 break;
@@ -1785,6 +1973,32 @@ static void get_variable_bound_ast_bool_and(const struct attr_domain* domain,
     return;
 }
 
+// Assumes the events' latitudes are within [-90, 90] and their longitudes within [-180, 180]
+static void get_geo_bound(const struct attr_domain* domain,
+    const struct ast_special_geo* geo,
+    struct value_bound* bound,
+    struct bound_dirty* dirty)
+{
+    // Events may only carry coordinates outside the usual ranges when the domain allows it, and
+    // the predicate still matches those, so the box cannot bound them
+    if(domain->attr_var.var == geo->latitude_var.var && geo->has_latitude_box
+        && domain->bound.fmin >= -90 && domain->bound.fmax <= 90) {
+        bound->fmin = geo->latitude_min;
+        bound->fmax = geo->latitude_max;
+        dirty->min_dirty = true;
+        dirty->max_dirty = true;
+    }
+    else if(domain->attr_var.var == geo->longitude_var.var && geo->has_longitude_box
+        && domain->bound.fmin >= -180 && domain->bound.fmax <= 180
+        && geo->longitude - geo->longitude_delta >= -180
+        && geo->longitude + geo->longitude_delta <= 180) {
+        bound->fmin = geo->longitude - geo->longitude_delta;
+        bound->fmax = geo->longitude + geo->longitude_delta;
+        dirty->min_dirty = true;
+        dirty->max_dirty = true;
+    }
+}
+
 static void get_variable_bound_inner(const struct attr_domain* domain,
     const struct ast_node* node,
     struct value_bound* bound,
@@ -1798,6 +2012,19 @@ static void get_variable_bound_inner(const struct attr_domain* domain,
         case AST_TYPE_IS_NULL_EXPR:
             return;
         case AST_TYPE_SPECIAL_EXPR:
+            if(node->special_expr.type == AST_SPECIAL_GEO && !is_reversed
+                && domain->bound.value_type == BETREE_FLOAT) {
+                get_geo_bound(domain, &node->special_expr.geo, bound, dirty);
+            }
+            // Both segment_within and segment_before need the segment in the event
+            if(node->special_expr.type == AST_SPECIAL_SEGMENT && !is_reversed
+                && domain->bound.value_type == BETREE_SEGMENTS
+                && domain->attr_var.var == node->special_expr.segment.attr_var.var) {
+                bound->imin = node->special_expr.segment.segment_id;
+                bound->imax = node->special_expr.segment.segment_id;
+                dirty->min_dirty = true;
+                dirty->max_dirty = true;
+            }
             return;
         case AST_TYPE_LIST_EXPR:
             if(domain->attr_var.var != node->list_expr.attr_var.var) {
@@ -2375,6 +2602,7 @@ struct value_bound get_variable_bound(const struct attr_domain* domain, const st
             break;
         case BETREE_INTEGER:
         case BETREE_INTEGER_LIST:
+        case BETREE_SEGMENTS:
             if(dirty.min_dirty == false) {
                 bound.imin = domain->bound.imin;
             }
@@ -2400,7 +2628,6 @@ struct value_bound get_variable_bound(const struct attr_domain* domain, const st
                 bound.smax = domain->bound.smax;
             }
             break;
-        case BETREE_SEGMENTS:
         case BETREE_FREQUENCY_CAPS:
         default:
             fprintf(stderr, "Invalid domain type to get a bound\n");
@@ -3008,6 +3235,71 @@ void assign_pred_id(struct config* config, struct ast_node* node)
     assign_pred(config->pred_map, node);
 }
 
+static enum ast_opcode_e compare_opcode(const struct ast_compare_expr* compare_expr)
+{
+    bool is_integer = compare_expr->value.value_type == AST_COMPARE_VALUE_INTEGER;
+    switch(compare_expr->op) {
+        case AST_COMPARE_LT:
+            return is_integer ? AST_OPCODE_INTEGER_LT : AST_OPCODE_FLOAT_LT;
+        case AST_COMPARE_LE:
+            return is_integer ? AST_OPCODE_INTEGER_LE : AST_OPCODE_FLOAT_LE;
+        case AST_COMPARE_GT:
+            return is_integer ? AST_OPCODE_INTEGER_GT : AST_OPCODE_FLOAT_GT;
+        case AST_COMPARE_GE:
+            return is_integer ? AST_OPCODE_INTEGER_GE : AST_OPCODE_FLOAT_GE;
+        default: abort();
+    }
+}
+
+static enum ast_opcode_e equality_opcode(const struct ast_equality_expr* equality_expr)
+{
+    bool is_eq = equality_expr->op == AST_EQUALITY_EQ;
+    switch(equality_expr->value.value_type) {
+        case AST_EQUALITY_VALUE_INTEGER:
+            return is_eq ? AST_OPCODE_INTEGER_EQ : AST_OPCODE_INTEGER_NE;
+        case AST_EQUALITY_VALUE_FLOAT:
+            return is_eq ? AST_OPCODE_FLOAT_EQ : AST_OPCODE_FLOAT_NE;
+        case AST_EQUALITY_VALUE_STRING:
+            return is_eq ? AST_OPCODE_STRING_EQ : AST_OPCODE_STRING_NE;
+        case AST_EQUALITY_VALUE_INTEGER_ENUM:
+            return is_eq ? AST_OPCODE_INTEGER_ENUM_EQ : AST_OPCODE_INTEGER_ENUM_NE;
+        default: abort();
+    }
+}
+
+void assign_opcode(struct ast_node* node)
+{
+    switch(node->type) {
+        case AST_TYPE_COMPARE_EXPR:
+            node->opcode = compare_opcode(&node->compare_expr);
+            return;
+        case AST_TYPE_EQUALITY_EXPR:
+            node->opcode = equality_opcode(&node->equality_expr);
+            return;
+        case AST_TYPE_BOOL_EXPR:
+            switch(node->bool_expr.op) {
+                case AST_BOOL_OR:
+                case AST_BOOL_AND:
+                    assign_opcode(node->bool_expr.binary.lhs);
+                    assign_opcode(node->bool_expr.binary.rhs);
+                    return;
+                case AST_BOOL_NOT:
+                    assign_opcode(node->bool_expr.unary.expr);
+                    return;
+                case AST_BOOL_VARIABLE:
+                case AST_BOOL_LITERAL:
+                    return;
+                default: abort();
+            }
+        case AST_TYPE_SET_EXPR:
+        case AST_TYPE_LIST_EXPR:
+        case AST_TYPE_SPECIAL_EXPR:
+        case AST_TYPE_IS_NULL_EXPR:
+            return;
+        default: abort();
+    }
+}
+
 
 void sort_lists(struct ast_node* node)
 {
@@ -3231,13 +3523,11 @@ static size_t get_attr_string_bound(const struct config* config, const char* att
 
 static struct string_map* get_string_map_for_attr(const struct config* config, const char* attr)
 {
-    for(size_t i = 0; i < config->string_map_count; i++) {
-        struct string_map* string_map = &config->string_maps[i];
-        if(strcmp(attr, string_map->attr_var.attr) == 0) {
-            return string_map;
-        }
+    betree_var_t var = try_get_id_for_attr(config, attr);
+    if(var == INVALID_VAR) {
+        return NULL;
     }
-    return NULL;
+    return get_string_map(config, var);
 }
 
 static bool str_valid(const struct config* config, const char* attr, const char* string)
@@ -3246,8 +3536,7 @@ static bool str_valid(const struct config* config, const char* attr, const char*
     struct string_map* string_map = get_string_map_for_attr(config, attr);
     size_t space_left = string_map == NULL ? bound : bound - string_map->string_value_count;
     if(string_map != NULL) {
-        betree_str_t* str = map_get(&string_map->m, string);
-        if(str != NULL) {
+        if(find_interned_string(&string_map->strings, string) != INVALID_STR) {
             return true;
         }
     }
@@ -3275,8 +3564,7 @@ static bool strs_valid(
     if(string_map != NULL) {
         for(size_t i = 0; i < strings->count; i++) {
             const char* string = strings->strings[i].string;
-            betree_str_t* str = map_get(&string_map->m, string);
-            if(str != NULL) {
+            if(find_interned_string(&string_map->strings, string) != INVALID_STR) {
                 found++;
             }
         }
@@ -217,6 +217,16 @@ struct ast_special_geo {
     double radius;
     struct attr_var latitude_var;
     struct attr_var longitude_var;
+    // Filled by init_geo_circle
+    bool has_latitude_box;
+    double latitude_min;
+    double latitude_max;
+    bool has_longitude_box;
+    double longitude_delta;
+    double sin_latitude;
+    double cos_latitude;
+    double sin_longitude;
+    double cos_longitude;
 };
 
 enum ast_special_string_e {
@@ -229,6 +239,7 @@ struct ast_special_string {
     enum ast_special_string_e op;
     struct attr_var attr_var;
     const char* pattern;
+    size_t pattern_length;
 };
 
 enum ast_special_e {
@@ -273,10 +284,33 @@ enum ast_node_type_e {
     AST_TYPE_IS_NULL_EXPR,
 };
 
+// Compare and equality nodes specialized on operator and value type at insertion
+
+enum ast_opcode_e {
+    AST_OPCODE_GENERIC,
+    AST_OPCODE_INTEGER_LT,
+    AST_OPCODE_INTEGER_LE,
+    AST_OPCODE_INTEGER_GT,
+    AST_OPCODE_INTEGER_GE,
+    AST_OPCODE_FLOAT_LT,
+    AST_OPCODE_FLOAT_LE,
+    AST_OPCODE_FLOAT_GT,
+    AST_OPCODE_FLOAT_GE,
+    AST_OPCODE_INTEGER_EQ,
+    AST_OPCODE_INTEGER_NE,
+    AST_OPCODE_FLOAT_EQ,
+    AST_OPCODE_FLOAT_NE,
+    AST_OPCODE_STRING_EQ,
+    AST_OPCODE_STRING_NE,
+    AST_OPCODE_INTEGER_ENUM_EQ,
+    AST_OPCODE_INTEGER_ENUM_NE,
+};
+
 struct ast_node {
     betree_pred_t global_id;
     betree_pred_t memoize_id;
     enum ast_node_type_e type;
+    enum ast_opcode_e opcode;
     union {
         struct ast_compare_expr compare_expr;
         struct ast_equality_expr equality_expr;
@@ -324,6 +358,22 @@ bool match_node(const struct betree_variable** preds,
     struct memoize* memoize,
     struct report* report);
 
+/*
+ * Reason tracking: `last` ends up as the variable of the last leaf evaluated, the one that decided
+ * a failed match. Geo leaves report `geo` and `memoized` keeps the reason of each memoized node.
+ */
+struct match_reason {
+    betree_var_t last;
+    betree_var_t geo;
+    betree_var_t* memoized;
+};
+
+bool match_node_with_reason(const struct betree_variable** preds,
+    const struct ast_node* node,
+    struct memoize* memoize,
+    struct report* report,
+    struct match_reason* reason);
+
 bool match_node_counting(const struct betree_variable** preds,
     const struct ast_node* node,
     struct memoize* memoize,
@@ -338,6 +388,7 @@ void assign_variable_id(struct config* config, struct ast_node* node);
 void assign_str_id(struct config* config, struct ast_node* node, bool always_assign);
 void assign_ienum_id(struct config* config, struct ast_node* node, bool always_assign);
 void assign_pred_id(struct config* config, struct ast_node* node);
+void assign_opcode(struct ast_node* node);
 void sort_lists(struct ast_node* node);
 
 const char* frequency_type_to_string(enum frequency_type_e type);
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "ast_compare.h"
 
 #include "ast.h"
@@ -9,10 +9,16 @@
 #include <string.h>
 
 #include "alloc.h"
+#include "arena.h"
 #include "ast.h"
+#include "binary_event.h"
 #include "betree.h"
 #include "error.h"
+#include "event_reader.h"
 #include "hashmap.h"
+#include "pred_cache.h"
+#include "result_cache.h"
+#include "slab.h"
 #include "tree.h"
 #include "utils.h"
 #include "value.h"
@@ -26,7 +32,14 @@
 /*}*/
 
 int parse(const char* text, struct ast_node** node);
-int event_parse(const char* text, struct betree_event** event);
+
+static int parse_in_tree(const struct config* config, const char* text, struct ast_node** node)
+{
+    struct node_slab* previous = use_node_slab(config->node_slab);
+    int result = parse(text, node);
+    use_node_slab(previous);
+    return result;
+}
 
 static bool is_valid(const struct config* config, const struct ast_node* node)
 {
@@ -51,7 +64,7 @@ bool betree_insert_all(struct betree* tree, size_t count, const char** exprs)
     for(size_t i = 0; i < count - 1; i++) {
         const char* expr = exprs[i];
         struct ast_node* node;
-        if(parse(expr, &node) != 0) {
+        if(parse_in_tree(tree->config, expr, &node) != 0) {
             fprintf(stderr, "Failed to parse id %" PRIu64 ": %s\n", i, expr);
             abort();
         }
@@ -174,6 +187,15 @@ static struct value_bound string_list_bound(size_t min, size_t max)
     return bound;
 }
 
+static struct value_bound segments_bound(int64_t value)
+{
+    struct value_bound bound;
+    bound.value_type = BETREE_SEGMENTS;
+    bound.imin = value;
+    bound.imax = value;
+    return bound;
+}
+
 static struct value_bound integer_enum_bound(size_t value) 
 {
     struct value_bound bound;
@@ -282,7 +304,8 @@ static bool might_be_affected(const struct ast_node* node, betree_var_t var)
                 (node->set_expr.left_value.value_type  == AST_SET_LEFT_VALUE_VARIABLE  && node->set_expr.left_value.variable_value.var  == var) ||
                 (node->set_expr.right_value.value_type == AST_SET_RIGHT_VALUE_VARIABLE && node->set_expr.right_value.variable_value.var == var);
         case AST_TYPE_LIST_EXPR: return node->list_expr.attr_var.var == var;
-        case AST_TYPE_SPECIAL_EXPR: return false;
+        case AST_TYPE_SPECIAL_EXPR:
+            return node->special_expr.type == AST_SPECIAL_SEGMENT && node->special_expr.segment.attr_var.var == var;
         case AST_TYPE_IS_NULL_EXPR: return false;
         default: abort();
     }
@@ -326,6 +349,7 @@ static bool get_simple_variable_bound(betree_var_t var, const struct ast_node* n
                             break;
                         case BETREE_INTEGER:
                         case BETREE_INTEGER_LIST:
+                        case BETREE_SEGMENTS:
                             bound->imin = lbound.imin < rbound.imin ? lbound.imin : rbound.imin;
                             bound->imax = lbound.imax > rbound.imax ? lbound.imax : rbound.imax;
                             break;
@@ -339,7 +363,6 @@ static bool get_simple_variable_bound(betree_var_t var, const struct ast_node* n
                             bound->smin = lbound.smin < rbound.smin ? lbound.smin : rbound.smin;
                             bound->smax = lbound.smax > rbound.smax ? lbound.smax : rbound.smax;
                             break;
-                        case BETREE_SEGMENTS:
                         case BETREE_FREQUENCY_CAPS:
                         default: abort();
                     }
@@ -363,7 +386,12 @@ static bool get_simple_variable_bound(betree_var_t var, const struct ast_node* n
             *bound = list_simple_bound(node->list_expr.value);
             return true;
         case AST_TYPE_SPECIAL_EXPR:
-            return false;
+            // Only a segment that must be present gives a bound
+            if(inverted) {
+                return false;
+            }
+            *bound = segments_bound(node->special_expr.segment.segment_id);
+            return true;
         case AST_TYPE_IS_NULL_EXPR:
             return false;
         default: 
@@ -377,7 +405,7 @@ static void change_boundaries(struct config* config, const struct ast_node* node
     // Use function to extract boundaries, THEN apply them to the config
     for(size_t i = 0; i < config->attr_domain_count; i++) {
         struct attr_domain* attr_domain = config->attr_domains[i];
-        if(attr_domain->bound.value_type == BETREE_BOOLEAN || attr_domain->bound.value_type == BETREE_SEGMENTS || attr_domain->bound.value_type == BETREE_FREQUENCY_CAPS) {
+        if(attr_domain->bound.value_type == BETREE_BOOLEAN || attr_domain->bound.value_type == BETREE_FREQUENCY_CAPS) {
             continue;
         }
         struct value_bound bound;
@@ -392,6 +420,7 @@ static void change_boundaries(struct config* config, const struct ast_node* node
                 break;
             case BETREE_INTEGER:
             case BETREE_INTEGER_LIST:
+            case BETREE_SEGMENTS:
                 if(attr_domain->bound.imin != INT64_MIN) {
                     attr_domain->bound.imin = bound.imin < attr_domain->bound.imin ? bound.imin : attr_domain->bound.imin;
                 }
@@ -420,34 +449,32 @@ static void change_boundaries(struct config* config, const struct ast_node* node
                 }
                 break;
             case BETREE_STRING:
-            case BETREE_STRING_LIST:
-                for(size_t j = 0; j < config->string_map_count; j++) {
-                    if(config->string_maps[j].attr_var.var == attr_domain->attr_var.var) {
-                        size_t smax = config->string_maps[j].string_value_count - 1;
-                        if(attr_domain->bound.smax < SIZE_MAX - 1) {
-                            attr_domain->bound.smax = smax > attr_domain->bound.smax ? smax : attr_domain->bound.smax;
-                        }
-                        else {
-                            attr_domain->bound.smax = smax;
-                        }
+            case BETREE_STRING_LIST: {
+                const struct string_map* string_map = get_string_map(config, attr_domain->attr_var.var);
+                if(string_map != NULL) {
+                    size_t smax = string_map->string_value_count - 1;
+                    if(attr_domain->bound.smax < SIZE_MAX - 1) {
+                        attr_domain->bound.smax = smax > attr_domain->bound.smax ? smax : attr_domain->bound.smax;
+                    }
+                    else {
+                        attr_domain->bound.smax = smax;
                     }
                 }
                 break;
-            case BETREE_INTEGER_ENUM:
-                for(size_t j = 0; j < config->integer_map_count; j++) {
-                    if(config->integer_maps[j].attr_var.var == attr_domain->attr_var.var) {
-                        size_t smax = config->integer_maps[j].integer_value_count - 1;
-                        if(attr_domain->bound.smax < SIZE_MAX - 1) {
-                            attr_domain->bound.smax = smax > attr_domain->bound.smax ? smax : attr_domain->bound.smax;
-                        }
-                        else {
-                            attr_domain->bound.smax = smax;
-                        }
+            }
+            case BETREE_INTEGER_ENUM: {
+                const struct integer_map* integer_map = get_integer_map(config, attr_domain->attr_var.var);
+                if(integer_map != NULL) {
+                    size_t smax = integer_map->integer_value_count - 1;
+                    if(attr_domain->bound.smax < SIZE_MAX - 1) {
+                        attr_domain->bound.smax = smax > attr_domain->bound.smax ? smax : attr_domain->bound.smax;
+                    }
+                    else {
+                        attr_domain->bound.smax = smax;
                     }
                 }
                 break;
-            case BETREE_SEGMENTS:
-                break;
+            }
             case BETREE_FREQUENCY_CAPS:
                 break;
             default:
@@ -459,7 +486,7 @@ static void change_boundaries(struct config* config, const struct ast_node* node
 bool betree_change_boundaries(struct betree* tree, const char* expr)
 {
     struct ast_node* node;
-    if(parse(expr, &node) != 0) {
+    if(parse_in_tree(tree->config, expr, &node) != 0) {
         return false;
     }
     assign_variable_id(tree->config, node);
@@ -472,6 +499,14 @@ bool betree_change_boundaries(struct betree* tree, const char* expr)
     return true;
 }
 
+// Subs only get a dense index once inserted, so made but unused subs don't grow the config
+static void index_sub(struct config* config, struct betree_sub* sub)
+{
+    if(sub->index >= config->sub_count || config->sub_ids[sub->index] != sub->id) {
+        sub->index = add_sub_index(config, sub->id);
+    }
+}
+
 bool betree_insert_with_constants(struct betree* tree,
     betree_sub_t id,
     size_t constant_count,
@@ -479,7 +514,7 @@ bool betree_insert_with_constants(struct betree* tree,
     const char* expr)
 {
     struct ast_node* node;
-    if(parse(expr, &node) != 0) {
+    if(parse_in_tree(tree->config, expr, &node) != 0) {
         fprintf(stderr, "Can't parse %lu\n", id);
         return false;
     }
@@ -497,15 +532,19 @@ bool betree_insert_with_constants(struct betree* tree,
     assign_ienum_id(tree->config, node, false);
     sort_lists(node);
     fix_float_with_no_fractions(tree->config, node);
+    assign_opcode(node);
     assign_pred_id(tree->config, node);
     struct betree_sub* sub = make_sub(tree->config, id, node);
+    index_sub(tree->config, sub);
+    count_pred_shares(tree->config->pred_map, node);
+    tree->config->version++;
     return insert_be_tree(tree->config, sub, tree->cnode, NULL);
 }
 
 const struct betree_sub* betree_make_sub(struct betree* tree, betree_sub_t id, size_t constant_count, const struct betree_constant** constants, const char* expr)
 {
     struct ast_node* node;
-    if(parse(expr, &node) != 0) {
+    if(parse_in_tree(tree->config, expr, &node) != 0) {
         fprintf(stderr, "Can't parse %lu\n", id);
         return NULL;
     }
@@ -530,6 +569,7 @@ const struct betree_sub* betree_make_sub(struct betree* tree, betree_sub_t id, s
     }
     sort_lists(node);
     change_boundaries(tree->config, node);
+    assign_opcode(node);
     assign_pred_id(tree->config, node);
     struct betree_sub* sub = make_sub(tree->config, id, node);
     return sub;
@@ -537,9 +577,18 @@ const struct betree_sub* betree_make_sub(struct betree* tree, betree_sub_t id, s
 
 bool betree_insert_sub(struct betree* tree, const struct betree_sub* sub)
 {
+    index_sub(tree->config, (struct betree_sub*)sub);
+    count_pred_shares(tree->config->pred_map, sub->expr);
+    tree->config->version++;
     return insert_be_tree(tree->config, sub, tree->cnode, NULL);
 }
 
+void betree_set_eager_predicates(struct betree* tree, size_t count)
+{
+    select_eager_preds(tree->config->pred_map, count);
+    fill_eager_circuits(tree->config->pred_map, tree->cnode);
+}
+
 bool betree_insert(struct betree* tree, betree_sub_t id, const char* expr)
 {
     return betree_insert_with_constants(tree, id, 0, NULL, expr);
@@ -588,6 +637,9 @@ static bool betree_exists_with_event_filled(const struct betree* betree, struct
 bool betree_exists(const struct betree* tree, const char* event_str)
 {
     struct betree_event* event = make_event_from_string(tree, event_str);
+    if(event == NULL) {
+        return false;
+    }
     bool result = betree_exists_with_event_filled(tree, event);
     free_event(event);
     return result;
@@ -603,6 +655,9 @@ bool betree_exists_with_event(const struct betree* betree, struct betree_event*
 bool betree_search(const struct betree* tree, const char* event_str, struct report* report)
 {
     struct betree_event* event = make_event_from_string(tree, event_str);
+    if(event == NULL) {
+        return false;
+    }
     bool result = betree_search_with_event_filled(tree, event, report);
     free_event(event);
     return result;
@@ -611,6 +666,9 @@ bool betree_search(const struct betree* tree, const char* event_str, struct repo
 bool betree_search_ids(const struct betree* tree, const char* event_str, struct report* report, const uint64_t* ids, size_t sz)
 {
     struct betree_event* event = make_event_from_string(tree, event_str);
+    if(event == NULL) {
+        return false;
+    }
     bool result = betree_search_with_event_filled_ids(tree, event, report, ids, sz);
     free_event(event);
     return result;
@@ -630,6 +688,438 @@ bool betree_search_with_event_ids(const struct betree* betree, struct betree_eve
     return betree_search_with_event_filled_ids(betree, event, report, ids, sz);
 }
 
+struct betree_event_arena* betree_make_event_arena(size_t chunk_size)
+{
+    return make_event_arena(chunk_size);
+}
+
+void betree_reset_event_arena(struct betree_event_arena* arena)
+{
+    reset_event_arena(arena);
+}
+
+void betree_free_event_arena(struct betree_event_arena* arena)
+{
+    free_event_arena(arena);
+}
+
+struct betree_event* betree_make_event_in_arena(const struct betree* betree, struct betree_event_arena* arena, const char* event_str)
+{
+    struct betree_event_arena* previous = use_event_arena(arena);
+    struct betree_event* event;
+    if(event_read(betree->config, event_str, &event) != 0) {
+        use_event_arena(previous);
+        fprintf(stderr, "Failed to parse event: %s\n", event_str);
+        return NULL;
+    }
+    // Duplicates dropped by the sort are arena or config memory
+    sort_event_lists(event);
+    use_event_arena(previous);
+    return event;
+}
+
+bool betree_search_with_arena(const struct betree* betree, struct betree_event_arena* arena, const char* event_str, struct report* report)
+{
+    struct betree_event* event = betree_make_event_in_arena(betree, arena, event_str);
+    bool result = event != NULL && betree_search_with_event_filled(betree, event, report);
+    reset_event_arena(arena);
+    return result;
+}
+
+struct betree_pred_cache* betree_make_pred_cache(const struct betree* betree, size_t capacity)
+{
+    return make_pred_cache(betree->config, capacity);
+}
+
+void betree_free_pred_cache(struct betree_pred_cache* cache)
+{
+    free_pred_cache(cache);
+}
+
+bool betree_search_with_event_cache(const struct betree* betree, struct betree_event* event, struct betree_pred_cache* cache, struct report* report)
+{
+    fill_event(betree->config, event);
+    sort_event_lists(event);
+    const struct betree_variable** variables
+        = make_environment(betree->config->attr_domain_count, event);
+    if(validate_variables(betree->config, variables) == false) {
+        fprintf(stderr, "Failed to validate event\n");
+        bfree(variables);
+        return false;
+    }
+    return betree_search_with_preds_cache(betree->config, variables, betree->cnode, cache, report);
+}
+
+size_t betree_get_variable_index(const struct betree* betree, const char* name)
+{
+    betree_var_t var = try_get_id_for_attr(betree->config, name);
+    return var == INVALID_VAR ? SIZE_MAX : var;
+}
+
+uint64_t betree_intern_string(const struct betree* betree, size_t index, const char* value)
+{
+    struct attr_var attr_var = { .attr = NULL, .var = index };
+    return try_get_id_for_string(betree->config, attr_var, value);
+}
+
+uint64_t betree_intern_integer_enum(const struct betree* betree, size_t index, int64_t value)
+{
+    struct attr_var attr_var = { .attr = NULL, .var = index };
+    return try_get_id_for_ienum(betree->config, attr_var, value);
+}
+
+struct betree_bound_event* betree_make_bound_event(const struct betree* betree)
+{
+    struct betree_bound_event* event = bcalloc(sizeof(*event));
+    if(event == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    event->config = betree->config;
+    event->variable_count = betree->config->attr_domain_count;
+    event->variables = bcalloc(event->variable_count * sizeof(*event->variables) + 1);
+    event->preds = bcalloc(event->variable_count * sizeof(*event->preds) + 1);
+    event->defined_vars = bcalloc((event->variable_count / 64 + 1) * sizeof(*event->defined_vars));
+    if(event->variables == NULL || event->preds == NULL || event->defined_vars == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    for(size_t i = 0; i < event->variable_count; i++) {
+        event->variables[i].attr_var = betree->config->attr_domains[i]->attr_var;
+    }
+    return event;
+}
+
+void betree_clear_bound_event(struct betree_bound_event* event)
+{
+    memset(event->preds, 0, event->variable_count * sizeof(*event->preds));
+    memset(event->defined_vars, 0, (event->variable_count / 64 + 1) * sizeof(*event->defined_vars));
+    if(event->arena != NULL) {
+        reset_event_arena(event->arena);
+    }
+}
+
+void betree_free_bound_event(struct betree_bound_event* event)
+{
+    if(event == NULL) {
+        return;
+    }
+    bfree(event->variables);
+    bfree(event->preds);
+    bfree(event->defined_vars);
+    free_event_arena(event->arena);
+    bfree(event);
+}
+
+static struct value* bind_value(
+    struct betree_bound_event* event, size_t index, enum betree_value_type_e value_type)
+{
+    if(index >= event->variable_count
+        || event->config->attr_domains[index]->bound.value_type != value_type) {
+        return NULL;
+    }
+    struct betree_variable* variable = &event->variables[index];
+    variable->value.value_type = value_type;
+    event->preds[index] = variable;
+    set_bit(event->defined_vars, index);
+    return &variable->value;
+}
+
+bool betree_set_bound_boolean(struct betree_bound_event* event, size_t index, bool value)
+{
+    struct value* v = bind_value(event, index, BETREE_BOOLEAN);
+    if(v == NULL) {
+        return false;
+    }
+    v->boolean_value = value;
+    return true;
+}
+
+bool betree_set_bound_integer(struct betree_bound_event* event, size_t index, int64_t value)
+{
+    struct value* v = bind_value(event, index, BETREE_INTEGER);
+    if(v == NULL) {
+        return false;
+    }
+    v->integer_value = value;
+    return true;
+}
+
+bool betree_set_bound_float(struct betree_bound_event* event, size_t index, double value)
+{
+    struct value* v = bind_value(event, index, BETREE_FLOAT);
+    if(v == NULL) {
+        return false;
+    }
+    v->float_value = value;
+    return true;
+}
+
+bool betree_set_bound_string(struct betree_bound_event* event, size_t index, uint64_t str, const char* value)
+{
+    struct value* v = bind_value(event, index, BETREE_STRING);
+    if(v == NULL) {
+        return false;
+    }
+    v->string_value.string = value;
+    v->string_value.length = strlen(value);
+    v->string_value.var = index;
+    v->string_value.str = str;
+    return true;
+}
+
+bool betree_set_bound_integer_enum(struct betree_bound_event* event, size_t index, uint64_t ienum, int64_t value)
+{
+    struct value* v = bind_value(event, index, BETREE_INTEGER_ENUM);
+    if(v == NULL) {
+        return false;
+    }
+    v->integer_enum_value.integer = value;
+    v->integer_enum_value.var = index;
+    v->integer_enum_value.ienum = ienum;
+    return true;
+}
+
+bool betree_set_bound_integer_list(struct betree_bound_event* event, size_t index, struct betree_integer_list* value)
+{
+    struct value* v = bind_value(event, index, BETREE_INTEGER_LIST);
+    if(v == NULL) {
+        return false;
+    }
+    sort_and_remove_duplicate_integer_list(value);
+    v->integer_list_value = value;
+    return true;
+}
+
+bool betree_set_bound_string_list(struct betree_bound_event* event, size_t index, struct betree_string_list* value)
+{
+    struct value* v = bind_value(event, index, BETREE_STRING_LIST);
+    if(v == NULL) {
+        return false;
+    }
+    struct attr_var attr_var = event->variables[index].attr_var;
+    for(size_t i = 0; i < value->count; i++) {
+        value->strings[i].var = index;
+        value->strings[i].str = try_get_id_for_string(event->config, attr_var, value->strings[i].string);
+    }
+    sort_and_remove_duplicate_string_list(value);
+    v->string_list_value = value;
+    return true;
+}
+
+bool betree_set_bound_segments(struct betree_bound_event* event, size_t index, struct betree_segments* value)
+{
+    struct value* v = bind_value(event, index, BETREE_SEGMENTS);
+    if(v == NULL) {
+        return false;
+    }
+    sort_segments(value);
+    v->segments_value = value;
+    return true;
+}
+
+bool betree_set_bound_frequency_caps(struct betree_bound_event* event, size_t index, struct betree_frequency_caps* value)
+{
+    struct value* v = bind_value(event, index, BETREE_FREQUENCY_CAPS);
+    if(v == NULL) {
+        return false;
+    }
+    struct attr_var attr_var = event->variables[index].attr_var;
+    for(size_t i = 0; i < value->size; i++) {
+        struct string_value* ns = &value->content[i]->namespace;
+        ns->var = index;
+        ns->str = try_get_id_for_string(event->config, attr_var, ns->string);
+    }
+    index_frequency_caps(value);
+    v->frequency_caps_value = value;
+    return true;
+}
+
+bool betree_search_with_bound_event(const struct betree* betree, struct betree_bound_event* event, struct report* report)
+{
+    if(event->config != betree->config || event->variable_count != betree->config->attr_domain_count) {
+        fprintf(stderr, "Bound event does not match the tree\n");
+        return false;
+    }
+    if(validate_defined_vars(betree->config, event->defined_vars) == false) {
+        fprintf(stderr, "Failed to validate event\n");
+        return false;
+    }
+    return betree_search_with_borrowed_preds(betree->config, event->preds, betree->cnode, NULL, report);
+}
+
+bool betree_read_bound_event(struct betree_bound_event* event, const char* event_str)
+{
+    betree_clear_bound_event(event);
+    if(event->arena == NULL) {
+        event->arena = make_event_arena(0);
+    }
+    struct betree_event_arena* previous = use_event_arena(event->arena);
+    int rc = event_read_bound(event, event_str);
+    use_event_arena(previous);
+    if(rc != 0) {
+        fprintf(stderr, "Failed to parse event: %s\n", event_str);
+        betree_clear_bound_event(event);
+        return false;
+    }
+    return true;
+}
+
+bool betree_search_with_bound_string(const struct betree* betree, struct betree_bound_event* event, const char* event_str, struct report* report)
+{
+    return betree_read_bound_event(event, event_str)
+        && betree_search_with_bound_event(betree, event, report);
+}
+
+struct betree_binary_encoder* betree_make_binary_encoder()
+{
+    return make_binary_encoder();
+}
+
+void betree_reset_binary_encoder(struct betree_binary_encoder* encoder)
+{
+    reset_binary_encoder(encoder);
+}
+
+void betree_free_binary_encoder(struct betree_binary_encoder* encoder)
+{
+    free_binary_encoder(encoder);
+}
+
+const void* betree_binary_encoder_data(const struct betree_binary_encoder* encoder, size_t* length)
+{
+    *length = encoder->size;
+    return encoder->data;
+}
+
+void betree_encode_boolean(struct betree_binary_encoder* encoder, size_t index, bool value)
+{
+    encode_boolean(encoder, index, value);
+}
+
+void betree_encode_integer(struct betree_binary_encoder* encoder, size_t index, int64_t value)
+{
+    encode_integer(encoder, index, value);
+}
+
+void betree_encode_float(struct betree_binary_encoder* encoder, size_t index, double value)
+{
+    encode_float(encoder, index, value);
+}
+
+void betree_encode_string(struct betree_binary_encoder* encoder, size_t index, uint64_t str, const char* value)
+{
+    encode_string(encoder, index, str, value);
+}
+
+void betree_encode_integer_enum(struct betree_binary_encoder* encoder, size_t index, uint64_t ienum, int64_t value)
+{
+    encode_integer_enum(encoder, index, ienum, value);
+}
+
+void betree_encode_integer_list(struct betree_binary_encoder* encoder, size_t index, const struct betree_integer_list* value)
+{
+    encode_integer_list(encoder, index, value);
+}
+
+void betree_encode_string_list(struct betree_binary_encoder* encoder, size_t index, const struct betree_string_list* value)
+{
+    encode_string_list(encoder, index, value);
+}
+
+void betree_encode_segments(struct betree_binary_encoder* encoder, size_t index, const struct betree_segments* value)
+{
+    encode_segments(encoder, index, value);
+}
+
+void betree_encode_frequency_caps(struct betree_binary_encoder* encoder, size_t index, const struct betree_frequency_caps* value)
+{
+    encode_frequency_caps(encoder, index, value);
+}
+
+bool betree_read_binary_event(struct betree_bound_event* event, const void* buffer, size_t length)
+{
+    betree_clear_bound_event(event);
+    if(event->arena == NULL) {
+        event->arena = make_event_arena(0);
+    }
+    struct betree_event_arena* previous = use_event_arena(event->arena);
+    int rc = binary_event_read_bound(event, buffer, length);
+    use_event_arena(previous);
+    if(rc != 0) {
+        fprintf(stderr, "Failed to decode binary event\n");
+        betree_clear_bound_event(event);
+        return false;
+    }
+    return true;
+}
+
+bool betree_search_binary(const struct betree* betree, const void* buffer, size_t length, struct report* report)
+{
+    struct betree_bound_event* event = acquire_binary_event(betree->config);
+    struct betree_event_arena* previous = use_event_arena(event->arena);
+    int rc = binary_event_read_bound(event, buffer, length);
+    use_event_arena(previous);
+    if(rc != 0) {
+        fprintf(stderr, "Failed to decode binary event\n");
+        return false;
+    }
+    return betree_search_with_bound_event(betree, event, report);
+}
+
+struct betree_result_cache* betree_make_result_cache(const struct betree* betree, size_t capacity)
+{
+    return make_result_cache(betree->config, capacity);
+}
+
+bool betree_result_cache_add_volatile(struct betree_result_cache* cache, const struct betree* betree, const char* attr)
+{
+    betree_var_t var = try_get_id_for_attr(betree->config, attr);
+    if(var == INVALID_VAR || var >= cache->attr_count) {
+        return false;
+    }
+    cache->volatile_vars[var] = true;
+    clear_result_cache(cache);
+    return true;
+}
+
+void betree_free_result_cache(struct betree_result_cache* cache)
+{
+    free_result_cache(cache);
+}
+
+bool betree_search_with_event_result_cache(const struct betree* betree, struct betree_event* event, struct betree_result_cache* cache, struct report* report)
+{
+    fill_event(betree->config, event);
+    sort_event_lists(event);
+    const struct betree_variable** variables
+        = make_environment(betree->config->attr_domain_count, event);
+    if(validate_variables(betree->config, variables) == false) {
+        fprintf(stderr, "Failed to validate event\n");
+        bfree(variables);
+        return false;
+    }
+    if(cache->version != betree->config->version) {
+        clear_result_cache(cache);
+        cache->version = betree->config->version;
+    }
+    uint64_t hash = hash_event_key(cache, variables);
+    const struct result_cache_entry* entry = find_result(cache, hash);
+    if(entry != NULL) {
+        cache->hits++;
+        for(size_t i = 0; i < entry->sub_count; i++) {
+            add_sub(entry->subs[i], report);
+        }
+        bfree(variables);
+        return true;
+    }
+    cache->misses++;
+    size_t matched = report->matched;
+    bool result = betree_search_with_preds(betree->config, variables, betree->cnode, report);
+    add_result(cache, hash, report->matched - matched, report->subs + matched);
+    return result;
+}
+
 struct report* make_report()
 {
     struct report* report = bcalloc(sizeof(*report));
@@ -641,6 +1131,8 @@ struct report* make_report()
     report->matched = 0;
     report->memoized = 0;
     report->shorted = 0;
+    report->pred_cache_hits = 0;
+    report->pred_cache_misses = 0;
     report->subs = NULL;
     return report;
 }
@@ -709,6 +1201,13 @@ struct betree* betree_make_with_parameters(uint64_t lnode_max_cap, uint64_t min_
     return betree_make_with_config(config);
 }
 
+struct betree* betree_make_with_allocator(const struct betree_allocator* allocator)
+{
+    struct config* config = make_default_config();
+    use_config_allocator(config, allocator);
+    return betree_make_with_config(config);
+}
+
 void betree_deinit(struct betree* betree)
 {
     free_cnode(betree->cnode);
@@ -721,6 +1220,12 @@ void betree_free(struct betree* betree)
     bfree(betree);
 }
 
+void betree_free_search_cache()
+{
+    free_memoize_cache();
+    free_binary_event_cache();
+}
+
 void betree_add_boolean_variable(struct betree* betree, const char* name, bool allow_undefined)
 {
     add_attr_domain_b(betree->config, name, allow_undefined);
@@ -744,6 +1249,16 @@ void betree_add_string_variable(
     add_attr_domain_bounded_s(betree->config, name, allow_undefined, count);
 }
 
+bool betree_reserve_string_values(struct betree* betree, const char* name, size_t count)
+{
+    betree_var_t var = try_get_id_for_attr(betree->config, name);
+    if(var == INVALID_VAR) {
+        return false;
+    }
+    reserve_string_values(betree->config, betree->config->attr_domains[var]->attr_var, count);
+    return true;
+}
+
 void betree_add_integer_list_variable(
     struct betree* betree, const char* name, bool allow_undefined, int64_t min, int64_t max)
 {
@@ -766,6 +1281,12 @@ void betree_add_segments_variable(struct betree* betree, const char* name, bool
     add_attr_domain_segments(betree->config, name, allow_undefined);
 }
 
+void betree_add_bounded_segments_variable(
+    struct betree* betree, const char* name, bool allow_undefined, int64_t min, int64_t max)
+{
+    add_attr_domain_bounded_segments(betree->config, name, allow_undefined, min, max);
+}
+
 void betree_add_frequency_caps_variable(
     struct betree* betree, const char* name, bool allow_undefined)
 {
@@ -824,7 +1345,7 @@ struct betree_string_list* betree_make_string_list(size_t count)
 
 void betree_add_string(struct betree_string_list* list, size_t index, const char* value)
 {
-    struct string_value s = { .string = bstrdup(value) };
+    struct string_value s = { .string = bstrdup(value), .length = strlen(value) };
     list->strings[index] = s;
 }
 
@@ -832,7 +1353,8 @@ struct betree_segments* betree_make_segments(size_t count)
 {
     struct betree_segments* segments = bmalloc(sizeof(*segments));
     segments->size = count;
-    segments->content = bcalloc(count * sizeof(*segments->content));
+    segments->ids = bcalloc(count * sizeof(*segments->ids));
+    segments->timestamps = bcalloc(count * sizeof(*segments->timestamps));
     return segments;
 }
 
@@ -844,7 +1366,9 @@ struct betree_segment* betree_make_segment(int64_t id, int64_t timestamp)
 void betree_add_segment(
     struct betree_segments* segments, size_t index, struct betree_segment* segment)
 {
-    segments->content[index] = segment;
+    segments->ids[index] = segment->id;
+    segments->timestamps[index] = segment->timestamp;
+    arena_free(segment);
 }
 
 
@@ -853,6 +1377,8 @@ struct betree_frequency_caps* betree_make_frequency_caps(size_t count)
     struct betree_frequency_caps* frequency_caps = bmalloc(sizeof(*frequency_caps));
     frequency_caps->size = count;
     frequency_caps->content = bcalloc(count * sizeof(*frequency_caps->content));
+    frequency_caps->slot_mask = 0;
+    frequency_caps->slots = NULL;
     return frequency_caps;
 }
 
@@ -868,7 +1394,7 @@ struct betree_frequency_cap* betree_make_frequency_cap(const char* stype,
         return NULL;
     }
     struct string_value namespace
-        = { .string = bstrdup(ns), .str = INVALID_STR, .var = INVALID_VAR };
+        = { .string = bstrdup(ns), .length = strlen(ns), .str = INVALID_STR, .var = INVALID_VAR };
     return make_frequency_cap_with_type(type, id, namespace, timestamp_defined, timestamp, value);
 }
 
@@ -908,7 +1434,7 @@ struct betree_variable* betree_make_float_variable(const char* name, double valu
 
 struct betree_variable* betree_make_string_variable(const char* name, const char* value)
 {
-    struct string_value string_value = { .string = bstrdup(value), .var = INVALID_VAR, .str = INVALID_STR };
+    struct string_value string_value = { .string = bstrdup(value), .length = strlen(value), .var = INVALID_VAR, .str = INVALID_STR };
     struct value v = { .value_type = BETREE_STRING, .string_value = string_value };
     return betree_make_variable(name, v);
 }
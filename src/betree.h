@@ -14,11 +14,27 @@ struct betree {
     struct cnode* cnode;
 };
 
+/*
+ * Allocator for the memory a tree owns: the chunks its nodes, subs and expressions are carved
+ * from, the arrays and names inside nodes and subs, and the variable tables of its config. Events,
+ * reports and caches still use the heap. The default forwards to malloc, or to enif_alloc under
+ * NIF.
+ */
+struct betree_allocator {
+    void* (*malloc)(void* context, size_t size);
+    void* (*calloc)(void* context, size_t size);
+    void* (*realloc)(void* context, void* ptr, size_t size);
+    void (*free)(void* context, void* ptr);
+    void* context;
+};
+
 struct report {
     size_t evaluated;
     size_t matched;
     size_t memoized;
     size_t shorted;
+    size_t pred_cache_hits;
+    size_t pred_cache_misses;
     betree_sub_t* subs;
 };
 
@@ -33,6 +49,8 @@ struct report_counting {
 };
 
 struct betree_sub;
+struct betree_pred_cache;
+struct betree_result_cache;
 struct betree_constant;
 struct betree_variable;
 
@@ -72,6 +90,7 @@ void betree_add_string(struct betree_string_list* list, size_t index, const char
 
 struct betree_segments* betree_make_segments(size_t count);
 struct betree_segment* betree_make_segment(int64_t id, int64_t timestamp);
+// Copies segment into segments at index and frees it
 void betree_add_segment(struct betree_segments* segments, size_t index, struct betree_segment* segment);
 
 struct betree_frequency_caps* betree_make_frequency_caps(size_t count);
@@ -91,6 +110,7 @@ const struct betree_variable** make_environment(size_t attr_domain_count, const
 void betree_init(struct betree* betree);
 struct betree* betree_make();
 struct betree* betree_make_with_parameters(uint64_t lnode_max_cap, uint64_t min_partition_size);
+struct betree* betree_make_with_allocator(const struct betree_allocator* allocator);
 
 void betree_add_boolean_variable(struct betree* betree, const char* name, bool allow_undefined);
 void betree_add_integer_variable(struct betree* betree, const char* name, bool allow_undefined, int64_t min, int64_t max);
@@ -100,13 +120,22 @@ void betree_add_integer_list_variable(struct betree* betree, const char* name, b
 void betree_add_integer_enum_variable(struct betree* betree, const char* name, bool allow_undefined, size_t count);
 void betree_add_string_list_variable(struct betree* betree, const char* name, bool allow_undefined, size_t count);
 void betree_add_segments_variable(struct betree* betree, const char* name, bool allow_undefined);
+// Segment ids within [min, max] let the tree partition segment_within and segment_before subs
+void betree_add_bounded_segments_variable(struct betree* betree, const char* name, bool allow_undefined, int64_t min, int64_t max);
 void betree_add_frequency_caps_variable(struct betree* betree, const char* name, bool allow_undefined);
+bool betree_reserve_string_values(struct betree* betree, const char* name, size_t count);
 
 bool betree_change_boundaries(struct betree* tree, const char* expr);
 
 const struct betree_sub* betree_make_sub(struct betree* tree, betree_sub_t id, size_t constant_count, const struct betree_constant** constants, const char* expr);
 bool betree_insert_sub(struct betree* tree, const struct betree_sub* sub);
 
+/*
+ * Evaluate the `count` (at most 64) most shared predicates once per event, before the tree walk,
+ * and reject subs whose required predicates already failed. Call after inserting the subs.
+ */
+void betree_set_eager_predicates(struct betree* tree, size_t count);
+
 /*
  * Runtime
  */
@@ -130,11 +159,97 @@ void betree_set_variable(struct betree_event* event, size_t index, struct betree
 bool betree_insert(struct betree* tree, betree_sub_t id, const char* expr);
 bool betree_insert_with_constants(struct betree* tree, betree_sub_t id, size_t constant_count, const struct betree_constant** constants, const char* expr);
 
+/*
+ * Searches keep their memoize buffers, and betree_search_binary its event, in thread local caches
+ * that are reused across calls. They are not freed when a thread exits: a thread that is done
+ * searching must call betree_free_search_cache, or the memory leaks.
+ */
 bool betree_search(const struct betree* tree, const char* event_str, struct report* report);
 bool betree_search_ids(const struct betree* tree, const char* event_str, struct report* report, const uint64_t* ids, size_t sz);
 bool betree_search_with_event(const struct betree* betree, struct betree_event* event, struct report* report);
 bool betree_search_with_event_ids(const struct betree* betree, struct betree_event* event, struct report* report, const uint64_t* ids, size_t sz);
 
+/*
+ * Event arena: events parsed into an arena take all their memory from it and are released
+ * together by betree_reset_event_arena, never by betree_free_event. One arena per thread.
+ * betree_search_with_arena parses, searches and resets in one call.
+ */
+struct betree_event_arena;
+struct betree_event_arena* betree_make_event_arena(size_t chunk_size);
+void betree_reset_event_arena(struct betree_event_arena* arena);
+void betree_free_event_arena(struct betree_event_arena* arena);
+struct betree_event* betree_make_event_in_arena(const struct betree* betree, struct betree_event_arena* arena, const char* event_str);
+bool betree_search_with_arena(const struct betree* betree, struct betree_event_arena* arena, const char* event_str, struct report* report);
+
+/*
+ * Predicate cache: remembers, per attribute value, the results of the shared predicates that only
+ * reference that attribute. Bounded to `capacity` entries, one cache per thread. Build it after
+ * the subs are inserted; predicates added later are simply not cached.
+ */
+struct betree_pred_cache* betree_make_pred_cache(const struct betree* betree, size_t capacity);
+void betree_free_pred_cache(struct betree_pred_cache* cache);
+bool betree_search_with_event_cache(const struct betree* betree, struct betree_event* event, struct betree_pred_cache* cache, struct report* report);
+
+/*
+ * Result cache: LRU of matched subs keyed on the filled event. Volatile attributes (such as `now`)
+ * are left out of the key, so events differing only by them share a result. Inserting subs
+ * invalidates the cache.
+ */
+struct betree_result_cache* betree_make_result_cache(const struct betree* betree, size_t capacity);
+bool betree_result_cache_add_volatile(struct betree_result_cache* cache, const struct betree* betree, const char* attr);
+void betree_free_result_cache(struct betree_result_cache* cache);
+bool betree_search_with_event_result_cache(const struct betree* betree, struct betree_event* event, struct betree_result_cache* cache, struct report* report);
+
+/*
+ * Bound events: a reusable event tied to one tree, filled by variable index instead of by name.
+ * Strings and integer enums are resolved once with betree_intern_*; the hot path then does no
+ * allocation, name lookup or hashing (except for string lists and frequency cap namespaces).
+ * Values are borrowed: strings and lists must outlive the search. Setters return false when the
+ * index is out of range or the variable has another type.
+ */
+struct betree_bound_event;
+size_t betree_get_variable_index(const struct betree* betree, const char* name);
+uint64_t betree_intern_string(const struct betree* betree, size_t index, const char* value);
+uint64_t betree_intern_integer_enum(const struct betree* betree, size_t index, int64_t value);
+struct betree_bound_event* betree_make_bound_event(const struct betree* betree);
+void betree_clear_bound_event(struct betree_bound_event* event);
+void betree_free_bound_event(struct betree_bound_event* event);
+bool betree_set_bound_boolean(struct betree_bound_event* event, size_t index, bool value);
+bool betree_set_bound_integer(struct betree_bound_event* event, size_t index, int64_t value);
+bool betree_set_bound_float(struct betree_bound_event* event, size_t index, double value);
+bool betree_set_bound_string(struct betree_bound_event* event, size_t index, uint64_t str, const char* value);
+bool betree_set_bound_integer_enum(struct betree_bound_event* event, size_t index, uint64_t ienum, int64_t value);
+bool betree_set_bound_integer_list(struct betree_bound_event* event, size_t index, struct betree_integer_list* value);
+bool betree_set_bound_string_list(struct betree_bound_event* event, size_t index, struct betree_string_list* value);
+bool betree_set_bound_segments(struct betree_bound_event* event, size_t index, struct betree_segments* value);
+bool betree_set_bound_frequency_caps(struct betree_bound_event* event, size_t index, struct betree_frequency_caps* value);
+bool betree_search_with_bound_event(const struct betree* betree, struct betree_bound_event* event, struct report* report);
+// Parses straight into the bound event, replacing what it held
+bool betree_read_bound_event(struct betree_bound_event* event, const char* event_str);
+bool betree_search_with_bound_string(const struct betree* betree, struct betree_bound_event* event, const char* event_str, struct report* report);
+
+/*
+ * Binary events, built with an encoder and searched without parsing (layout in binary_event.h).
+ * Indexes, strs and ienums are the ones of the bound event API above; pass INVALID_STR or
+ * INVALID_IENUM to have them looked up while decoding. The buffer is referenced by the search.
+ */
+struct betree_binary_encoder;
+struct betree_binary_encoder* betree_make_binary_encoder();
+void betree_reset_binary_encoder(struct betree_binary_encoder* encoder);
+void betree_free_binary_encoder(struct betree_binary_encoder* encoder);
+const void* betree_binary_encoder_data(const struct betree_binary_encoder* encoder, size_t* length);
+void betree_encode_boolean(struct betree_binary_encoder* encoder, size_t index, bool value);
+void betree_encode_integer(struct betree_binary_encoder* encoder, size_t index, int64_t value);
+void betree_encode_float(struct betree_binary_encoder* encoder, size_t index, double value);
+void betree_encode_string(struct betree_binary_encoder* encoder, size_t index, uint64_t str, const char* value);
+void betree_encode_integer_enum(struct betree_binary_encoder* encoder, size_t index, uint64_t ienum, int64_t value);
+void betree_encode_integer_list(struct betree_binary_encoder* encoder, size_t index, const struct betree_integer_list* value);
+void betree_encode_string_list(struct betree_binary_encoder* encoder, size_t index, const struct betree_string_list* value);
+void betree_encode_segments(struct betree_binary_encoder* encoder, size_t index, const struct betree_segments* value);
+void betree_encode_frequency_caps(struct betree_binary_encoder* encoder, size_t index, const struct betree_frequency_caps* value);
+bool betree_read_binary_event(struct betree_bound_event* event, const void* buffer, size_t length);
+bool betree_search_binary(const struct betree* betree, const void* buffer, size_t length, struct report* report);
+
 bool betree_exists(const struct betree* tree, const char* event_str);
 bool betree_exists_with_event(const struct betree* betree, struct betree_event* event);
 
@@ -152,6 +267,9 @@ void free_report_counting(struct report_counting* report);
 void betree_deinit(struct betree* betree);
 void betree_free(struct betree* betree);
 
+// Releases the memoize buffers and binary event reused by searches on the calling thread
+void betree_free_search_cache();
+
 void betree_free_constant(struct betree_constant* constant);
 void betree_free_constants(size_t count, struct betree_constant** constants);
 
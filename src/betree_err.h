@@ -1,5 +1,6 @@
 #pragma once
 
+#include "bitmap.h"
 #include "dyn_arr.h"
 #include "value.h"
 #include <stdbool.h>
@@ -8,17 +9,26 @@
 
 typedef uint64_t betree_sub_t;
 
-struct cnode_err;
+struct betree;
+struct betree_reason_aggregator;
 
+/*
+ * Reason mode of a regular tree: the same engine, but searches also report, per variable, the subs
+ * that did not match because of it. config is the tree's own.
+ */
 struct betree_err {
     struct config* config;
-    struct cnode_err* cnode;
-    dynamic_array_t* sub_ids;
+    struct betree* betree;
 };
 
+/*
+ * subs holds the dense indices (betree_sub.index) of the subs that failed for this reason. list is
+ * the same set as sub ids, filled from subs by betree_reason_map_get.
+ */
 struct betree_reason_t {
     char* name;
     dynamic_array_t* list;
+    struct betree_bitmap* subs;
 };
 
 enum addtional_reason_t {
@@ -31,6 +41,10 @@ enum addtional_reason_t {
 struct betree_reason_map_t {
     size_t size;
     struct betree_reason_t** reasons;
+    const struct config* config;
+    // Scratch for betree_reason_map_indices
+    size_t index_capacity;
+    uint32_t* indices;
 };
 
 #define ADDITIONAL_REASON(domain_count, reason) ((domain_count - 1) + reason)
@@ -52,6 +66,11 @@ struct betree_err* betree_make_err();
 struct betree_err* betree_make_with_parameters_err(
     uint64_t lnode_max_cap, uint64_t min_partition_size);
 
+/*
+ * Renumbers the subs in tree order so that a pruned subtree is reported as one range of indices.
+ * Until then, or after the next insert, reason searches walk pruned subtrees instead. Fails while a
+ * reason aggregator is attached to the tree.
+ */
 bool betree_make_sub_ids(struct betree_err* tree);
 
 void betree_add_boolean_variable_err(
@@ -70,6 +89,8 @@ void betree_add_string_list_variable_err(
     struct betree_err* betree, const char* name, bool allow_undefined, size_t count);
 void betree_add_segments_variable_err(
     struct betree_err* betree, const char* name, bool allow_undefined);
+void betree_add_bounded_segments_variable_err(
+    struct betree_err* betree, const char* name, bool allow_undefined, int64_t min, int64_t max);
 void betree_add_frequency_caps_variable_err(
     struct betree_err* betree, const char* name, bool allow_undefined);
 struct betree_variable_definition betree_get_variable_definition_err(
@@ -111,11 +132,24 @@ bool betree_search_with_event_ids_err(const struct betree_err* betree,
     struct report_err* report,
     const uint64_t* ids,
     size_t sz);
+// Clears report, searches and counts the reasons of the event in aggregator
+bool betree_search_with_event_aggregated_err(const struct betree_err* betree,
+    struct betree_event* event,
+    struct report_err* report,
+    struct betree_reason_aggregator* aggregator);
+bool betree_search_with_event_ids_aggregated_err(const struct betree_err* betree,
+    struct betree_event* event,
+    struct report_err* report,
+    const uint64_t* ids,
+    size_t sz,
+    struct betree_reason_aggregator* aggregator);
 
 // bool betree_delete(struct betree_err* betree, betree_sub_t id);
 
 struct report_err* make_report_err(const struct betree_err* betree);
 void free_report_err(struct report_err* report);
+// Resets a report, keeping its buffers, so it can be reused for the next search
+void clear_report_err(struct report_err* report);
 
 /*
  * Destruction
@@ -129,8 +163,19 @@ void betree_reason_destroy(struct betree_reason_t* reason);
 struct betree_reason_map_t* betree_reason_map_create(const struct betree_err* betree);
 unsigned int betree_reason_map_size(struct betree_reason_map_t* m);
 dynamic_array_t* betree_reason_map_get(struct betree_reason_map_t* l, betree_var_t reason);
+// Sorted dense indices of the subs of a reason, valid until the next call on the map
+const uint32_t* betree_reason_map_indices(
+    struct betree_reason_map_t* m, betree_var_t reason, size_t* count);
+void betree_reason_map_add(struct betree_reason_map_t* m, betree_var_t reason, uint32_t index);
+void betree_reason_map_add_range(
+    struct betree_reason_map_t* m, betree_var_t reason, uint32_t begin, uint32_t end);
+// Take sub ids like betree_reason_map_get returns, ids of subs not in the tree are ignored
 void betree_reason_map_additem(
     struct betree_reason_map_t* l, betree_var_t reason, betree_sub_t value);
 void betree_reason_map_join(
     struct betree_reason_map_t* l, betree_var_t reason, dynamic_array_t* sub_ids);
+size_t betree_reason_map_count(const struct betree_reason_map_t* m, betree_var_t reason);
+void betree_reason_map_clear(struct betree_reason_map_t* m);
+// Adds the subs of every reason of src to the same reason of dst, both maps come from the same tree
+void betree_reason_map_merge(struct betree_reason_map_t* dst, const struct betree_reason_map_t* src);
 void betree_reason_map_destroy(struct betree_reason_map_t* reason);
@@ -0,0 +1,533 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "arena.h"
+#include "binary_event.h"
+#include "config.h"
+#include "tree.h"
+#include "utils.h"
+#include "value.h"
+
+_Static_assert(sizeof(struct binary_entry_header) == 16, "entry header is 16 bytes");
+
+static size_t align_entry(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+static void reserve_encoder(struct betree_binary_encoder* encoder, size_t size)
+{
+    if(encoder->size + size <= encoder->capacity) {
+        return;
+    }
+    size_t capacity = encoder->capacity == 0 ? 256 : encoder->capacity;
+    while(encoder->size + size > capacity) {
+        capacity *= 2;
+    }
+    unsigned char* data = brealloc(encoder->data, capacity);
+    if(data == NULL) {
+        fprintf(stderr, "%s brealloc failed\n", __func__);
+        abort();
+    }
+    encoder->data = data;
+    encoder->capacity = capacity;
+}
+
+static void write_bytes(struct betree_binary_encoder* encoder, const void* bytes, size_t size)
+{
+    reserve_encoder(encoder, size);
+    if(size != 0) {
+        memcpy(encoder->data + encoder->size, bytes, size);
+    }
+    encoder->size += size;
+}
+
+static void write_u32(struct betree_binary_encoder* encoder, uint32_t value)
+{
+    write_bytes(encoder, &value, sizeof(value));
+}
+
+static void write_u64(struct betree_binary_encoder* encoder, uint64_t value)
+{
+    write_bytes(encoder, &value, sizeof(value));
+}
+
+static void write_string(struct betree_binary_encoder* encoder, betree_str_t str, const char* value)
+{
+    size_t size = strlen(value) + 1;
+    write_u64(encoder, str);
+    write_u32(encoder, size);
+    write_bytes(encoder, value, size);
+}
+
+struct betree_binary_encoder* make_binary_encoder()
+{
+    struct betree_binary_encoder* encoder = bcalloc(sizeof(*encoder));
+    if(encoder == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    reset_binary_encoder(encoder);
+    return encoder;
+}
+
+void reset_binary_encoder(struct betree_binary_encoder* encoder)
+{
+    encoder->size = 0;
+    write_u32(encoder, BINARY_EVENT_MAGIC);
+    write_u32(encoder, 0);
+}
+
+void free_binary_encoder(struct betree_binary_encoder* encoder)
+{
+    if(encoder == NULL) {
+        return;
+    }
+    bfree(encoder->data);
+    bfree(encoder);
+}
+
+static size_t begin_entry(
+    struct betree_binary_encoder* encoder, betree_var_t var, enum betree_value_type_e value_type)
+{
+    size_t offset = encoder->size;
+    struct binary_entry_header header = { .var = var, .value_type = value_type };
+    write_bytes(encoder, &header, sizeof(header));
+    return offset;
+}
+
+static void end_entry(struct betree_binary_encoder* encoder, size_t offset)
+{
+    uint32_t size = encoder->size - offset - sizeof(struct binary_entry_header);
+    memcpy(encoder->data + offset + offsetof(struct binary_entry_header, size), &size, sizeof(size));
+    size_t padding = align_entry(encoder->size) - encoder->size;
+    reserve_encoder(encoder, padding);
+    memset(encoder->data + encoder->size, 0, padding);
+    encoder->size += padding;
+    uint32_t count;
+    memcpy(&count, encoder->data + sizeof(uint32_t), sizeof(count));
+    count++;
+    memcpy(encoder->data + sizeof(uint32_t), &count, sizeof(count));
+}
+
+void encode_boolean(struct betree_binary_encoder* encoder, betree_var_t var, bool value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_BOOLEAN);
+    uint8_t byte = value;
+    write_bytes(encoder, &byte, sizeof(byte));
+    end_entry(encoder, offset);
+}
+
+void encode_integer(struct betree_binary_encoder* encoder, betree_var_t var, int64_t value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_INTEGER);
+    write_bytes(encoder, &value, sizeof(value));
+    end_entry(encoder, offset);
+}
+
+void encode_float(struct betree_binary_encoder* encoder, betree_var_t var, double value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_FLOAT);
+    write_bytes(encoder, &value, sizeof(value));
+    end_entry(encoder, offset);
+}
+
+void encode_string(
+    struct betree_binary_encoder* encoder, betree_var_t var, betree_str_t str, const char* value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_STRING);
+    write_string(encoder, str, value);
+    end_entry(encoder, offset);
+}
+
+void encode_integer_enum(
+    struct betree_binary_encoder* encoder, betree_var_t var, betree_ienum_t ienum, int64_t value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_INTEGER_ENUM);
+    write_u64(encoder, ienum);
+    write_bytes(encoder, &value, sizeof(value));
+    end_entry(encoder, offset);
+}
+
+void encode_integer_list(struct betree_binary_encoder* encoder,
+    betree_var_t var,
+    const struct betree_integer_list* value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_INTEGER_LIST);
+    size_t start = encoder->size;
+    write_bytes(encoder, value->integers, value->count * sizeof(*value->integers));
+    // Sorted in place so that the decoder can use the list as is
+    struct betree_integer_list list
+        = { .count = value->count, .integers = (int64_t*)(encoder->data + start) };
+    qsort(list.integers, list.count, sizeof(*list.integers), icmpfunc);
+    size_t unique = 0;
+    for(size_t i = 0; i < list.count; i++) {
+        if(unique == 0 || list.integers[unique - 1] != list.integers[i]) {
+            list.integers[unique] = list.integers[i];
+            unique++;
+        }
+    }
+    encoder->size = start + unique * sizeof(*list.integers);
+    end_entry(encoder, offset);
+}
+
+void encode_string_list(
+    struct betree_binary_encoder* encoder, betree_var_t var, const struct betree_string_list* value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_STRING_LIST);
+    write_u32(encoder, value->count);
+    for(size_t i = 0; i < value->count; i++) {
+        write_string(encoder, INVALID_STR, value->strings[i].string);
+    }
+    end_entry(encoder, offset);
+}
+
+void encode_segments(
+    struct betree_binary_encoder* encoder, betree_var_t var, const struct betree_segments* value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_SEGMENTS);
+    write_bytes(encoder, value->ids, value->size * sizeof(*value->ids));
+    write_bytes(encoder, value->timestamps, value->size * sizeof(*value->timestamps));
+    end_entry(encoder, offset);
+}
+
+void encode_frequency_caps(struct betree_binary_encoder* encoder,
+    betree_var_t var,
+    const struct betree_frequency_caps* value)
+{
+    size_t offset = begin_entry(encoder, var, BETREE_FREQUENCY_CAPS);
+    write_u32(encoder, value->size);
+    for(size_t i = 0; i < value->size; i++) {
+        const struct betree_frequency_cap* cap = value->content[i];
+        write_u32(encoder, cap->type);
+        write_u32(encoder, cap->id);
+        write_bytes(encoder, &cap->timestamp, sizeof(cap->timestamp));
+        write_u32(encoder, cap->value);
+        write_u32(encoder, cap->timestamp_defined);
+        write_string(encoder, INVALID_STR, cap->namespace.string);
+    }
+    end_entry(encoder, offset);
+}
+
+struct binary_reader {
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+};
+
+static const unsigned char* take(struct binary_reader* reader, size_t size)
+{
+    if(size > reader->size - reader->offset) {
+        return NULL;
+    }
+    const unsigned char* bytes = reader->data + reader->offset;
+    reader->offset += size;
+    return bytes;
+}
+
+static bool read_bytes(struct binary_reader* reader, void* out, size_t size)
+{
+    const unsigned char* bytes = take(reader, size);
+    if(bytes == NULL) {
+        return false;
+    }
+    memcpy(out, bytes, size);
+    return true;
+}
+
+static bool read_u32(struct binary_reader* reader, uint32_t* value)
+{
+    return read_bytes(reader, value, sizeof(*value));
+}
+
+static bool read_u64(struct binary_reader* reader, uint64_t* value)
+{
+    return read_bytes(reader, value, sizeof(*value));
+}
+
+static void* allocate_values(size_t size)
+{
+    void* values = arena_malloc(size);
+    if(values == NULL) {
+        fprintf(stderr, "%s arena_malloc failed\n", __func__);
+        abort();
+    }
+    return values;
+}
+
+static bool is_aligned(const void* ptr)
+{
+    return (uintptr_t)ptr % sizeof(int64_t) == 0;
+}
+
+static bool read_string(struct binary_reader* reader,
+    const struct config* config,
+    betree_var_t var,
+    struct string_value* value)
+{
+    uint64_t str;
+    uint32_t size;
+    if(!read_u64(reader, &str) || !read_u32(reader, &size) || size == 0) {
+        return false;
+    }
+    const char* string = (const char*)take(reader, size);
+    if(string == NULL || string[size - 1] != '\0') {
+        return false;
+    }
+    const struct string_map* string_map = get_string_map(config, var);
+    if(str == INVALID_STR) {
+        if(string_map != NULL) {
+            str = find_interned_slice(&string_map->strings, string, size - 1);
+        }
+    }
+    else if(string_map == NULL || str >= string_map->strings.count) {
+        return false;
+    }
+    value->string = string;
+    value->length = size - 1;
+    value->var = var;
+    value->str = str;
+    return true;
+}
+
+static bool read_integer_list(struct binary_reader* reader, struct value* value)
+{
+    size_t size = reader->size - reader->offset;
+    if(size % sizeof(int64_t) != 0) {
+        return false;
+    }
+    const unsigned char* payload = take(reader, size);
+    struct betree_integer_list* list = allocate_values(sizeof(*list));
+    list->count = size / sizeof(int64_t);
+    bool sorted = is_aligned(payload);
+    for(size_t i = 1; sorted && i < list->count; i++) {
+        sorted = ((const int64_t*)payload)[i - 1] < ((const int64_t*)payload)[i];
+    }
+    if(sorted) {
+        list->integers = (int64_t*)payload;
+    }
+    else {
+        list->integers = allocate_values(size + 1);
+        memcpy(list->integers, payload, size);
+        sort_and_remove_duplicate_integer_list(list);
+    }
+    value->integer_list_value = list;
+    return true;
+}
+
+static bool read_string_list(
+    struct binary_reader* reader, const struct config* config, betree_var_t var, struct value* value)
+{
+    uint32_t count;
+    // A string is at least an id, a size and a NUL
+    if(!read_u32(reader, &count) || count > (reader->size - reader->offset) / 13) {
+        return false;
+    }
+    struct betree_string_list* list = allocate_values(sizeof(*list));
+    list->count = count;
+    list->strings = allocate_values(count * sizeof(*list->strings) + 1);
+    for(size_t i = 0; i < count; i++) {
+        if(!read_string(reader, config, var, &list->strings[i])) {
+            return false;
+        }
+    }
+    sort_and_remove_duplicate_string_list(list);
+    value->string_list_value = list;
+    return true;
+}
+
+static bool read_segments(struct binary_reader* reader, struct value* value)
+{
+    size_t size = reader->size - reader->offset;
+    if(size % (2 * sizeof(int64_t)) != 0) {
+        return false;
+    }
+    const unsigned char* payload = take(reader, size);
+    struct betree_segments* segments = allocate_values(sizeof(*segments));
+    segments->size = size / (2 * sizeof(int64_t));
+    const int64_t* ids = (const int64_t*)payload;
+    bool sorted = is_aligned(payload);
+    for(size_t i = 1; sorted && i < segments->size; i++) {
+        sorted = ids[i - 1] <= ids[i];
+    }
+    if(sorted) {
+        segments->ids = (int64_t*)payload;
+    }
+    else {
+        segments->ids = allocate_values(size + 1);
+        memcpy(segments->ids, payload, size);
+    }
+    segments->timestamps = segments->ids + segments->size;
+    if(!sorted) {
+        sort_segments(segments);
+    }
+    value->segments_value = segments;
+    return true;
+}
+
+static bool read_frequency_caps(
+    struct binary_reader* reader, const struct config* config, betree_var_t var, struct value* value)
+{
+    uint32_t count;
+    // Type, id, timestamp, value, timestamp defined and the smallest namespace
+    if(!read_u32(reader, &count) || count > (reader->size - reader->offset) / 37) {
+        return false;
+    }
+    struct betree_frequency_caps* caps = allocate_values(sizeof(*caps));
+    caps->size = count;
+    caps->content = allocate_values(count * sizeof(*caps->content) + 1);
+    caps->slots = NULL;
+    struct betree_frequency_cap* content = allocate_values(count * sizeof(*content) + 1);
+    for(size_t i = 0; i < count; i++) {
+        struct betree_frequency_cap* cap = &content[i];
+        uint32_t type, value_count, timestamp_defined;
+        if(!read_u32(reader, &type) || type > FREQUENCY_TYPE_PRODUCTIP
+            || !read_u32(reader, &cap->id)
+            || !read_bytes(reader, &cap->timestamp, sizeof(cap->timestamp))
+            || !read_u32(reader, &value_count) || !read_u32(reader, &timestamp_defined)
+            || !read_string(reader, config, var, &cap->namespace)) {
+            return false;
+        }
+        cap->type = type;
+        cap->value = value_count;
+        cap->timestamp_defined = timestamp_defined != 0;
+        caps->content[i] = cap;
+    }
+    index_frequency_caps(caps);
+    value->frequency_caps_value = caps;
+    return true;
+}
+
+static bool read_value(
+    struct binary_reader* reader, const struct config* config, betree_var_t var, struct value* value)
+{
+    switch(value->value_type) {
+        case BETREE_BOOLEAN: {
+            uint8_t byte;
+            if(!read_bytes(reader, &byte, sizeof(byte))) {
+                return false;
+            }
+            value->boolean_value = byte != 0;
+            return true;
+        }
+        case BETREE_INTEGER:
+            return read_bytes(reader, &value->integer_value, sizeof(value->integer_value));
+        case BETREE_FLOAT:
+            return read_bytes(reader, &value->float_value, sizeof(value->float_value));
+        case BETREE_STRING:
+            return read_string(reader, config, var, &value->string_value);
+        case BETREE_INTEGER_ENUM: {
+            struct integer_enum_value* ienum = &value->integer_enum_value;
+            if(!read_u64(reader, &ienum->ienum)
+                || !read_bytes(reader, &ienum->integer, sizeof(ienum->integer))) {
+                return false;
+            }
+            ienum->var = var;
+            if(ienum->ienum == INVALID_IENUM) {
+                struct attr_var attr_var = { .attr = NULL, .var = var };
+                ienum->ienum = try_get_id_for_ienum(config, attr_var, ienum->integer);
+            }
+            return true;
+        }
+        case BETREE_INTEGER_LIST:
+            return read_integer_list(reader, value);
+        case BETREE_STRING_LIST:
+            return read_string_list(reader, config, var, value);
+        case BETREE_SEGMENTS:
+            return read_segments(reader, value);
+        case BETREE_FREQUENCY_CAPS:
+            return read_frequency_caps(reader, config, var, value);
+        default:
+            abort();
+    }
+}
+
+static bool read_entry(struct binary_reader* reader, struct betree_bound_event* event)
+{
+    struct binary_entry_header header;
+    if(!read_bytes(reader, &header, sizeof(header))) {
+        return false;
+    }
+    const unsigned char* payload = take(reader, header.size);
+    if(payload == NULL || header.var >= event->variable_count) {
+        return false;
+    }
+    const struct config* config = event->config;
+    const struct attr_domain* attr_domain = config->attr_domains[header.var];
+    if(header.value_type != attr_domain->bound.value_type) {
+        return false;
+    }
+    struct binary_reader entry = { .data = payload, .size = header.size, .offset = 0 };
+    struct betree_variable* variable = &event->variables[header.var];
+    variable->attr_var = attr_domain->attr_var;
+    variable->value.value_type = attr_domain->bound.value_type;
+    if(!read_value(&entry, config, header.var, &variable->value) || entry.offset != entry.size) {
+        return false;
+    }
+    event->preds[header.var] = variable;
+    set_bit(event->defined_vars, header.var);
+    reader->offset = align_entry(reader->offset);
+    return reader->offset <= reader->size;
+}
+
+int binary_event_read_bound(struct betree_bound_event* event, const void* buffer, size_t length)
+{
+    struct binary_reader reader = { .data = buffer, .size = length, .offset = 0 };
+    uint32_t magic, count;
+    if(!read_u32(&reader, &magic) || magic != BINARY_EVENT_MAGIC || !read_u32(&reader, &count)) {
+        return -1;
+    }
+    for(size_t i = 0; i < count; i++) {
+        if(!read_entry(&reader, event)) {
+            return -1;
+        }
+    }
+    return reader.offset == reader.size ? 0 : -1;
+}
+
+struct binary_event_cache {
+    size_t capacity;
+    struct betree_bound_event event;
+};
+
+static __thread struct binary_event_cache binary_event_cache;
+
+struct betree_bound_event* acquire_binary_event(const struct config* config)
+{
+    struct binary_event_cache* cache = &binary_event_cache;
+    size_t count = config->attr_domain_count;
+    if(cache->event.arena == NULL || cache->capacity < count) {
+        free_binary_event_cache();
+        cache->event.variables = bcalloc(count * sizeof(*cache->event.variables) + 1);
+        cache->event.preds = bcalloc(count * sizeof(*cache->event.preds) + 1);
+        cache->event.defined_vars
+            = bcalloc((count / 64 + 1) * sizeof(*cache->event.defined_vars));
+        if(cache->event.variables == NULL || cache->event.preds == NULL
+            || cache->event.defined_vars == NULL) {
+            fprintf(stderr, "%s bcalloc failed\n", __func__);
+            abort();
+        }
+        cache->event.arena = make_event_arena(0);
+        cache->capacity = count;
+    }
+    cache->event.config = config;
+    cache->event.variable_count = count;
+    memset(cache->event.preds, 0, count * sizeof(*cache->event.preds));
+    memset(cache->event.defined_vars, 0, (count / 64 + 1) * sizeof(*cache->event.defined_vars));
+    reset_event_arena(cache->event.arena);
+    return &cache->event;
+}
+
+void free_binary_event_cache()
+{
+    struct binary_event_cache* cache = &binary_event_cache;
+    bfree(cache->event.variables);
+    bfree(cache->event.preds);
+    bfree(cache->event.defined_vars);
+    free_event_arena(cache->event.arena);
+    *cache = (struct binary_event_cache) { 0 };
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "betree.h"
+#include "value.h"
+
+struct betree_bound_event;
+struct config;
+
+/*
+ * Binary event layout, in native byte order:
+ *   u32 magic, u32 entry count, then the entries, each starting on an 8 byte boundary
+ *   entry: u32 variable index, u8 value type, 3 reserved bytes, u32 payload size, u32 reserved
+ * Payloads:
+ *   boolean u8, integer i64, float f64, integer enum u64 ienum then i64
+ *   string: u64 str, u32 size including the NUL, the bytes and the NUL
+ *   integer list: sorted unique i64s, segments: the i64 ids sorted, then their i64 timestamps
+ *   string list: u32 count then strings
+ *   frequency caps: u32 count then per cap u32 type, u32 id, i64 timestamp, u32 value,
+ *   u32 timestamp defined and the namespace string
+ * str and ienum are the ids returned by betree_intern_*, or INVALID_STR/INVALID_IENUM to have the
+ * decoder look them up. The encoder always lets it look up string list and namespace strings.
+ * Strings, sorted integer lists and sorted segments are referenced in place, so the buffer must
+ * outlive the search.
+ */
+#define BINARY_EVENT_MAGIC 0x31455442
+
+struct binary_entry_header {
+    uint32_t var;
+    uint8_t value_type;
+    uint8_t reserved[3];
+    uint32_t size;
+    uint32_t reserved_size;
+};
+
+struct betree_binary_encoder {
+    size_t size;
+    size_t capacity;
+    unsigned char* data;
+};
+
+struct betree_binary_encoder* make_binary_encoder();
+void reset_binary_encoder(struct betree_binary_encoder* encoder);
+void free_binary_encoder(struct betree_binary_encoder* encoder);
+
+void encode_boolean(struct betree_binary_encoder* encoder, betree_var_t var, bool value);
+void encode_integer(struct betree_binary_encoder* encoder, betree_var_t var, int64_t value);
+void encode_float(struct betree_binary_encoder* encoder, betree_var_t var, double value);
+void encode_string(
+    struct betree_binary_encoder* encoder, betree_var_t var, betree_str_t str, const char* value);
+void encode_integer_enum(
+    struct betree_binary_encoder* encoder, betree_var_t var, betree_ienum_t ienum, int64_t value);
+void encode_integer_list(struct betree_binary_encoder* encoder,
+    betree_var_t var,
+    const struct betree_integer_list* value);
+void encode_string_list(
+    struct betree_binary_encoder* encoder, betree_var_t var, const struct betree_string_list* value);
+void encode_segments(
+    struct betree_binary_encoder* encoder, betree_var_t var, const struct betree_segments* value);
+void encode_frequency_caps(struct betree_binary_encoder* encoder,
+    betree_var_t var,
+    const struct betree_frequency_caps* value);
+
+// Fills a cleared bound event, allocating only the list structs from the active arena
+int binary_event_read_bound(struct betree_bound_event* event, const void* buffer, size_t length);
+
+// Thread local bound event reused by betree_search_binary, cleared for config
+struct betree_bound_event* acquire_binary_event(const struct config* config);
+void free_binary_event_cache();
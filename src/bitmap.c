@@ -0,0 +1,285 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "bitmap.h"
+
+#define BITSET_WORDS 1024
+
+struct betree_bitmap* make_bitmap()
+{
+    struct betree_bitmap* bitmap = bcalloc(sizeof(*bitmap));
+    if(bitmap == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    return bitmap;
+}
+
+void clear_bitmap(struct betree_bitmap* bitmap)
+{
+    bitmap->count = 0;
+}
+
+void free_bitmap(struct betree_bitmap* bitmap)
+{
+    if(bitmap == NULL) {
+        return;
+    }
+    for(size_t i = 0; i < bitmap->capacity; i++) {
+        if(bitmap->containers[i].is_bitset) {
+            bfree(bitmap->containers[i].words);
+        }
+        else {
+            bfree(bitmap->containers[i].array);
+        }
+    }
+    bfree(bitmap->containers);
+    bfree(bitmap);
+}
+
+static size_t find_position(const struct betree_bitmap* bitmap, uint16_t key)
+{
+    size_t low = 0, high = bitmap->count;
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+        if(bitmap->containers[middle].key < key) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static struct bitmap_container* get_container(struct betree_bitmap* bitmap, uint16_t key)
+{
+    if(bitmap->count != 0 && bitmap->containers[bitmap->count - 1].key == key) {
+        return &bitmap->containers[bitmap->count - 1];
+    }
+    size_t position = find_position(bitmap, key);
+    if(position < bitmap->count && bitmap->containers[position].key == key) {
+        return &bitmap->containers[position];
+    }
+    if(bitmap->count == bitmap->capacity) {
+        size_t capacity = bitmap->capacity == 0 ? 4 : bitmap->capacity * 2;
+        struct bitmap_container* containers
+            = brealloc(bitmap->containers, capacity * sizeof(*containers));
+        if(containers == NULL) {
+            fprintf(stderr, "%s brealloc failed\n", __func__);
+            abort();
+        }
+        memset(containers + bitmap->capacity,
+            0,
+            (capacity - bitmap->capacity) * sizeof(*containers));
+        bitmap->containers = containers;
+        bitmap->capacity = capacity;
+    }
+    // The slot past the end keeps the buffer of a cleared container, reuse it
+    struct bitmap_container spare = bitmap->containers[bitmap->count];
+    memmove(bitmap->containers + position + 1,
+        bitmap->containers + position,
+        (bitmap->count - position) * sizeof(*bitmap->containers));
+    spare.key = key;
+    spare.cardinality = 0;
+    if(spare.is_bitset) {
+        memset(spare.words, 0, BITSET_WORDS * sizeof(*spare.words));
+    }
+    bitmap->containers[position] = spare;
+    bitmap->count++;
+    return &bitmap->containers[position];
+}
+
+static const struct bitmap_container* find_container(
+    const struct betree_bitmap* bitmap, uint16_t key)
+{
+    size_t position = find_position(bitmap, key);
+    if(position < bitmap->count && bitmap->containers[position].key == key) {
+        return &bitmap->containers[position];
+    }
+    return NULL;
+}
+
+static size_t find_low(const struct bitmap_container* container, uint16_t low)
+{
+    size_t first = 0, last = container->cardinality;
+    while(first < last) {
+        size_t middle = first + (last - first) / 2;
+        if(container->array[middle] < low) {
+            first = middle + 1;
+        }
+        else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+static void convert_to_bitset(struct bitmap_container* container)
+{
+    uint64_t* words = bcalloc(BITSET_WORDS * sizeof(*words));
+    if(words == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    for(size_t i = 0; i < container->cardinality; i++) {
+        words[container->array[i] >> 6] |= 1ULL << (container->array[i] & 63);
+    }
+    bfree(container->array);
+    container->words = words;
+    container->is_bitset = true;
+    container->capacity = 0;
+}
+
+static void container_add(struct bitmap_container* container, uint16_t low)
+{
+    if(!container->is_bitset) {
+        size_t position = container->cardinality == 0
+                || container->array[container->cardinality - 1] < low
+            ? container->cardinality
+            : find_low(container, low);
+        if(position < container->cardinality && container->array[position] == low) {
+            return;
+        }
+        if(container->cardinality < ARRAY_CONTAINER_MAX
+            && container->cardinality - position <= ARRAY_CONTAINER_SHIFT_MAX) {
+            if(container->cardinality == container->capacity) {
+                uint32_t capacity = container->capacity == 0 ? 4 : container->capacity * 2;
+                uint16_t* array = brealloc(container->array, capacity * sizeof(*array));
+                if(array == NULL) {
+                    fprintf(stderr, "%s brealloc failed\n", __func__);
+                    abort();
+                }
+                container->array = array;
+                container->capacity = capacity;
+            }
+            memmove(container->array + position + 1,
+                container->array + position,
+                (container->cardinality - position) * sizeof(*container->array));
+            container->array[position] = low;
+            container->cardinality++;
+            return;
+        }
+        convert_to_bitset(container);
+    }
+    uint64_t bit = 1ULL << (low & 63);
+    if((container->words[low >> 6] & bit) == 0) {
+        container->words[low >> 6] |= bit;
+        container->cardinality++;
+    }
+}
+
+void bitmap_add(struct betree_bitmap* bitmap, uint32_t index)
+{
+    container_add(get_container(bitmap, index >> 16), index & 0xFFFF);
+}
+
+// low and high are both included
+static void container_add_range(struct bitmap_container* container, uint32_t low, uint32_t high)
+{
+    if(!container->is_bitset && high - low < 64) {
+        for(uint32_t value = low; value <= high; value++) {
+            container_add(container, value);
+        }
+        return;
+    }
+    if(!container->is_bitset) {
+        convert_to_bitset(container);
+    }
+    for(uint32_t word = low >> 6; word <= high >> 6; word++) {
+        uint64_t mask = ~0ULL;
+        if(word == low >> 6) {
+            mask &= ~0ULL << (low & 63);
+        }
+        if(word == high >> 6) {
+            mask &= ~0ULL >> (63 - (high & 63));
+        }
+        container->cardinality += __builtin_popcountll(mask & ~container->words[word]);
+        container->words[word] |= mask;
+    }
+}
+
+void bitmap_add_range(struct betree_bitmap* bitmap, uint32_t begin, uint32_t end)
+{
+    while(begin < end) {
+        uint32_t last = begin | 0xFFFF;
+        if(end - 1 < last) {
+            last = end - 1;
+        }
+        container_add_range(get_container(bitmap, begin >> 16), begin & 0xFFFF, last & 0xFFFF);
+        if(last == end - 1) {
+            return;
+        }
+        begin = last + 1;
+    }
+}
+
+bool bitmap_contains(const struct betree_bitmap* bitmap, uint32_t index)
+{
+    const struct bitmap_container* container = find_container(bitmap, index >> 16);
+    if(container == NULL) {
+        return false;
+    }
+    uint16_t low = index & 0xFFFF;
+    if(container->is_bitset) {
+        return (container->words[low >> 6] >> (low & 63)) & 1;
+    }
+    size_t position = find_low(container, low);
+    return position < container->cardinality && container->array[position] == low;
+}
+
+size_t bitmap_cardinality(const struct betree_bitmap* bitmap)
+{
+    size_t cardinality = 0;
+    for(size_t i = 0; i < bitmap->count; i++) {
+        cardinality += bitmap->containers[i].cardinality;
+    }
+    return cardinality;
+}
+
+void bitmap_or(struct betree_bitmap* dst, const struct betree_bitmap* src)
+{
+    for(size_t i = 0; i < src->count; i++) {
+        const struct bitmap_container* from = &src->containers[i];
+        struct bitmap_container* to = get_container(dst, from->key);
+        if(!from->is_bitset) {
+            for(size_t j = 0; j < from->cardinality; j++) {
+                container_add(to, from->array[j]);
+            }
+            continue;
+        }
+        if(!to->is_bitset) {
+            convert_to_bitset(to);
+        }
+        uint32_t cardinality = 0;
+        for(size_t j = 0; j < BITSET_WORDS; j++) {
+            to->words[j] |= from->words[j];
+            cardinality += __builtin_popcountll(to->words[j]);
+        }
+        to->cardinality = cardinality;
+    }
+}
+
+void bitmap_to_array(const struct betree_bitmap* bitmap, uint32_t* out)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < bitmap->count; i++) {
+        const struct bitmap_container* container = &bitmap->containers[i];
+        uint32_t high = (uint32_t)container->key << 16;
+        if(!container->is_bitset) {
+            for(size_t j = 0; j < container->cardinality; j++) {
+                out[count++] = high | container->array[j];
+            }
+            continue;
+        }
+        for(size_t j = 0; j < BITSET_WORDS; j++) {
+            uint64_t word = container->words[j];
+            while(word != 0) {
+                out[count++] = high | (uint32_t)(j * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Roaring style bitmap over 32 bit indices: one container per 2^16 values, holding a sorted array
+ * of the low halves until it reaches ARRAY_CONTAINER_MAX of them, then a 2^16 bit set. Subs are
+ * reported in tree order rather than index order, so an insert that would shift more than
+ * ARRAY_CONTAINER_SHIFT_MAX values switches to the bit set early. Clearing keeps the containers'
+ * buffers for the next use.
+ */
+#define ARRAY_CONTAINER_MAX 4096
+#define ARRAY_CONTAINER_SHIFT_MAX 256
+
+struct bitmap_container {
+    uint16_t key;
+    bool is_bitset;
+    uint32_t cardinality;
+    uint32_t capacity;
+    union {
+        uint16_t* array;
+        uint64_t* words;
+    };
+};
+
+struct betree_bitmap {
+    size_t count;
+    size_t capacity;
+    struct bitmap_container* containers;
+};
+
+struct betree_bitmap* make_bitmap();
+void clear_bitmap(struct betree_bitmap* bitmap);
+void free_bitmap(struct betree_bitmap* bitmap);
+
+void bitmap_add(struct betree_bitmap* bitmap, uint32_t index);
+// Adds [begin, end)
+void bitmap_add_range(struct betree_bitmap* bitmap, uint32_t begin, uint32_t end);
+bool bitmap_contains(const struct betree_bitmap* bitmap, uint32_t index);
+size_t bitmap_cardinality(const struct betree_bitmap* bitmap);
+// dst |= src
+void bitmap_or(struct betree_bitmap* dst, const struct betree_bitmap* src);
+// Writes the indices in increasing order, out holds bitmap_cardinality of them
+void bitmap_to_array(const struct betree_bitmap* bitmap, uint32_t* out);
@@ -3,6 +3,7 @@
 #include "alloc.h"
 #include "ast.h"
 #include "clone.h"
+#include "special.h"
 #include "utils.h"
 
 static struct attr_var clone_attr_var(struct attr_var orig)
@@ -40,7 +41,8 @@ static struct ast_node* clone_compare(betree_pred_t global_id, betree_pred_t mem
 
 static struct string_value clone_string_value(struct string_value orig)
 {
-    struct string_value clone = { .string = bstrdup(orig.string), .var = orig.var, .str = orig.str };
+    struct string_value clone
+        = { .string = bstrdup(orig.string), .length = orig.length, .var = orig.var, .str = orig.str };
     return clone;
 }
 
@@ -236,11 +238,13 @@ static struct ast_node* clone_special(betree_pred_t global_id, betree_pred_t mem
             clone->special_expr.geo.longitude = orig.geo.longitude;
             clone->special_expr.geo.op = orig.geo.op;
             clone->special_expr.geo.radius = orig.geo.radius;
+            init_geo_circle(&clone->special_expr.geo);
             break;
         case AST_SPECIAL_STRING:
             clone->special_expr.string.attr_var = clone_attr_var(orig.string.attr_var);
             clone->special_expr.string.op = orig.string.op;
             clone->special_expr.string.pattern = bstrdup(orig.string.pattern);
+            clone->special_expr.string.pattern_length = orig.string.pattern_length;
             break;
         default: abort();
     }
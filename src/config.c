@@ -1,3 +1,4 @@
+#include <ctype.h>
 #include <float.h>
 #include <stdio.h>
 #include <string.h>
@@ -7,8 +8,11 @@
 #include "error.h"
 #include "hashmap.h"
 #include "memoize.h"
+#include "slab.h"
 #include "utils.h"
 
+static const size_t STRING_RESERVE_MAX = 65536;
+
 struct config* make_config(uint8_t lnode_max_cap, uint8_t partition_min_size)
 {
     struct config* config = bcalloc(sizeof(*config));
@@ -24,14 +28,41 @@ struct config* make_config(uint8_t lnode_max_cap, uint8_t partition_min_size)
     config->string_map_count = 0;
     config->string_maps = NULL;
     config->pred_map = make_pred_map();
+    config->node_slab = make_node_slab(&default_allocator);
+    config->pred_map->slab = config->node_slab;
+    config->sub_ranges_version = UINT64_MAX;
     return config;
 }
 
+void use_config_allocator(struct config* config, const struct betree_allocator* allocator)
+{
+    free_node_slab(config->node_slab);
+    config->node_slab = make_node_slab(allocator);
+    config->pred_map->slab = config->node_slab;
+}
+
 struct config* make_default_config()
 {
     return make_config(3, 0);
 }
 
+uint32_t add_sub_index(struct config* config, uint64_t id)
+{
+    if(config->sub_count == config->sub_capacity) {
+        size_t capacity = config->sub_capacity == 0 ? 16 : config->sub_capacity * 2;
+        uint64_t* sub_ids
+            = slab_realloc(config->node_slab, config->sub_ids, capacity * sizeof(*sub_ids));
+        if(sub_ids == NULL) {
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
+            abort();
+        }
+        config->sub_ids = sub_ids;
+        config->sub_capacity = capacity;
+    }
+    config->sub_ids[config->sub_count] = id;
+    return config->sub_count++;
+}
+
 void free_config(struct config* config)
 {
     if(config == NULL) {
@@ -39,73 +70,233 @@ void free_config(struct config* config)
     }
     if(config->attr_domains != NULL) {
         for(size_t i = 0; i < config->attr_domain_count; i++) {
-            bfree((char*)config->attr_domains[i]->attr_var.attr);
-            bfree(config->attr_domains[i]);
+            slab_free((char*)config->attr_domains[i]->attr_var.attr);
+            slab_free(config->attr_domains[i]);
         }
-        bfree(config->attr_domains);
+        slab_free(config->attr_domains);
         config->attr_domains = NULL;
     }
+    slab_free(config->attr_index);
+    config->attr_index = NULL;
+    slab_free(config->string_map_by_var);
+    config->string_map_by_var = NULL;
+    slab_free(config->integer_map_by_var);
+    config->integer_map_by_var = NULL;
+    slab_free(config->required_vars);
+    config->required_vars = NULL;
+    slab_free(config->sub_ids);
+    config->sub_ids = NULL;
     if(config->integer_maps != NULL) {
         for(size_t i = 0; i < config->integer_map_count; i++) {
-            bfree((char*)config->integer_maps[i].attr_var.attr);
-            bfree(config->integer_maps[i].integer_values);
+            slab_free((char*)config->integer_maps[i].attr_var.attr);
+            slab_free(config->integer_maps[i].integer_values);
+            slab_free(config->integer_maps[i].integer_index);
         }
-        bfree(config->integer_maps);
+        slab_free(config->integer_maps);
         config->integer_maps = NULL;
     }
     if(config->string_maps != NULL) {
         for(size_t i = 0; i < config->string_map_count; i++) {
-            bfree((char*)config->string_maps[i].attr_var.attr);
-            map_deinit(&config->string_maps[i].m);
+            slab_free((char*)config->string_maps[i].attr_var.attr);
+            deinit_string_interner(&config->string_maps[i].strings);
         }
-        bfree(config->string_maps);
+        slab_free(config->string_maps);
         config->string_maps = NULL;
     }
     if(config->pred_map != NULL) {
         free_pred_map(config->pred_map);
         config->pred_map = NULL;
     }
+    free_node_slab(config->node_slab);
+    config->node_slab = NULL;
     bfree(config);
 }
 
-static struct attr_domain* make_attr_domain(
-    const char* attr, betree_var_t variable_id, struct value_bound bound, bool allow_undefined)
+static struct attr_domain* make_attr_domain(struct node_slab* slab,
+    const char* attr,
+    betree_var_t variable_id,
+    struct value_bound bound,
+    bool allow_undefined)
 {
-    struct attr_domain* attr_domain = bcalloc(sizeof(*attr_domain));
+    struct attr_domain* attr_domain = slab_zalloc(slab, sizeof(*attr_domain));
     if(attr_domain == NULL) {
-        fprintf(stderr, "%s bcalloc faild\n", __func__);
+        fprintf(stderr, "%s slab_zalloc faild\n", __func__);
         abort();
     }
-    attr_domain->attr_var.attr = bstrdup(attr);
+    attr_domain->attr_var.attr = slab_strdup(slab, attr);
     attr_domain->attr_var.var = variable_id;
     attr_domain->bound = bound;
     attr_domain->allow_undefined = allow_undefined;
     return attr_domain;
 }
 
+// Attribute names are looked up case-folded: the index hashes the lowercased name, FNV-1a
+static uint64_t hash_attr(const char* attr, size_t* length)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    size_t i = 0;
+    for(; attr[i]; i++) {
+        hash ^= (unsigned char)tolower((unsigned char)attr[i]);
+        hash *= 0x100000001B3ULL;
+    }
+    *length = i;
+    return hash;
+}
+
+static uint64_t hash_attr_slice(const char* attr, size_t length)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for(size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)tolower((unsigned char)attr[i]);
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static bool is_attr(const char* domain_attr, const char* attr, size_t length)
+{
+    for(size_t i = 0; i < length; i++) {
+        if(domain_attr[i] != tolower((unsigned char)attr[i])) {
+            return false;
+        }
+    }
+    return domain_attr[length] == '\0';
+}
+
+static void index_attr_domain(struct config* config, betree_var_t var)
+{
+    size_t length;
+    uint64_t hash = hash_attr(config->attr_domains[var]->attr_var.attr, &length);
+    size_t mask = config->attr_index_capacity - 1;
+    for(size_t i = hash & mask;; i = (i + 1) & mask) {
+        betree_var_t found = config->attr_index[i];
+        if(found == INVALID_VAR) {
+            config->attr_index[i] = var;
+            return;
+        }
+        if(strcmp(config->attr_domains[found]->attr_var.attr,
+               config->attr_domains[var]->attr_var.attr)
+            == 0) {
+            return;
+        }
+    }
+}
+
+static void grow_attr_index(struct config* config)
+{
+    size_t capacity = config->attr_index_capacity == 0 ? 16 : config->attr_index_capacity * 2;
+    betree_var_t* attr_index = slab_malloc(config->node_slab, capacity * sizeof(*attr_index));
+    if(attr_index == NULL) {
+        fprintf(stderr, "%s slab_malloc failed\n", __func__);
+        abort();
+    }
+    for(size_t i = 0; i < capacity; i++) {
+        attr_index[i] = INVALID_VAR;
+    }
+    slab_free(config->attr_index);
+    config->attr_index = attr_index;
+    config->attr_index_capacity = capacity;
+    for(size_t i = 0; i < config->attr_domain_count; i++) {
+        index_attr_domain(config, i);
+    }
+}
+
+betree_var_t try_get_id_for_attr(const struct config* config, const char* attr)
+{
+    if(config->attr_index_capacity == 0) {
+        return INVALID_VAR;
+    }
+    size_t length;
+    uint64_t hash = hash_attr(attr, &length);
+    size_t mask = config->attr_index_capacity - 1;
+    for(size_t i = hash & mask;; i = (i + 1) & mask) {
+        betree_var_t var = config->attr_index[i];
+        if(var == INVALID_VAR) {
+            return INVALID_VAR;
+        }
+        if(is_attr(config->attr_domains[var]->attr_var.attr, attr, length)) {
+            return var;
+        }
+    }
+}
+
+betree_var_t try_get_id_for_attr_slice(const struct config* config, const char* attr, size_t length)
+{
+    if(config->attr_index_capacity == 0) {
+        return INVALID_VAR;
+    }
+    uint64_t hash = hash_attr_slice(attr, length);
+    size_t mask = config->attr_index_capacity - 1;
+    for(size_t i = hash & mask;; i = (i + 1) & mask) {
+        betree_var_t var = config->attr_index[i];
+        if(var == INVALID_VAR) {
+            return INVALID_VAR;
+        }
+        if(is_attr(config->attr_domains[var]->attr_var.attr, attr, length)) {
+            return var;
+        }
+    }
+}
+
 static void add_attr_domain(
     struct config* config, const char* attr, struct value_bound bound, bool allow_undefined)
 {
     betree_var_t variable_id = config->attr_domain_count;
-    struct attr_domain* attr_domain = make_attr_domain(attr, variable_id, bound, allow_undefined);
+    struct attr_domain* attr_domain
+        = make_attr_domain(config->node_slab, attr, variable_id, bound, allow_undefined);
     if(config->attr_domain_count == 0) {
-        config->attr_domains = bcalloc(sizeof(*config->attr_domains));
+        config->attr_domains = slab_zalloc(config->node_slab, sizeof(*config->attr_domains));
         if(config->attr_domains == NULL) {
-            fprintf(stderr, "%s bcalloc failed\n", __func__);
+            fprintf(stderr, "%s slab_zalloc failed\n", __func__);
             abort();
         }
     }
     else {
-        struct attr_domain** attr_domains = brealloc(
-            config->attr_domains, sizeof(*attr_domains) * (config->attr_domain_count + 1));
+        struct attr_domain** attr_domains = slab_realloc(config->node_slab,
+            config->attr_domains,
+            sizeof(*attr_domains) * (config->attr_domain_count + 1));
         if(attr_domains == NULL) {
-            fprintf(stderr, "%s brealloc failed\n", __func__);
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
             abort();
         }
         config->attr_domains = attr_domains;
     }
     config->attr_domains[config->attr_domain_count] = attr_domain;
     config->attr_domain_count++;
+    size_t* string_map_by_var = slab_realloc(config->node_slab,
+        config->string_map_by_var,
+        sizeof(*string_map_by_var) * config->attr_domain_count);
+    size_t* integer_map_by_var = slab_realloc(config->node_slab,
+        config->integer_map_by_var,
+        sizeof(*integer_map_by_var) * config->attr_domain_count);
+    if(string_map_by_var == NULL || integer_map_by_var == NULL) {
+        fprintf(stderr, "%s slab_realloc failed\n", __func__);
+        abort();
+    }
+    string_map_by_var[variable_id] = SIZE_MAX;
+    integer_map_by_var[variable_id] = SIZE_MAX;
+    config->string_map_by_var = string_map_by_var;
+    config->integer_map_by_var = integer_map_by_var;
+    if(variable_id % 64 == 0) {
+        uint64_t* required_vars = slab_realloc(config->node_slab,
+            config->required_vars,
+            sizeof(*required_vars) * (variable_id / 64 + 1));
+        if(required_vars == NULL) {
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
+            abort();
+        }
+        required_vars[variable_id / 64] = 0;
+        config->required_vars = required_vars;
+    }
+    if(!allow_undefined) {
+        set_bit(config->required_vars, variable_id);
+    }
+    if(config->attr_domain_count * 2 > config->attr_index_capacity) {
+        grow_attr_index(config);
+    }
+    else {
+        index_attr_domain(config, variable_id);
+    }
 }
 
 void add_attr_domain_bounded_i(
@@ -188,7 +379,13 @@ void add_attr_domain_bounded_sl(
 
 void add_attr_domain_segments(struct config* config, const char* attr, bool allow_undefined)
 {
-    struct value_bound bound = { .value_type = BETREE_SEGMENTS };
+    add_attr_domain_bounded_segments(config, attr, allow_undefined, INT64_MIN, INT64_MAX);
+}
+
+void add_attr_domain_bounded_segments(
+    struct config* config, const char* attr, bool allow_undefined, int64_t min, int64_t max)
+{
+    struct value_bound bound = { .value_type = BETREE_SEGMENTS, .imin = min, .imax = max };
     add_attr_domain(config, attr, bound, allow_undefined);
 }
 
@@ -207,131 +404,216 @@ const struct attr_domain* get_attr_domain(
 static void add_integer_map(struct attr_var attr_var, struct config* config)
 {
     if(config->integer_map_count == 0) {
-        config->integer_maps = bcalloc(sizeof(*config->integer_maps));
+        config->integer_maps = slab_zalloc(config->node_slab, sizeof(*config->integer_maps));
         if(config->integer_maps == NULL) {
-            fprintf(stderr, "%s bcalloc failed\n", __func__);
+            fprintf(stderr, "%s slab_zalloc failed\n", __func__);
             abort();
         }
     }
     else {
-        struct integer_map* integer_maps
-            = brealloc(config->integer_maps, sizeof(*integer_maps) * (config->integer_map_count + 1));
+        struct integer_map* integer_maps = slab_realloc(config->node_slab,
+            config->integer_maps,
+            sizeof(*integer_maps) * (config->integer_map_count + 1));
         if(integer_maps == NULL) {
-            fprintf(stderr, "%s brealloc failed\n", __func__);
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
             abort();
         }
         config->integer_maps = integer_maps;
     }
-    config->integer_maps[config->integer_map_count].attr_var.attr = bstrdup(attr_var.attr);
+    config->integer_maps[config->integer_map_count].attr_var.attr
+        = slab_strdup(config->node_slab, attr_var.attr);
     config->integer_maps[config->integer_map_count].attr_var.var = attr_var.var;
     config->integer_maps[config->integer_map_count].integer_value_count = 0;
     config->integer_maps[config->integer_map_count].integer_values = 0;
+    config->integer_maps[config->integer_map_count].integer_index_capacity = 0;
+    config->integer_maps[config->integer_map_count].integer_index = NULL;
+    config->integer_map_by_var[attr_var.var] = config->integer_map_count;
     config->integer_map_count++;
 }
 
 static void add_string_map(struct attr_var attr_var, struct config* config)
 {
     if(config->string_map_count == 0) {
-        config->string_maps = bcalloc(sizeof(*config->string_maps));
+        config->string_maps = slab_zalloc(config->node_slab, sizeof(*config->string_maps));
         if(config->string_maps == NULL) {
-            fprintf(stderr, "%s bcalloc failed\n", __func__);
+            fprintf(stderr, "%s slab_zalloc failed\n", __func__);
             abort();
         }
     }
     else {
-        struct string_map* string_maps
-            = brealloc(config->string_maps, sizeof(*string_maps) * (config->string_map_count + 1));
+        struct string_map* string_maps = slab_realloc(config->node_slab,
+            config->string_maps,
+            sizeof(*string_maps) * (config->string_map_count + 1));
         if(string_maps == NULL) {
-            fprintf(stderr, "%s brealloc failed\n", __func__);
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
             abort();
         }
         config->string_maps = string_maps;
     }
-    config->string_maps[config->string_map_count].attr_var.attr = bstrdup(attr_var.attr);
+    config->string_maps[config->string_map_count].attr_var.attr
+        = slab_strdup(config->node_slab, attr_var.attr);
     config->string_maps[config->string_map_count].attr_var.var = attr_var.var;
     config->string_maps[config->string_map_count].string_value_count = 0;
+    init_string_interner(&config->string_maps[config->string_map_count].strings);
+    config->string_maps[config->string_map_count].strings.slab = config->node_slab;
+    const struct attr_domain* attr_domain = config->attr_domains[attr_var.var];
+    bool is_string = attr_domain->bound.value_type == BETREE_STRING
+        || attr_domain->bound.value_type == BETREE_STRING_LIST;
+    if(is_string && attr_domain->bound.smax < STRING_RESERVE_MAX) {
+        reserve_string_interner(
+            &config->string_maps[config->string_map_count].strings, attr_domain->bound.smax + 1);
+    }
+    config->string_map_by_var[attr_var.var] = config->string_map_count;
     config->string_map_count++;
 }
 
-static void add_to_integer_map(struct integer_map* integer_map, int64_t integer)
+static size_t hash_integer(int64_t integer)
+{
+    uint64_t hash = (uint64_t)integer;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static void index_integer(struct integer_map* integer_map, betree_ienum_t ienum)
+{
+    size_t mask = integer_map->integer_index_capacity - 1;
+    size_t i = hash_integer(integer_map->integer_values[ienum]) & mask;
+    while(integer_map->integer_index[i] != INVALID_IENUM) {
+        i = (i + 1) & mask;
+    }
+    integer_map->integer_index[i] = ienum;
+}
+
+static void grow_integer_index(struct node_slab* slab, struct integer_map* integer_map)
+{
+    size_t capacity
+        = integer_map->integer_index_capacity == 0 ? 16 : integer_map->integer_index_capacity * 2;
+    betree_ienum_t* integer_index = slab_malloc(slab, capacity * sizeof(*integer_index));
+    if(integer_index == NULL) {
+        fprintf(stderr, "%s slab_malloc failed\n", __func__);
+        abort();
+    }
+    for(size_t i = 0; i < capacity; i++) {
+        integer_index[i] = INVALID_IENUM;
+    }
+    slab_free(integer_map->integer_index);
+    integer_map->integer_index = integer_index;
+    integer_map->integer_index_capacity = capacity;
+    for(size_t i = 0; i < integer_map->integer_value_count; i++) {
+        index_integer(integer_map, i);
+    }
+}
+
+static betree_ienum_t find_integer(const struct integer_map* integer_map, int64_t integer)
+{
+    if(integer_map->integer_index_capacity == 0) {
+        return INVALID_IENUM;
+    }
+    size_t mask = integer_map->integer_index_capacity - 1;
+    for(size_t i = hash_integer(integer) & mask;; i = (i + 1) & mask) {
+        betree_ienum_t ienum = integer_map->integer_index[i];
+        if(ienum == INVALID_IENUM || integer_map->integer_values[ienum] == integer) {
+            return ienum;
+        }
+    }
+}
+
+static void add_to_integer_map(
+    struct node_slab* slab, struct integer_map* integer_map, int64_t integer)
 {
     if(integer_map->integer_value_count == 0) {
-        integer_map->integer_values = bcalloc(sizeof(*integer_map->integer_values));
+        integer_map->integer_values = slab_zalloc(slab, sizeof(*integer_map->integer_values));
         if(integer_map->integer_values == NULL) {
-            fprintf(stderr, "%s bcalloc failed\n", __func__);
+            fprintf(stderr, "%s slab_zalloc failed\n", __func__);
             abort();
         }
     }
     else {
-        int64_t* integer_values = brealloc(integer_map->integer_values,
+        int64_t* integer_values = slab_realloc(slab,
+            integer_map->integer_values,
             sizeof(*integer_values) * (integer_map->integer_value_count + 1));
         if(integer_values == NULL) {
-            fprintf(stderr, "%s brealloc failed\n", __func__);
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
             abort();
         }
         integer_map->integer_values = integer_values;
     }
     integer_map->integer_values[integer_map->integer_value_count] = integer;
     integer_map->integer_value_count++;
+    if(integer_map->integer_value_count * 2 > integer_map->integer_index_capacity) {
+        grow_integer_index(slab, integer_map);
+    }
+    else {
+        index_integer(integer_map, integer_map->integer_value_count - 1);
+    }
 }
 
 static void add_to_string_map(struct string_map* string_map, const char* string)
 {
-    if(string_map->string_value_count == 0) {
-        map_init(&string_map->m);
-    }
-    map_set(&string_map->m, string, string_map->string_value_count);
+    intern_string(&string_map->strings, string);
     string_map->string_value_count++;
 }
 
+void reserve_string_values(struct config* config, struct attr_var attr_var, size_t count)
+{
+    struct string_map* string_map = get_string_map(config, attr_var.var);
+    if(string_map == NULL) {
+        add_string_map(attr_var, config);
+        string_map = &config->string_maps[config->string_map_count - 1];
+    }
+    reserve_string_interner(&string_map->strings, count);
+}
+
+struct string_map* get_string_map(const struct config* config, betree_var_t variable_id)
+{
+    if(variable_id >= config->attr_domain_count) {
+        return NULL;
+    }
+    size_t index = config->string_map_by_var[variable_id];
+    return index == SIZE_MAX ? NULL : &config->string_maps[index];
+}
+
+struct integer_map* get_integer_map(const struct config* config, betree_var_t variable_id)
+{
+    if(variable_id >= config->attr_domain_count) {
+        return NULL;
+    }
+    size_t index = config->integer_map_by_var[variable_id];
+    return index == SIZE_MAX ? NULL : &config->integer_maps[index];
+}
+
 betree_ienum_t try_get_id_for_ienum(
     const struct config* config, struct attr_var attr_var, int64_t integer)
 {
-    for(size_t i = 0; i < config->integer_map_count; i++) {
-        if(config->integer_maps[i].attr_var.var == attr_var.var) {
-            struct integer_map* integer_map = integer_map = &config->integer_maps[i];
-            for(size_t j = 0; j < integer_map->integer_value_count; j++) {
-                if(integer_map->integer_values[j] == integer) {
-                    return j;
-                }
-            }
-            break;
-        }
+    const struct integer_map* integer_map = get_integer_map(config, attr_var.var);
+    if(integer_map == NULL) {
+        return INVALID_IENUM;
     }
-    return INVALID_IENUM;
+    return find_integer(integer_map, integer);
 }
 
 betree_str_t try_get_id_for_string(
     const struct config* config, struct attr_var attr_var, const char* string)
 {
-    for(size_t i = 0; i < config->string_map_count; i++) {
-        if(config->string_maps[i].attr_var.var == attr_var.var) {
-            struct string_map* string_map = string_map = &config->string_maps[i];
-            betree_str_t* str = map_get(&string_map->m, string);
-            if(str != NULL) {
-                return *str;
-            }
-            break;
-        }
+    struct string_map* string_map = get_string_map(config, attr_var.var);
+    if(string_map == NULL) {
+        return INVALID_STR;
     }
-    return INVALID_STR;
+    return find_interned_string(&string_map->strings, string);
 }
 
 betree_ienum_t get_id_for_ienum(struct config* config, struct attr_var attr_var, int64_t integer, bool always_assign)
 {
-    struct integer_map* integer_map = NULL;
-    for(size_t i = 0; i < config->integer_map_count; i++) {
-        if(config->integer_maps[i].attr_var.var == attr_var.var) {
-            integer_map = &config->integer_maps[i];
-            for(size_t j = 0; j < integer_map->integer_value_count; j++) {
-                if(integer_map->integer_values[j] == integer) {
-                    return j;
-                }
-            }
-            break;
+    struct integer_map* integer_map = get_integer_map(config, attr_var.var);
+    if(integer_map != NULL) {
+        betree_ienum_t ienum = find_integer(integer_map, integer);
+        if(ienum != INVALID_IENUM) {
+            return ienum;
         }
     }
-    if(integer_map == NULL) {
+    else {
         add_integer_map(attr_var, config);
         integer_map = &config->integer_maps[config->integer_map_count - 1];
     }
@@ -340,24 +622,20 @@ betree_ienum_t get_id_for_ienum(struct config* config, struct attr_var attr_var,
     if(!always_assign && attr_domain->bound.smax + 1 == integer_map->integer_value_count) {
         return INVALID_IENUM;
     }
-    add_to_integer_map(integer_map, integer);
+    add_to_integer_map(config->node_slab, integer_map, integer);
     return integer_map->integer_value_count - 1;
 }
 
 betree_str_t get_id_for_string(struct config* config, struct attr_var attr_var, const char* string, bool always_assign)
 {
-    struct string_map* string_map = NULL;
-    for(size_t i = 0; i < config->string_map_count; i++) {
-        if(config->string_maps[i].attr_var.var == attr_var.var) {
-            string_map = &config->string_maps[i];
-            betree_str_t* str = map_get(&string_map->m, string);
-            if(str != NULL) {
-                return *str;
-            }
-            break;
+    struct string_map* string_map = get_string_map(config, attr_var.var);
+    if(string_map != NULL) {
+        betree_str_t str = find_interned_string(&string_map->strings, string);
+        if(str != INVALID_STR) {
+            return str;
         }
     }
-    if(string_map == NULL) {
+    else {
         add_string_map(attr_var, config);
         string_map = &config->string_maps[config->string_map_count - 1];
     }
@@ -5,7 +5,7 @@
 #include <stddef.h>
 
 #include "config.h"
-#include "map.h"
+#include "interner.h"
 #include "var.h"
 
 struct attr_domain {
@@ -15,14 +15,14 @@ struct attr_domain {
 };
 
 struct ast_node;
+struct betree_allocator;
+struct node_slab;
 struct pred_map;
 
-typedef map_t(betree_str_t) str_map_t;
-
 struct string_map {
     struct attr_var attr_var;
     size_t string_value_count;
-    str_map_t m;
+    struct string_interner strings;
 };
 
 struct integer_map {
@@ -31,11 +31,19 @@ struct integer_map {
         size_t integer_value_count;
         int64_t* integer_values;
     };
+    struct {
+        size_t integer_index_capacity;
+        betree_ienum_t* integer_index;
+    };
 };
 
 struct config* make_config(uint8_t lnode_max_cap, uint8_t partition_min_size);
 struct config* make_default_config();
+// Only before any node is allocated for this config
+void use_config_allocator(struct config* config, const struct betree_allocator* allocator);
 void free_config(struct config* config);
+// Gives the sub the next dense index
+uint32_t add_sub_index(struct config* config, uint64_t id);
 
 struct config {
     uint8_t lnode_max_cap;
@@ -45,6 +53,10 @@ struct config {
         size_t attr_domain_count;
         struct attr_domain** attr_domains;
     };
+    struct {
+        size_t attr_index_capacity;
+        betree_var_t* attr_index;
+    };
     struct {
         size_t string_map_count;
         struct string_map* string_maps;
@@ -53,7 +65,22 @@ struct config {
         size_t integer_map_count;
         struct integer_map* integer_maps;
     };
+    // Position in string_maps/integer_maps for each variable, SIZE_MAX if none
+    size_t* string_map_by_var;
+    size_t* integer_map_by_var;
+    // Bit per variable that an event has to define
+    uint64_t* required_vars;
+    // Id of each sub by dense index, in creation order
+    size_t sub_count;
+    size_t sub_capacity;
+    uint64_t* sub_ids;
+    // version when number_subs last ran, the cdir sub ranges are valid while it is current
+    uint64_t sub_ranges_version;
+    // Reason aggregators made on this config, the subs are not renumbered while there are any
+    size_t reason_aggregator_count;
     struct pred_map* pred_map;
+    struct node_slab* node_slab;
+    uint64_t version;
 };
 
 void add_attr_domain_i(struct config* config, const char* attr, bool allow_undefined);
@@ -71,12 +98,17 @@ void add_attr_domain_bounded_f(struct config* config, const char* attr, bool all
 void add_attr_domain_bounded_s(struct config* config, const char* attr, bool allow_undefined, size_t max);
 void add_attr_domain_bounded_il(struct config* config, const char* attr, bool allow_undefined, int64_t min, int64_t max);
 void add_attr_domain_bounded_sl(struct config* config, const char* attr, bool allow_undefined, size_t max);
+void add_attr_domain_bounded_segments(struct config* config, const char* attr, bool allow_undefined, int64_t min, int64_t max);
 void add_attr_domain_bounded_ie(struct config* config, const char* attr, bool allow_undefined, size_t max);
 const struct attr_domain* get_attr_domain(const struct attr_domain** attr_domains, betree_var_t variable_id);
 bool is_variable_allow_undefined(const struct config* config, const betree_var_t variable_id);
 
 const char* get_attr_for_id(const struct config* config, betree_var_t variable_id);
 betree_var_t try_get_id_for_attr(const struct config* config, const char* attr);
+betree_var_t try_get_id_for_attr_slice(const struct config* config, const char* attr, size_t length);
+struct string_map* get_string_map(const struct config* config, betree_var_t variable_id);
+struct integer_map* get_integer_map(const struct config* config, betree_var_t variable_id);
+void reserve_string_values(struct config* config, struct attr_var attr_var, size_t count);
 betree_ienum_t try_get_id_for_ienum(const struct config* config, struct attr_var attr_var, int64_t integer);
 betree_str_t try_get_id_for_string(const struct config* config, struct attr_var attr_var, const char* string);
 betree_ienum_t get_id_for_ienum(struct config* config, struct attr_var attr_var, int64_t integer, bool always_assign);
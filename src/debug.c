@@ -74,6 +74,7 @@ static const char* get_path_cdir(const struct config* config, const struct cdir*
     switch(cdir->bound.value_type) {
         case(BETREE_INTEGER):
         case(BETREE_INTEGER_LIST):
+        case(BETREE_SEGMENTS):
             if(basprintf(&name, "%s_%lu_%lu", parent_path, cdir->bound.imin, cdir->bound.imax)
                 < 0) {
                 abort();
@@ -102,10 +103,6 @@ static const char* get_path_cdir(const struct config* config, const struct cdir*
                 abort();
             }
             break;
-        case(BETREE_SEGMENTS): {
-            fprintf(stderr, "%s a segments value cdir should never happen for now", __func__);
-            abort();
-        }
         case(BETREE_FREQUENCY_CAPS): {
             fprintf(stderr, "%s a frequency value cdir should never happen for now", __func__);
             abort();
@@ -247,6 +244,7 @@ static void write_dot_file_cdir_td(FILE* f,
             switch(cdir->bound.value_type) {
                 case(BETREE_INTEGER):
                 case(BETREE_INTEGER_LIST):
+                case(BETREE_SEGMENTS):
                     fprintf(f,
                         "<td colspan=\"%lu\" port=\"%s\">[%ld, %ld]</td>\n",
                         colspan,
@@ -284,11 +282,6 @@ static void write_dot_file_cdir_td(FILE* f,
                         cdir->bound.smin,
                         cdir->bound.smax);
                     break;
-                case(BETREE_SEGMENTS): {
-                    fprintf(
-                        stderr, "%s a segment value cdir should never happen for now", __func__);
-                    abort();
-                }
                 case(BETREE_FREQUENCY_CAPS): {
                     fprintf(
                         stderr, "%s a frequency value cdir should never happen for now", __func__);
@@ -669,11 +669,11 @@ static const flex_int16_t yy_chk[79] =
 #line 1 "src/event_lexer.l"
 #line 2 "src/event_lexer.l"
     #include <stdlib.h>
-    #include "alloc.h"
+    #include "arena.h"
     #include "ast.h"
     #include "event_parser.h"
     #define SAVE_STRING {\
-        yylval->string = bmalloc(yyleng - 1);\
+        yylval->string = arena_malloc(yyleng - 1);\
         memcpy(yylval->string, yytext + 1, yyleng - 2);\
         yylval->string[yyleng - 2] = 0;\
     }
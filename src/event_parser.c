@@ -78,7 +78,7 @@
     #include <stdbool.h>
     #include <stdio.h>
     #include <string.h>
-    #include "alloc.h"
+    #include "arena.h"
     #include "ast.h"
     #include "betree.h"
     #include "event_parser.h"
@@ -1536,13 +1536,13 @@ yyreduce:
 
   case 6:
 #line 102 "src/event_parser.y"
-                                                            { (yyval.variable) = make_pred((yyvsp[-2].string), INVALID_VAR, (yyvsp[0].value)); bfree((yyvsp[-2].string)); }
+                                                            { (yyval.variable) = make_pred((yyvsp[-2].string), INVALID_VAR, (yyvsp[0].value)); arena_free((yyvsp[-2].string)); }
 #line 1541 "src/event_parser.c"
     break;
 
   case 7:
 #line 103 "src/event_parser.y"
-                                                            { (yyval.variable) = NULL; bfree((yyvsp[-2].string)); }
+                                                            { (yyval.variable) = NULL; arena_free((yyvsp[-2].string)); }
 #line 1547 "src/event_parser.c"
     break;
 
@@ -1638,7 +1638,7 @@ yyreduce:
 
   case 23:
 #line 128 "src/event_parser.y"
-                                                            { (yyval.string_value).string = bstrdup((yyvsp[0].string)); (yyval.string_value).str = INVALID_STR; bfree((yyvsp[0].string)); }
+                                                            { (yyval.string_value).string = (yyvsp[0].string); (yyval.string_value).length = strlen((yyvsp[0].string)); (yyval.string_value).str = INVALID_STR; }
 #line 1643 "src/event_parser.c"
     break;
 
@@ -1728,13 +1728,13 @@ yyreduce:
 
   case 38:
 #line 166 "src/event_parser.y"
-                                                            { (yyval.frequency_value) = make_frequency_cap((yyvsp[-9].string), (yyvsp[-7].integer_value), (yyvsp[-5].string_value), true, (yyvsp[-1].integer_value), (yyvsp[-3].integer_value)); bfree((yyvsp[-9].string)); }
+                                                            { (yyval.frequency_value) = make_frequency_cap((yyvsp[-9].string), (yyvsp[-7].integer_value), (yyvsp[-5].string_value), true, (yyvsp[-1].integer_value), (yyvsp[-3].integer_value)); arena_free((yyvsp[-9].string)); }
 #line 1733 "src/event_parser.c"
     break;
 
   case 39:
 #line 168 "src/event_parser.y"
-                                                            { (yyval.frequency_value) = make_frequency_cap((yyvsp[-10].string), (yyvsp[-8].integer_value), (yyvsp[-6].string_value), true, (yyvsp[-1].integer_value), (yyvsp[-3].integer_value)); bfree((yyvsp[-10].string)); }
+                                                            { (yyval.frequency_value) = make_frequency_cap((yyvsp[-10].string), (yyvsp[-8].integer_value), (yyvsp[-6].string_value), true, (yyvsp[-1].integer_value), (yyvsp[-3].integer_value)); arena_free((yyvsp[-10].string)); }
 #line 1739 "src/event_parser.c"
     break;
 
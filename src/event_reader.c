@@ -0,0 +1,562 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "config.h"
+#include "event_reader.h"
+#include "tree.h"
+#include "value.h"
+
+struct event_reader {
+    const char* cursor;
+    const struct config* config;
+    struct betree_bound_event* bound;
+    bool in_arena;
+};
+
+static void skip_spaces(struct event_reader* reader)
+{
+    while(*reader->cursor == ' ' || *reader->cursor == '\t' || *reader->cursor == '\n') {
+        reader->cursor++;
+    }
+}
+
+static char peek(struct event_reader* reader)
+{
+    skip_spaces(reader);
+    return *reader->cursor;
+}
+
+static bool expect(struct event_reader* reader, char c)
+{
+    if(peek(reader) != c) {
+        return false;
+    }
+    reader->cursor++;
+    return true;
+}
+
+static bool expect_word(struct event_reader* reader, const char* word, size_t length)
+{
+    if(strncmp(reader->cursor, word, length) != 0) {
+        return false;
+    }
+    reader->cursor += length;
+    return true;
+}
+
+static const char* skip_quoted(const char* c)
+{
+    char quote = *c;
+    for(c++; *c != quote; c++) {
+        if(*c == '\0') {
+            return NULL;
+        }
+        if(*c == '\\') {
+            c++;
+            if(*c == '\0') {
+                return NULL;
+            }
+        }
+    }
+    return c;
+}
+
+// Number of elements before the bracket closing the current one, so arrays are allocated once
+static size_t count_elements(const char* c)
+{
+    size_t count = 1;
+    size_t depth = 0;
+    for(; *c != '\0'; c++) {
+        switch(*c) {
+            case '"':
+            case '\'':
+                c = skip_quoted(c);
+                if(c == NULL) {
+                    return count;
+                }
+                break;
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                if(depth == 0) {
+                    return count;
+                }
+                depth--;
+                break;
+            case ',':
+                if(depth == 0) {
+                    count++;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return count;
+}
+
+static void* allocate_elements(size_t count, size_t size)
+{
+    void* elements = arena_malloc(count * size);
+    if(elements == NULL) {
+        fprintf(stderr, "%s arena_malloc failed\n", __func__);
+        abort();
+    }
+    return elements;
+}
+
+static bool read_slice(struct event_reader* reader, const char** start, size_t* length)
+{
+    char quote = peek(reader);
+    if(quote != '"' && quote != '\'') {
+        return false;
+    }
+    const char* end = skip_quoted(reader->cursor);
+    if(end == NULL) {
+        return false;
+    }
+    *start = reader->cursor + 1;
+    *length = end - *start;
+    reader->cursor = end + 1;
+    return true;
+}
+
+static char* copy_slice(const char* start, size_t length)
+{
+    char* string = arena_malloc(length + 1);
+    if(string == NULL) {
+        fprintf(stderr, "%s arena_malloc failed\n", __func__);
+        abort();
+    }
+    memcpy(string, start, length);
+    string[length] = '\0';
+    return string;
+}
+
+static bool read_string(struct event_reader* reader, betree_var_t var, struct string_value* value)
+{
+    const char* start;
+    size_t length;
+    if(!read_slice(reader, &start, &length)) {
+        return false;
+    }
+    value->length = length;
+    value->var = var;
+    value->str = INVALID_STR;
+    const struct string_map* string_map
+        = reader->config == NULL ? NULL : get_string_map(reader->config, var);
+    if(string_map != NULL) {
+        value->str = find_interned_slice(&string_map->strings, start, length);
+        if(reader->in_arena && value->str != INVALID_STR) {
+            value->string = get_interned_string(&string_map->strings, value->str);
+            return true;
+        }
+    }
+    value->string = copy_slice(start, length);
+    return true;
+}
+
+static bool read_number(struct event_reader* reader, struct value* value)
+{
+    bool negative = false;
+    if(peek(reader) == '-') {
+        negative = true;
+        reader->cursor++;
+        skip_spaces(reader);
+    }
+    const char* start = reader->cursor;
+    if(*start < '0' || *start > '9') {
+        return false;
+    }
+    uint64_t integer = 0;
+    for(; *reader->cursor >= '0' && *reader->cursor <= '9'; reader->cursor++) {
+        // Saturates like strtoll
+        integer = integer * 10 + (*reader->cursor - '0');
+        if(integer > INT64_MAX) {
+            integer = INT64_MAX;
+        }
+    }
+    if(*reader->cursor == '.') {
+        reader->cursor++;
+        while(*reader->cursor >= '0' && *reader->cursor <= '9') {
+            reader->cursor++;
+        }
+        double number = strtod(start, NULL);
+        value->value_type = BETREE_FLOAT;
+        value->float_value = negative ? -number : number;
+        return true;
+    }
+    value->value_type = BETREE_INTEGER;
+    value->integer_value = negative ? -(int64_t)integer : (int64_t)integer;
+    return true;
+}
+
+static bool read_integer(struct event_reader* reader, int64_t* integer)
+{
+    struct value value;
+    if(!read_number(reader, &value) || value.value_type != BETREE_INTEGER) {
+        return false;
+    }
+    *integer = value.integer_value;
+    return true;
+}
+
+static bool read_integer_list(struct event_reader* reader, struct betree_integer_list* list)
+{
+    size_t count = count_elements(reader->cursor);
+    list->integers = allocate_elements(count, sizeof(*list->integers));
+    do {
+        if(list->count == count || !read_integer(reader, &list->integers[list->count])) {
+            return false;
+        }
+        list->count++;
+    } while(expect(reader, ','));
+    return expect(reader, ']');
+}
+
+static bool read_string_list(
+    struct event_reader* reader, betree_var_t var, struct betree_string_list* list)
+{
+    size_t count = count_elements(reader->cursor);
+    list->strings = allocate_elements(count, sizeof(*list->strings));
+    do {
+        if(list->count == count || !read_string(reader, var, &list->strings[list->count])) {
+            return false;
+        }
+        list->count++;
+    } while(expect(reader, ','));
+    return expect(reader, ']');
+}
+
+static bool read_segments(struct event_reader* reader, struct betree_segments* list)
+{
+    size_t count = count_elements(reader->cursor);
+    list->ids = allocate_elements(count, sizeof(*list->ids));
+    list->timestamps = allocate_elements(count, sizeof(*list->timestamps));
+    do {
+        if(list->size == count || !expect(reader, '[')
+            || !read_integer(reader, &list->ids[list->size]) || !expect(reader, ',')
+            || !read_integer(reader, &list->timestamps[list->size]) || !expect(reader, ']')) {
+            return false;
+        }
+        list->size++;
+    } while(expect(reader, ','));
+    return expect(reader, ']');
+}
+
+static enum frequency_type_e read_frequency_type(struct event_reader* reader, bool* ok)
+{
+    const char* start;
+    size_t length;
+    char stype[32];
+    *ok = read_slice(reader, &start, &length);
+    if(!*ok || length >= sizeof(stype)) {
+        return FREQUENCY_TYPE_INVALID;
+    }
+    memcpy(stype, start, length);
+    stype[length] = '\0';
+    return get_type_from_string(stype);
+}
+
+static bool read_frequency_cap(
+    struct event_reader* reader, betree_var_t var, struct betree_frequency_cap** cap)
+{
+    if(!expect(reader, '[')) {
+        return false;
+    }
+    bool nested = expect(reader, '[');
+    bool ok;
+    enum frequency_type_e type = read_frequency_type(reader, &ok);
+    int64_t id, value, timestamp;
+    struct string_value namespace;
+    if(!ok || !expect(reader, ',') || !read_integer(reader, &id) || !expect(reader, ',')
+        || !read_string(reader, var, &namespace)) {
+        return false;
+    }
+    *cap = make_frequency_cap_with_type(type, id, namespace, true, 0, 0);
+    if((nested && !expect(reader, ']')) || !expect(reader, ',') || !read_integer(reader, &value)
+        || !expect(reader, ',') || !read_integer(reader, &timestamp) || !expect(reader, ']')) {
+        return false;
+    }
+    (*cap)->value = value;
+    (*cap)->timestamp = timestamp;
+    return true;
+}
+
+static bool read_frequency_caps(
+    struct event_reader* reader, betree_var_t var, struct betree_frequency_caps* list)
+{
+    size_t count = count_elements(reader->cursor);
+    list->content = allocate_elements(count, sizeof(*list->content));
+    do {
+        if(list->size == count) {
+            return false;
+        }
+        list->content[list->size] = NULL;
+        bool ok = read_frequency_cap(reader, var, &list->content[list->size]);
+        if(list->content[list->size] != NULL) {
+            list->size++;
+        }
+        if(!ok) {
+            return false;
+        }
+    } while(expect(reader, ','));
+    return expect(reader, ']');
+}
+
+static bool read_list(struct event_reader* reader, betree_var_t var, struct value* value)
+{
+    reader->cursor++;
+    char first = peek(reader);
+    if(first == ']') {
+        reader->cursor++;
+        value->value_type = BETREE_INTEGER_LIST;
+        value->integer_list_value = make_integer_list();
+        return true;
+    }
+    if(first == '"' || first == '\'') {
+        value->value_type = BETREE_STRING_LIST;
+        value->string_list_value = make_string_list();
+        return read_string_list(reader, var, value->string_list_value);
+    }
+    if(first == '[') {
+        const char* c = reader->cursor + 1;
+        while(*c == ' ' || *c == '\t' || *c == '\n') {
+            c++;
+        }
+        if(*c == '[' || *c == '"' || *c == '\'') {
+            value->value_type = BETREE_FREQUENCY_CAPS;
+            value->frequency_caps_value = make_frequency_caps();
+            return read_frequency_caps(reader, var, value->frequency_caps_value);
+        }
+        value->value_type = BETREE_SEGMENTS;
+        value->segments_value = make_segments();
+        return read_segments(reader, value->segments_value);
+    }
+    value->value_type = BETREE_INTEGER_LIST;
+    value->integer_list_value = make_integer_list();
+    return read_integer_list(reader, value->integer_list_value);
+}
+
+static bool read_value(struct event_reader* reader, betree_var_t var, struct value* value)
+{
+    switch(peek(reader)) {
+        case 't':
+            value->value_type = BETREE_BOOLEAN;
+            value->boolean_value = true;
+            return expect_word(reader, "true", 4);
+        case 'f':
+            value->value_type = BETREE_BOOLEAN;
+            value->boolean_value = false;
+            return expect_word(reader, "false", 5);
+        case '"':
+        case '\'':
+            value->value_type = BETREE_STRING;
+            return read_string(reader, var, &value->string_value);
+        case '[':
+            return read_list(reader, var, value);
+        default:
+            return read_number(reader, value);
+    }
+}
+
+static bool is_empty_integer_list(const struct value* value)
+{
+    return value->value_type == BETREE_INTEGER_LIST && value->integer_list_value->count == 0;
+}
+
+static void release_value(struct event_reader* reader, struct value* value)
+{
+    if(!reader->in_arena) {
+        free_value(*value);
+    }
+}
+
+// Same retyping as fill_event, refusing values that do not fit the domain
+static bool fill_value(struct event_reader* reader, betree_var_t var, struct value* value)
+{
+    const struct config* config = reader->config;
+    enum betree_value_type_e value_type = config->attr_domains[var]->bound.value_type;
+    if(value->value_type == value_type) {
+        return true;
+    }
+    switch(value_type) {
+        case BETREE_FLOAT:
+            if(value->value_type != BETREE_INTEGER) {
+                return false;
+            }
+            value->float_value = (double)value->integer_value;
+            break;
+        case BETREE_INTEGER_ENUM: {
+            if(value->value_type != BETREE_INTEGER) {
+                return false;
+            }
+            struct attr_var attr_var = { .attr = NULL, .var = var };
+            int64_t integer = value->integer_value;
+            value->integer_enum_value.integer = integer;
+            value->integer_enum_value.var = var;
+            value->integer_enum_value.ienum = try_get_id_for_ienum(config, attr_var, integer);
+            break;
+        }
+        case BETREE_STRING_LIST:
+            if(!is_empty_integer_list(value)) {
+                return false;
+            }
+            release_value(reader, value);
+            value->string_list_value = make_string_list();
+            break;
+        case BETREE_SEGMENTS:
+            if(!is_empty_integer_list(value)) {
+                return false;
+            }
+            release_value(reader, value);
+            value->segments_value = make_segments();
+            break;
+        case BETREE_FREQUENCY_CAPS:
+            if(!is_empty_integer_list(value)) {
+                return false;
+            }
+            release_value(reader, value);
+            value->frequency_caps_value = make_frequency_caps();
+            break;
+        case BETREE_BOOLEAN:
+        case BETREE_INTEGER:
+        case BETREE_STRING:
+        case BETREE_INTEGER_LIST:
+            return false;
+        default:
+            abort();
+    }
+    value->value_type = value_type;
+    return true;
+}
+
+static bool bind_read_value(struct betree_bound_event* event, betree_var_t var, struct value value)
+{
+    // The tree gained variables after the bound event was made
+    if(var >= event->variable_count) {
+        return false;
+    }
+    if(value.value_type == BETREE_INTEGER_LIST) {
+        sort_and_remove_duplicate_integer_list(value.integer_list_value);
+    }
+    else if(value.value_type == BETREE_STRING_LIST) {
+        sort_and_remove_duplicate_string_list(value.string_list_value);
+    }
+    else if(value.value_type == BETREE_SEGMENTS) {
+        sort_segments(value.segments_value);
+    }
+    else if(value.value_type == BETREE_FREQUENCY_CAPS) {
+        index_frequency_caps(value.frequency_caps_value);
+    }
+    struct betree_variable* variable = &event->variables[var];
+    variable->value = value;
+    event->preds[var] = variable;
+    set_bit(event->defined_vars, var);
+    return true;
+}
+
+static bool read_variable(struct event_reader* reader, struct betree_event* event)
+{
+    const char* attr;
+    size_t length;
+    if(!read_slice(reader, &attr, &length) || !expect(reader, ':')) {
+        return false;
+    }
+    if(peek(reader) == 'n') {
+        return expect_word(reader, "null", 4);
+    }
+    betree_var_t var = INVALID_VAR;
+    if(reader->config != NULL) {
+        var = try_get_id_for_attr_slice(reader->config, attr, length);
+        if(var == INVALID_VAR) {
+            fprintf(stderr, "Cannot find variable %.*s in config, aborting", (int)length, attr);
+            abort();
+        }
+    }
+    struct value value = { .value_type = BETREE_BOOLEAN };
+    if(!read_value(reader, var, &value)) {
+        release_value(reader, &value);
+        return false;
+    }
+    if(reader->config != NULL && !fill_value(reader, var, &value)) {
+        release_value(reader, &value);
+        return false;
+    }
+    if(reader->bound != NULL) {
+        return bind_read_value(reader->bound, var, value);
+    }
+    struct betree_variable* read = arena_malloc(sizeof(*read));
+    if(read == NULL) {
+        fprintf(stderr, "%s arena_malloc failed\n", __func__);
+        abort();
+    }
+    if(reader->config != NULL && reader->in_arena) {
+        read->attr_var.attr = reader->config->attr_domains[var]->attr_var.attr;
+    }
+    else {
+        read->attr_var.attr = copy_slice(attr, length);
+    }
+    read->attr_var.var = var;
+    read->value = value;
+    event->variables[event->variable_count] = read;
+    event->variable_count++;
+    return true;
+}
+
+// Without an event the variables go to the reader's bound event
+static bool read_event(struct event_reader* reader, struct betree_event* event)
+{
+    if(!expect(reader, '{')) {
+        return false;
+    }
+    if(!expect(reader, '}')) {
+        size_t capacity = 0;
+        if(event != NULL) {
+            capacity = count_elements(reader->cursor);
+            event->variables = allocate_elements(capacity, sizeof(*event->variables));
+        }
+        do {
+            if((event != NULL && event->variable_count == capacity)
+                || !read_variable(reader, event)) {
+                return false;
+            }
+        } while(expect(reader, ','));
+        if(!expect(reader, '}')) {
+            return false;
+        }
+    }
+    skip_spaces(reader);
+    return *reader->cursor == '\0';
+}
+
+int event_read(const struct config* config, const char* text, struct betree_event** event)
+{
+    struct event_reader reader = { .cursor = text,
+        .config = config,
+        .bound = NULL,
+        .in_arena = active_event_arena() != NULL };
+    struct betree_event* read = make_empty_event();
+    if(!read_event(&reader, read)) {
+        if(!reader.in_arena) {
+            free_event(read);
+        }
+        return -1;
+    }
+    *event = read;
+    return 0;
+}
+
+int event_read_bound(struct betree_bound_event* event, const char* text)
+{
+    struct event_reader reader
+        = { .cursor = text, .config = event->config, .bound = event, .in_arena = true };
+    return read_event(&reader, NULL) ? 0 : -1;
+}
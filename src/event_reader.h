@@ -0,0 +1,18 @@
+#pragma once
+
+#include "betree.h"
+
+struct betree_bound_event;
+struct config;
+
+/*
+ * Single pass reader for the grammar of event_parse, returning 0 on success like it does.
+ * Without a config the event is the same as the one event_parse builds. With a config, variables
+ * and strings are resolved while reading and the event comes out already filled. When an event
+ * arena is active, attribute names and known strings point at the config's own copies instead of
+ * being duplicated, so the event must not outlive changes to the tree.
+ */
+int event_read(const struct config* config, const char* text, struct betree_event** event);
+
+// Fills a cleared bound event, with its values allocated in the active arena
+int event_read_bound(struct betree_bound_event* event, const char* text);
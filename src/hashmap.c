@@ -8,8 +8,25 @@
 #include "jsw_rbtree.h"
 #include "map.h"
 #include "printer.h"
+#include "slab.h"
 #include "utils.h"
 
+static void add_memoize_id(struct pred_map* pred_map, struct ast_node* node)
+{
+    betree_pred_t memoize_id = pred_map->memoize_count;
+    pred_map->memoize_count++;
+    node->memoize_id = memoize_id;
+    size_t count = pred_map->memoize_count;
+    const struct ast_node** nodes
+        = slab_realloc(pred_map->slab, pred_map->memoize_nodes, count * sizeof(*nodes));
+    if(nodes == NULL) {
+        fprintf(stderr, "%s slab_realloc failed\n", __func__);
+        abort();
+    }
+    nodes[memoize_id] = node;
+    pred_map->memoize_nodes = nodes;
+}
+
 void assign_pred(struct pred_map* pred_map, struct ast_node* node)
 {
     if(node->type == AST_TYPE_BOOL_EXPR && node->bool_expr.op == AST_BOOL_NOT) {
@@ -32,18 +49,47 @@ void assign_pred(struct pred_map* pred_map, struct ast_node* node)
         if(ret == 0) {
             abort();
         }
+        // String patterns are all memoized so the matcher of their attribute can fill them
+        if(node->type == AST_TYPE_SPECIAL_EXPR && node->special_expr.type == AST_SPECIAL_STRING) {
+            add_memoize_id(pred_map, node);
+            add_string_pattern(&pred_map->string_matchers, node);
+        }
     }
     else {
         node->global_id = find->global_id;
         if(find->memoize_id == INVALID_PRED) {
-            betree_pred_t memoize_id = pred_map->memoize_count;
-            pred_map->memoize_count++;
-            find->memoize_id = memoize_id;
+            add_memoize_id(pred_map, find);
         }
         node->memoize_id = find->memoize_id;
     }
 }
 
+void count_pred_shares(struct pred_map* pred_map, const struct ast_node* node)
+{
+    if(pred_map->share_count < pred_map->pred_count) {
+        uint64_t* shares = slab_realloc(
+            pred_map->slab, pred_map->pred_shares, pred_map->pred_count * sizeof(*shares));
+        if(shares == NULL) {
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
+            abort();
+        }
+        for(size_t i = pred_map->share_count; i < pred_map->pred_count; i++) {
+            shares[i] = 0;
+        }
+        pred_map->pred_shares = shares;
+        pred_map->share_count = pred_map->pred_count;
+    }
+    pred_map->pred_shares[node->global_id]++;
+    if(node->type == AST_TYPE_BOOL_EXPR && node->bool_expr.op == AST_BOOL_NOT) {
+        count_pred_shares(pred_map, node->bool_expr.unary.expr);
+    }
+    else if(node->type == AST_TYPE_BOOL_EXPR
+        && (node->bool_expr.op == AST_BOOL_OR || node->bool_expr.op == AST_BOOL_AND)) {
+        count_pred_shares(pred_map, node->bool_expr.binary.lhs);
+        count_pred_shares(pred_map, node->bool_expr.binary.rhs);
+    }
+}
+
 static struct jsw_rbtree* exprmap_new()
 {
     struct jsw_rbtree* rbtree;
@@ -67,7 +113,115 @@ struct pred_map* make_pred_map()
 void free_pred_map(struct pred_map* pred_map)
 {
     jsw_rbdelete(pred_map->m);
+    free_string_matchers(&pred_map->string_matchers);
+    slab_free(pred_map->pred_shares);
+    slab_free(pred_map->memoize_nodes);
     bfree(pred_map);
 }
 
+struct shared_pred {
+    uint64_t shares;
+    const struct ast_node* node;
+};
+
+static int shared_pred_cmp(const void* a, const void* b)
+{
+    const struct shared_pred* x = a;
+    const struct shared_pred* y = b;
+    if(x->shares != y->shares) {
+        return x->shares > y->shares ? -1 : 1;
+    }
+    if(x->node->memoize_id == y->node->memoize_id) {
+        return 0;
+    }
+    return x->node->memoize_id < y->node->memoize_id ? -1 : 1;
+}
+
+static betree_var_t eager_group_var(const struct ast_node* node)
+{
+    switch(node->type) {
+        case AST_TYPE_COMPARE_EXPR:
+            return node->compare_expr.attr_var.var;
+        case AST_TYPE_EQUALITY_EXPR:
+            return node->equality_expr.attr_var.var;
+        case AST_TYPE_BOOL_EXPR:
+        case AST_TYPE_SET_EXPR:
+        case AST_TYPE_LIST_EXPR:
+        case AST_TYPE_SPECIAL_EXPR:
+        case AST_TYPE_IS_NULL_EXPR:
+            return INVALID_VAR;
+        default:
+            abort();
+    }
+}
+
+static int eager_group_op(const struct ast_node* node)
+{
+    switch(node->type) {
+        case AST_TYPE_COMPARE_EXPR:
+            return node->compare_expr.op;
+        case AST_TYPE_EQUALITY_EXPR:
+            return node->equality_expr.op;
+        case AST_TYPE_BOOL_EXPR:
+        case AST_TYPE_SET_EXPR:
+        case AST_TYPE_LIST_EXPR:
+        case AST_TYPE_SPECIAL_EXPR:
+        case AST_TYPE_IS_NULL_EXPR:
+            return 0;
+        default:
+            abort();
+    }
+}
+
+static int eager_group_cmp(const void* a, const void* b)
+{
+    const struct ast_node* x = *(const struct ast_node* const*)a;
+    const struct ast_node* y = *(const struct ast_node* const*)b;
+    if(x->type != y->type) {
+        return x->type < y->type ? -1 : 1;
+    }
+    betree_var_t x_var = eager_group_var(x);
+    betree_var_t y_var = eager_group_var(y);
+    if(x_var != y_var) {
+        return x_var < y_var ? -1 : 1;
+    }
+    int x_op = eager_group_op(x);
+    int y_op = eager_group_op(y);
+    if(x_op != y_op) {
+        return x_op < y_op ? -1 : 1;
+    }
+    if(x->memoize_id == y->memoize_id) {
+        return 0;
+    }
+    return x->memoize_id < y->memoize_id ? -1 : 1;
+}
+
+void select_eager_preds(struct pred_map* pred_map, size_t count)
+{
+    pred_map->eager_count = 0;
+    count = smin(smin(count, EAGER_PRED_MAX), pred_map->memoize_count);
+    if(count == 0) {
+        return;
+    }
+    struct shared_pred* shared = bmalloc(pred_map->memoize_count * sizeof(*shared));
+    if(shared == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    for(size_t i = 0; i < pred_map->memoize_count; i++) {
+        const struct ast_node* node = pred_map->memoize_nodes[i];
+        shared[i].shares
+            = node->global_id < pred_map->share_count ? pred_map->pred_shares[node->global_id] : 0;
+        shared[i].node = node;
+    }
+    qsort(shared, pred_map->memoize_count, sizeof(*shared), shared_pred_cmp);
+    for(size_t i = 0; i < count; i++) {
+        pred_map->eager_nodes[i] = shared[i].node;
+    }
+    bfree(shared);
+    // Evaluate the preds grouped by attribute and operator
+    qsort(pred_map->eager_nodes, count, sizeof(*pred_map->eager_nodes), eager_group_cmp);
+    pred_map->eager_count = count;
+}
+
 
@@ -1,19 +1,37 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "jsw_rbtree.h"
 #include "memoize.h"
+#include "string_matcher.h"
 
 struct ast_node;
+struct node_slab;
+
+#define EAGER_PRED_MAX 64
 
 struct pred_map {
+    // The config's slab, for the arrays below
+    struct node_slab* slab;
     betree_pred_t pred_count;
     betree_pred_t memoize_count;
     struct jsw_rbtree* m;
+    // Inserted subs using each pred, by global id
+    size_t share_count;
+    uint64_t* pred_shares;
+    const struct ast_node** memoize_nodes;
+    struct string_matchers string_matchers;
+    struct {
+        size_t eager_count;
+        const struct ast_node* eager_nodes[EAGER_PRED_MAX];
+    };
 };
 
 void assign_pred(struct pred_map* pred_map, struct ast_node* node);
+void count_pred_shares(struct pred_map* pred_map, const struct ast_node* node);
 struct pred_map* make_pred_map();
 void free_pred_map(struct pred_map* pred_map);
+void select_eager_preds(struct pred_map* pred_map, size_t count);
 
@@ -43,7 +43,14 @@ void add_variable_from_string(struct betree* betree, const char* line)
         add_attr_domain_frequency(config, name, allow_undefined);
     }
     else if(strcmp(type, "segments") == 0) {
-        add_attr_domain_segments(config, name, allow_undefined);
+        int64_t min = INT64_MIN, max = INT64_MAX;
+        if(min_str != NULL) {
+            min = strtoll(min_str, NULL, 10);
+        }
+        if(max_str != NULL) {
+            max = strtoll(max_str, NULL, 10);
+        }
+        add_attr_domain_bounded_segments(config, name, allow_undefined, min, max);
     }
     else if(strcmp(type, "string") == 0) {
         if(min_str != NULL) {
@@ -101,6 +108,8 @@ void empty_tree(struct betree* betree)
         betree->cnode = make_cnode(betree->config, NULL);
         free_pred_map(betree->config->pred_map);
         betree->config->pred_map = make_pred_map();
+        betree->config->pred_map->slab = betree->config->node_slab;
+        betree->config->version++;
     }
 }
 
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "interner.h"
+#include "slab.h"
+
+void init_string_interner(struct string_interner* interner)
+{
+    memset(interner, 0, sizeof(*interner));
+}
+
+void deinit_string_interner(struct string_interner* interner)
+{
+    slab_free(interner->slots);
+    slab_free(interner->keys);
+    struct interner_chunk* chunk = interner->chunks;
+    while(chunk != NULL) {
+        struct interner_chunk* next = chunk->next;
+        slab_free(chunk);
+        chunk = next;
+    }
+    init_string_interner(interner);
+}
+
+static uint64_t hash_string(const char* string, size_t* length)
+{
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    const unsigned char* c = (const unsigned char*)string;
+    for(; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 0x100000001B3ULL;
+    }
+    *length = (const char*)c - string;
+    return hash;
+}
+
+static uint64_t hash_slice(const char* string, size_t length)
+{
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for(size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)string[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static void place_slot(struct interner_slot* slots, size_t capacity, uint64_t hash, betree_str_t str)
+{
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while(slots[i].str != INVALID_STR) {
+        i = (i + 1) & mask;
+    }
+    slots[i].hash = hash;
+    slots[i].str = str;
+}
+
+static void grow_slots(struct string_interner* interner, size_t capacity)
+{
+    struct interner_slot* slots = slab_malloc(interner->slab, capacity * sizeof(*slots));
+    if(slots == NULL) {
+        fprintf(stderr, "%s slab_malloc failed\n", __func__);
+        abort();
+    }
+    for(size_t i = 0; i < capacity; i++) {
+        slots[i].str = INVALID_STR;
+    }
+    for(size_t i = 0; i < interner->slot_capacity; i++) {
+        const struct interner_slot* slot = &interner->slots[i];
+        if(slot->str != INVALID_STR) {
+            place_slot(slots, capacity, slot->hash, slot->str);
+        }
+    }
+    slab_free(interner->slots);
+    interner->slots = slots;
+    interner->slot_capacity = capacity;
+}
+
+static void grow_keys(struct string_interner* interner, size_t capacity)
+{
+    const char** keys = slab_realloc(interner->slab, interner->keys, capacity * sizeof(*keys));
+    if(keys == NULL) {
+        fprintf(stderr, "%s slab_realloc failed\n", __func__);
+        abort();
+    }
+    interner->keys = keys;
+    interner->key_capacity = capacity;
+}
+
+static char* allocate_key(struct string_interner* interner, size_t size)
+{
+    struct interner_chunk* chunk = interner->chunks;
+    if(chunk == NULL || chunk->used + size > chunk->size) {
+        size_t chunk_size = chunk == NULL ? 256 : chunk->size * 2;
+        while(chunk_size < size) {
+            chunk_size *= 2;
+        }
+        chunk = slab_malloc(interner->slab, sizeof(*chunk) + chunk_size);
+        if(chunk == NULL) {
+            fprintf(stderr, "%s slab_malloc failed\n", __func__);
+            abort();
+        }
+        chunk->next = interner->chunks;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        interner->chunks = chunk;
+    }
+    char* key = chunk->data + chunk->used;
+    chunk->used += size;
+    return key;
+}
+
+void reserve_string_interner(struct string_interner* interner, size_t count)
+{
+    size_t capacity = 16;
+    while(capacity < count * 2) {
+        capacity *= 2;
+    }
+    if(capacity > interner->slot_capacity) {
+        grow_slots(interner, capacity);
+    }
+    if(count > interner->key_capacity) {
+        grow_keys(interner, count);
+    }
+}
+
+static betree_str_t find_with_hash(
+    const struct string_interner* interner, const char* string, uint64_t hash)
+{
+    if(interner->slot_capacity == 0) {
+        return INVALID_STR;
+    }
+    size_t mask = interner->slot_capacity - 1;
+    for(size_t i = hash & mask;; i = (i + 1) & mask) {
+        const struct interner_slot* slot = &interner->slots[i];
+        if(slot->str == INVALID_STR) {
+            return INVALID_STR;
+        }
+        if(slot->hash == hash
+            && strcmp(interner->keys[slot->str], string) == 0) {
+            return slot->str;
+        }
+    }
+}
+
+betree_str_t find_interned_string(const struct string_interner* interner, const char* string)
+{
+    size_t length;
+    uint64_t hash = hash_string(string, &length);
+    return find_with_hash(interner, string, hash);
+}
+
+betree_str_t find_interned_slice(
+    const struct string_interner* interner, const char* string, size_t length)
+{
+    if(interner->slot_capacity == 0) {
+        return INVALID_STR;
+    }
+    uint64_t hash = hash_slice(string, length);
+    size_t mask = interner->slot_capacity - 1;
+    for(size_t i = hash & mask;; i = (i + 1) & mask) {
+        const struct interner_slot* slot = &interner->slots[i];
+        if(slot->str == INVALID_STR) {
+            return INVALID_STR;
+        }
+        const char* key = interner->keys[slot->str];
+        if(slot->hash == hash && strncmp(key, string, length) == 0 && key[length] == '\0') {
+            return slot->str;
+        }
+    }
+}
+
+betree_str_t intern_string(struct string_interner* interner, const char* string)
+{
+    size_t length;
+    uint64_t hash = hash_string(string, &length);
+    betree_str_t str = find_with_hash(interner, string, hash);
+    if(str != INVALID_STR) {
+        return str;
+    }
+    if((interner->count + 1) * 2 > interner->slot_capacity) {
+        grow_slots(interner, interner->slot_capacity == 0 ? 16 : interner->slot_capacity * 2);
+    }
+    if(interner->count == interner->key_capacity) {
+        grow_keys(interner, interner->key_capacity == 0 ? 8 : interner->key_capacity * 2);
+    }
+    str = interner->count;
+    char* key = allocate_key(interner, length + 1);
+    memcpy(key, string, length + 1);
+    interner->keys[str] = key;
+    place_slot(interner->slots, interner->slot_capacity, hash, str);
+    interner->count++;
+    return str;
+}
+
+const char* get_interned_string(const struct string_interner* interner, betree_str_t str)
+{
+    if(str >= interner->count) {
+        return NULL;
+    }
+    return interner->keys[str];
+}
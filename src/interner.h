@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "value.h"
+
+struct node_slab;
+
+struct interner_slot {
+    uint64_t hash;
+    betree_str_t str;
+};
+
+struct interner_chunk {
+    struct interner_chunk* next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+// Open addressing table of strings to dense ids. Keys are packed in chunks that are never
+// moved, so the pointers returned by get_interned_string stay valid until deinit, even as
+// more strings are interned.
+struct string_interner {
+    size_t count;
+    struct {
+        size_t slot_capacity;
+        struct interner_slot* slots;
+    };
+    struct {
+        size_t key_capacity;
+        const char** keys;
+    };
+    struct interner_chunk* chunks;
+    // Where the tables are allocated, NULL for the heap
+    struct node_slab* slab;
+};
+
+void init_string_interner(struct string_interner* interner);
+void deinit_string_interner(struct string_interner* interner);
+void reserve_string_interner(struct string_interner* interner, size_t count);
+
+betree_str_t find_interned_string(const struct string_interner* interner, const char* string);
+// Same lookup for a string that is not NUL terminated
+betree_str_t find_interned_slice(
+    const struct string_interner* interner, const char* string, size_t length);
+betree_str_t intern_string(struct string_interner* interner, const char* string);
+const char* get_interned_string(const struct string_interner* interner, betree_str_t str);
@@ -17,3 +17,45 @@ bool test_bit(const uint64_t A[], uint64_t k)
     return ((A[k / 64ULL] & (1ULL << (k % 64ULL))) != 0ULL);
 }
 
+
+static void touch_memoize_word(struct memoize* memoize, betree_pred_t memoize_id)
+{
+    if(memoize->touched == NULL) {
+        return;
+    }
+    size_t word = memoize_id / 64ULL;
+    if((memoize->pass[word] | memoize->fail[word]) == 0ULL) {
+        memoize->touched[memoize->touched_count] = word;
+        memoize->touched_count++;
+    }
+}
+
+void set_memoize_pass(struct memoize* memoize, betree_pred_t memoize_id)
+{
+    touch_memoize_word(memoize, memoize_id);
+    set_bit(memoize->pass, memoize_id);
+}
+
+void set_memoize_fail(struct memoize* memoize, betree_pred_t memoize_id)
+{
+    touch_memoize_word(memoize, memoize_id);
+    set_bit(memoize->fail, memoize_id);
+}
+
+void set_memoize_fail_mask(struct memoize* memoize, size_t word, uint64_t mask)
+{
+    touch_memoize_word(memoize, word * 64ULL);
+    memoize->fail[word] |= mask;
+}
+
+void reset_memoize(struct memoize* memoize)
+{
+    for(size_t i = 0; i < memoize->touched_count; i++) {
+        size_t word = memoize->touched[i];
+        memoize->pass[word] = 0ULL;
+        memoize->fail[word] = 0ULL;
+    }
+    memoize->touched_count = 0;
+    memoize->eager_pass = 0ULL;
+    memoize->eager_fail = 0ULL;
+}
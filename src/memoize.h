@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef uint64_t betree_pred_t;
@@ -9,9 +10,18 @@ static const betree_pred_t INVALID_PRED = UINT64_MAX;
 struct memoize {
     uint64_t* pass;
     uint64_t* fail;
+    uint64_t eager_pass;
+    uint64_t eager_fail;
+    size_t* touched;
+    size_t touched_count;
 };
 
 void set_bit(uint64_t A[], uint64_t k);
 void clear_bit(uint64_t A[], uint64_t k);
 bool test_bit(const uint64_t A[], uint64_t k);
 
+void set_memoize_pass(struct memoize* memoize, betree_pred_t memoize_id);
+void set_memoize_fail(struct memoize* memoize, betree_pred_t memoize_id);
+void set_memoize_fail_mask(struct memoize* memoize, size_t word, uint64_t mask);
+void reset_memoize(struct memoize* memoize);
+
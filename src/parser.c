@@ -1485,7 +1485,7 @@ yyreduce:
 
   case 8:
 #line 108 "src/parser.y" /* yacc.c:1646  */
-    { (yyval.string_value).string = bstrdup((yyvsp[0].string)); (yyval.string_value).str = INVALID_STR; bfree((yyvsp[0].string)); }
+    { (yyval.string_value).string = bstrdup((yyvsp[0].string)); (yyval.string_value).length = strlen((yyvsp[0].string)); (yyval.string_value).str = INVALID_STR; bfree((yyvsp[0].string)); }
 #line 1490 "src/parser.c" /* yacc.c:1646  */
     break;
 
@@ -105,7 +105,7 @@ float               : TFLOAT                                { $$ = $1; }
                     | TMINUS TFLOAT                         { $$ = - $2; }
 ;
 
-string              : TSTRING                               { $$.string = bstrdup($1); $$.str = INVALID_STR; bfree($1); }
+string              : TSTRING                               { $$.string = bstrdup($1); $$.length = strlen($1); $$.str = INVALID_STR; bfree($1); }
 
 integer_list_value  : TLPAREN integer_list_loop TRPAREN     { $$ = $2; }
 
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "ast.h"
+#include "config.h"
+#include "hashmap.h"
+#include "pred_cache.h"
+#include "tree.h"
+#include "utils.h"
+
+static betree_var_t merge_var(betree_var_t a, betree_var_t b)
+{
+    if(a == b) {
+        return a;
+    }
+    return INVALID_VAR;
+}
+
+static betree_var_t single_var_of_node(const struct ast_node* node)
+{
+    switch(node->type) {
+        case AST_TYPE_COMPARE_EXPR:
+            return node->compare_expr.attr_var.var;
+        case AST_TYPE_EQUALITY_EXPR:
+            return node->equality_expr.attr_var.var;
+        case AST_TYPE_LIST_EXPR:
+            return node->list_expr.attr_var.var;
+        case AST_TYPE_IS_NULL_EXPR:
+            return node->is_null_expr.attr_var.var;
+        case AST_TYPE_SET_EXPR: {
+            bool left_variable = node->set_expr.left_value.value_type == AST_SET_LEFT_VALUE_VARIABLE;
+            bool right_variable
+                = node->set_expr.right_value.value_type == AST_SET_RIGHT_VALUE_VARIABLE;
+            if(left_variable && !right_variable) {
+                return node->set_expr.left_value.variable_value.var;
+            }
+            if(right_variable && !left_variable) {
+                return node->set_expr.right_value.variable_value.var;
+            }
+            return INVALID_VAR;
+        }
+        case AST_TYPE_SPECIAL_EXPR:
+            if(node->special_expr.type == AST_SPECIAL_STRING) {
+                return node->special_expr.string.attr_var.var;
+            }
+            return INVALID_VAR;
+        case AST_TYPE_BOOL_EXPR:
+            switch(node->bool_expr.op) {
+                case AST_BOOL_OR:
+                case AST_BOOL_AND:
+                    return merge_var(single_var_of_node(node->bool_expr.binary.lhs),
+                        single_var_of_node(node->bool_expr.binary.rhs));
+                case AST_BOOL_NOT:
+                    return single_var_of_node(node->bool_expr.unary.expr);
+                case AST_BOOL_VARIABLE:
+                    return node->bool_expr.variable.var;
+                case AST_BOOL_LITERAL:
+                    return INVALID_VAR;
+                default:
+                    abort();
+            }
+        default:
+            abort();
+    }
+}
+
+static void add_pred_to_attr(struct pred_cache_attr* attr, const struct ast_node* node)
+{
+    const struct ast_node** preds
+        = brealloc(attr->preds, (attr->pred_count + 1) * sizeof(*preds));
+    if(preds == NULL) {
+        fprintf(stderr, "%s brealloc failed\n", __func__);
+        abort();
+    }
+    preds[attr->pred_count] = node;
+    attr->preds = preds;
+    attr->pred_count++;
+}
+
+struct betree_pred_cache* make_pred_cache(const struct config* config, size_t capacity)
+{
+    struct betree_pred_cache* cache = bcalloc(sizeof(*cache));
+    if(cache == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    cache->attr_count = config->attr_domain_count;
+    cache->attrs = bcalloc(cache->attr_count * sizeof(*cache->attrs));
+    if(cache->attr_count != 0 && cache->attrs == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    const struct pred_map* pred_map = config->pred_map;
+    size_t max_pred_count = 0;
+    for(size_t i = 0; i < pred_map->memoize_count; i++) {
+        const struct ast_node* node = pred_map->memoize_nodes[i];
+        betree_var_t var = single_var_of_node(node);
+        if(var == INVALID_VAR || var >= cache->attr_count) {
+            continue;
+        }
+        struct pred_cache_attr* attr = &cache->attrs[var];
+        add_pred_to_attr(attr, node);
+        max_pred_count = smax(max_pred_count, attr->pred_count);
+    }
+    cache->word_count = max_pred_count / 64 + 1;
+    cache->capacity = capacity < 2 ? 2 : capacity + capacity % 2;
+    cache->entries = bcalloc(cache->capacity * sizeof(*cache->entries));
+    cache->bits = bcalloc(cache->capacity * 2 * cache->word_count * sizeof(*cache->bits));
+    if(cache->entries == NULL || cache->bits == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    for(size_t i = 0; i < cache->capacity; i++) {
+        cache->entries[i].pass = cache->bits + (2 * i) * cache->word_count;
+        cache->entries[i].fail = cache->bits + (2 * i + 1) * cache->word_count;
+    }
+    return cache;
+}
+
+void free_pred_cache(struct betree_pred_cache* cache)
+{
+    if(cache == NULL) {
+        return;
+    }
+    for(size_t i = 0; i < cache->attr_count; i++) {
+        bfree(cache->attrs[i].preds);
+    }
+    bfree(cache->attrs);
+    bfree(cache->entries);
+    bfree(cache->bits);
+    bfree(cache);
+}
+
+static bool value_key(const struct value* value, uint64_t* key)
+{
+    switch(value->value_type) {
+        case BETREE_BOOLEAN:
+            *key = value->boolean_value;
+            return true;
+        case BETREE_INTEGER:
+            *key = (uint64_t)value->integer_value;
+            return true;
+        case BETREE_FLOAT:
+            memcpy(key, &value->float_value, sizeof(*key));
+            return true;
+        case BETREE_STRING:
+            // Unknown strings all share INVALID_STR, but string specials still look at the text
+            if(value->string_value.str == INVALID_STR) {
+                return false;
+            }
+            *key = value->string_value.str;
+            return true;
+        case BETREE_INTEGER_ENUM:
+            *key = (uint64_t)value->integer_enum_value.integer;
+            return true;
+        case BETREE_INTEGER_LIST:
+        case BETREE_STRING_LIST:
+        case BETREE_SEGMENTS:
+        case BETREE_FREQUENCY_CAPS:
+            return false;
+        default:
+            abort();
+    }
+}
+
+// Two-way set associative: a bucket is a pair of entries, most recently used first
+static size_t bucket_index(const struct betree_pred_cache* cache, betree_var_t var, uint64_t key)
+{
+    uint64_t hash = (var + 1) * 0x9E3779B97F4A7C15ULL;
+    hash ^= key + 0x7F4A7C159E3779B9ULL + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return (hash % (cache->capacity / 2)) * 2;
+}
+
+static bool is_entry(const struct pred_cache_entry* entry, betree_var_t var, uint64_t key)
+{
+    return entry->used && entry->var == var && entry->key == key;
+}
+
+static void swap_entries(struct pred_cache_entry* a, struct pred_cache_entry* b)
+{
+    struct pred_cache_entry tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+void fill_memoize_from_pred_cache(struct betree_pred_cache* cache,
+    const struct betree_variable** preds,
+    struct memoize* memoize,
+    struct report* report)
+{
+    for(size_t var = 0; var < cache->attr_count; var++) {
+        const struct pred_cache_attr* attr = &cache->attrs[var];
+        uint64_t key;
+        if(attr->pred_count == 0 || preds[var] == NULL || !value_key(&preds[var]->value, &key)) {
+            continue;
+        }
+        struct pred_cache_entry* bucket = &cache->entries[bucket_index(cache, var, key)];
+        if(is_entry(&bucket[1], var, key)) {
+            swap_entries(&bucket[0], &bucket[1]);
+        }
+        struct pred_cache_entry* entry = &bucket[0];
+        if(is_entry(entry, var, key)) {
+            for(size_t i = 0; i < attr->pred_count; i++) {
+                betree_pred_t memoize_id = attr->preds[i]->memoize_id;
+                if(test_bit(entry->pass, i)) {
+                    set_memoize_pass(memoize, memoize_id);
+                }
+                else if(test_bit(entry->fail, i)) {
+                    set_memoize_fail(memoize, memoize_id);
+                }
+            }
+            if(report != NULL) {
+                report->pred_cache_hits++;
+            }
+            continue;
+        }
+        swap_entries(&bucket[0], &bucket[1]);
+        memset(entry->pass, 0, cache->word_count * sizeof(*entry->pass));
+        memset(entry->fail, 0, cache->word_count * sizeof(*entry->fail));
+        for(size_t i = 0; i < attr->pred_count; i++) {
+            if(match_node(preds, attr->preds[i], memoize, NULL)) {
+                set_bit(entry->pass, i);
+            }
+            else {
+                set_bit(entry->fail, i);
+            }
+        }
+        entry->used = true;
+        entry->var = var;
+        entry->key = key;
+        if(report != NULL) {
+            report->pred_cache_misses++;
+        }
+    }
+}
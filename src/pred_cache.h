@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "betree.h"
+#include "memoize.h"
+#include "value.h"
+
+struct ast_node;
+struct config;
+struct betree_variable;
+
+struct pred_cache_attr {
+    size_t pred_count;
+    const struct ast_node** preds;
+};
+
+struct pred_cache_entry {
+    bool used;
+    betree_var_t var;
+    uint64_t key;
+    uint64_t* pass;
+    uint64_t* fail;
+};
+
+struct betree_pred_cache {
+    struct {
+        size_t attr_count;
+        struct pred_cache_attr* attrs;
+    };
+    size_t word_count;
+    struct {
+        size_t capacity;
+        struct pred_cache_entry* entries;
+    };
+    uint64_t* bits;
+};
+
+struct betree_pred_cache* make_pred_cache(const struct config* config, size_t capacity);
+void free_pred_cache(struct betree_pred_cache* cache);
+
+void fill_memoize_from_pred_cache(struct betree_pred_cache* cache,
+    const struct betree_variable** preds,
+    struct memoize* memoize,
+    struct report* report);
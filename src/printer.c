@@ -509,8 +509,20 @@ void print_attr_domain(const struct attr_domain* domain)
             }
             break;
         case BETREE_SEGMENTS:
-            printf("%s (segments%s)\n", domain->attr_var.attr,
+            printf("%s (segments%s) [", domain->attr_var.attr,
               domain->allow_undefined ? "?" : "");
+            if(domain->bound.imin == INT64_MIN) {
+                printf("INT64_MIN, ");
+            }
+            else {
+                printf("%ld, ", domain->bound.imin);
+            }
+            if(domain->bound.imax == INT64_MAX) {
+                printf("INT64_MAX]\n");
+            }
+            else {
+                printf("%ld]\n", domain->bound.imax);
+            }
             break;
         case BETREE_FREQUENCY_CAPS:
             printf("%s (frequency caps%s)\n", domain->attr_var.attr,
@@ -601,7 +613,10 @@ void print_cdir(const struct cdir* cdir)
                 printf("%zu]\n", cdir->bound.smax);
             }
             break;
-        case BETREE_SEGMENTS: abort();
+        case BETREE_SEGMENTS:
+            printf("%s (segments) [%ld, %ld]\n", cdir->attr_var.attr, cdir->bound.imin,
+              cdir->bound.imax);
+            break;
         case BETREE_FREQUENCY_CAPS: abort();
         default: abort();
     }
@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "config.h"
+#include "memoize.h"
+#include "reason_aggregator.h"
+#include "tree.h"
+
+static size_t next_shard = 0;
+static __thread size_t thread_shard = SIZE_MAX;
+
+typedef void (*sub_visitor)(
+    struct betree_reason_aggregator* aggregator, const struct betree_sub* sub);
+
+static void walk_cdir(
+    struct betree_reason_aggregator* aggregator, const struct cdir* cdir, sub_visitor visit);
+
+static void walk_cnode(
+    struct betree_reason_aggregator* aggregator, const struct cnode* cnode, sub_visitor visit)
+{
+    for(size_t i = 0; i < cnode->lnode->sub_count; i++) {
+        const struct betree_sub* sub = cnode->lnode->subs[i];
+        if(sub->index < aggregator->sub_count) {
+            visit(aggregator, sub);
+        }
+    }
+    if(cnode->pdir != NULL) {
+        for(size_t i = 0; i < cnode->pdir->pnode_count; i++) {
+            walk_cdir(aggregator, cnode->pdir->pnodes[i]->cdir, visit);
+        }
+    }
+}
+
+static void walk_cdir(
+    struct betree_reason_aggregator* aggregator, const struct cdir* cdir, sub_visitor visit)
+{
+    if(cdir == NULL) {
+        return;
+    }
+    walk_cnode(aggregator, cdir->cnode, visit);
+    walk_cdir(aggregator, cdir->lchild, visit);
+    walk_cdir(aggregator, cdir->rchild, visit);
+}
+
+static void count_sub_reasons(
+    struct betree_reason_aggregator* aggregator, const struct betree_sub* sub)
+{
+    uint32_t count = REASON_ADDITIONAL_MAX;
+    for(betree_var_t i = 0; i < aggregator->config->attr_domain_count; i++) {
+        if(test_bit(sub->attr_vars, i)) {
+            count++;
+        }
+    }
+    aggregator->offsets[sub->index + 1] = count;
+}
+
+static void fill_sub_reasons(
+    struct betree_reason_aggregator* aggregator, const struct betree_sub* sub)
+{
+    uint32_t* reasons = aggregator->reasons + aggregator->offsets[sub->index];
+    size_t domain_count = aggregator->config->attr_domain_count;
+    for(betree_var_t i = 0; i < domain_count; i++) {
+        if(test_bit(sub->attr_vars, i)) {
+            *reasons++ = i;
+        }
+    }
+    for(size_t reason = 1; reason <= REASON_ADDITIONAL_MAX; reason++) {
+        *reasons++ = ADDITIONAL_REASON(domain_count, reason);
+    }
+}
+
+static int compare_reason_sub_ids(const void* a, const void* b)
+{
+    betree_sub_t x = ((const struct reason_sub_id*)a)->id;
+    betree_sub_t y = ((const struct reason_sub_id*)b)->id;
+    return (x > y) - (x < y);
+}
+
+static size_t counter_count(const struct betree_reason_aggregator* aggregator)
+{
+    return aggregator->offsets[aggregator->sub_count];
+}
+
+struct betree_reason_aggregator* make_reason_aggregator(
+    const struct betree_err* betree, size_t shard_count)
+{
+    struct betree_reason_aggregator* aggregator = bcalloc(sizeof(*aggregator));
+    if(aggregator == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    aggregator->config = betree->config;
+    aggregator->sub_count = betree->config->sub_count;
+    aggregator->reason_count = betree->config->attr_domain_count + REASON_ADDITIONAL_MAX;
+    aggregator->offsets = bcalloc((aggregator->sub_count + 1) * sizeof(*aggregator->offsets));
+    aggregator->sub_ids = bmalloc(aggregator->sub_count * sizeof(*aggregator->sub_ids) + 1);
+    if(aggregator->offsets == NULL || aggregator->sub_ids == NULL) {
+        fprintf(stderr, "%s allocation failed\n", __func__);
+        abort();
+    }
+    walk_cnode(aggregator, betree->betree->cnode, count_sub_reasons);
+    for(size_t i = 0; i < aggregator->sub_count; i++) {
+        aggregator->offsets[i + 1] += aggregator->offsets[i];
+        aggregator->sub_ids[i].id = betree->config->sub_ids[i];
+        aggregator->sub_ids[i].index = i;
+    }
+    qsort(aggregator->sub_ids,
+        aggregator->sub_count,
+        sizeof(*aggregator->sub_ids),
+        compare_reason_sub_ids);
+    aggregator->reasons = bmalloc(counter_count(aggregator) * sizeof(*aggregator->reasons) + 1);
+    if(aggregator->reasons == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    walk_cnode(aggregator, betree->betree->cnode, fill_sub_reasons);
+    aggregator->shard_count = shard_count == 0 ? 1 : shard_count;
+    aggregator->shards = bcalloc(aggregator->shard_count * sizeof(*aggregator->shards));
+    if(aggregator->shards == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    size_t count = counter_count(aggregator) + aggregator->sub_count;
+    for(size_t i = 0; i < aggregator->shard_count; i++) {
+        aggregator->shards[i] = bcalloc(
+            sizeof(*aggregator->shards[i]) + count * sizeof(*aggregator->shards[i]->counts));
+        if(aggregator->shards[i] == NULL) {
+            fprintf(stderr, "%s bcalloc failed\n", __func__);
+            abort();
+        }
+    }
+    __atomic_fetch_add(&aggregator->config->reason_aggregator_count, 1, __ATOMIC_RELAXED);
+    return aggregator;
+}
+
+void free_reason_aggregator(struct betree_reason_aggregator* aggregator)
+{
+    if(aggregator == NULL) {
+        return;
+    }
+    __atomic_fetch_sub(&aggregator->config->reason_aggregator_count, 1, __ATOMIC_RELAXED);
+    for(size_t i = 0; i < aggregator->shard_count; i++) {
+        bfree(aggregator->shards[i]);
+    }
+    bfree(aggregator->shards);
+    bfree(aggregator->offsets);
+    bfree(aggregator->reasons);
+    bfree(aggregator->sub_ids);
+    bfree(aggregator);
+}
+
+static struct reason_shard* current_shard(const struct betree_reason_aggregator* aggregator)
+{
+    if(thread_shard == SIZE_MAX) {
+        thread_shard = __atomic_fetch_add(&next_shard, 1, __ATOMIC_RELAXED);
+    }
+    return aggregator->shards[thread_shard % aggregator->shard_count];
+}
+
+static size_t find_counter(
+    const struct betree_reason_aggregator* aggregator, uint32_t index, betree_var_t reason)
+{
+    size_t begin = aggregator->offsets[index];
+    size_t end = aggregator->offsets[index + 1];
+    while(begin < end) {
+        size_t middle = begin + (end - begin) / 2;
+        if(aggregator->reasons[middle] < reason) {
+            begin = middle + 1;
+        }
+        else {
+            end = middle;
+        }
+    }
+    if(begin < aggregator->offsets[index + 1] && aggregator->reasons[begin] == reason) {
+        return begin;
+    }
+    return SIZE_MAX;
+}
+
+static void add_reasons(struct betree_reason_aggregator* aggregator,
+    struct reason_shard* shard,
+    struct report_err* report)
+{
+    struct betree_reason_map_t* reasons = report->reason_sub_id_list;
+    for(betree_var_t reason = 0; reason < reasons->size && reason < aggregator->reason_count;
+        reason++) {
+        if(reasons->reasons[reason] == NULL) {
+            continue;
+        }
+        size_t count;
+        const uint32_t* indices = betree_reason_map_indices(reasons, reason, &count);
+        for(size_t i = 0; i < count && indices[i] < aggregator->sub_count; i++) {
+            size_t counter = find_counter(aggregator, indices[i], reason);
+            if(counter != SIZE_MAX) {
+                __atomic_fetch_add(&shard->counts[counter], 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+void reason_aggregator_add(
+    struct betree_reason_aggregator* aggregator, struct report_err* report)
+{
+    struct reason_shard* shard = current_shard(aggregator);
+    __atomic_fetch_add(&shard->events, 1, __ATOMIC_RELAXED);
+    add_reasons(aggregator, shard, report);
+}
+
+void reason_aggregator_add_ids(struct betree_reason_aggregator* aggregator,
+    struct report_err* report,
+    const uint64_t* ids,
+    size_t sz)
+{
+    struct reason_shard* shard = current_shard(aggregator);
+    uint32_t* sub_events = shard->counts + counter_count(aggregator);
+    for(size_t i = 0; i < sz; i++) {
+        struct reason_sub_id key = { .id = ids[i] };
+        const struct reason_sub_id* sub_id = bsearch(&key,
+            aggregator->sub_ids,
+            aggregator->sub_count,
+            sizeof(*aggregator->sub_ids),
+            compare_reason_sub_ids);
+        if(sub_id != NULL) {
+            __atomic_fetch_add(&sub_events[sub_id->index], 1, __ATOMIC_RELAXED);
+        }
+    }
+    add_reasons(aggregator, shard, report);
+}
+
+void reason_aggregator_reset(struct betree_reason_aggregator* aggregator)
+{
+    size_t count = counter_count(aggregator) + aggregator->sub_count;
+    for(size_t i = 0; i < aggregator->shard_count; i++) {
+        struct reason_shard* shard = aggregator->shards[i];
+        __atomic_store_n(&shard->events, 0, __ATOMIC_RELAXED);
+        for(size_t j = 0; j < count; j++) {
+            __atomic_store_n(&shard->counts[j], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+struct betree_reason_snapshot* make_reason_snapshot(
+    const struct betree_reason_aggregator* aggregator)
+{
+    struct betree_reason_snapshot* snapshot = bcalloc(sizeof(*snapshot));
+    if(snapshot == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    snapshot->aggregator = aggregator;
+    snapshot->sub_count = aggregator->sub_count;
+    snapshot->sub_ids = bmalloc(aggregator->sub_count * sizeof(*snapshot->sub_ids));
+    snapshot->events = bcalloc(aggregator->sub_count * sizeof(*snapshot->events));
+    snapshot->counts = bcalloc(counter_count(aggregator) * sizeof(*snapshot->counts));
+    if((snapshot->sub_ids == NULL || snapshot->events == NULL || snapshot->counts == NULL)
+        && aggregator->sub_count != 0) {
+        fprintf(stderr, "%s allocation failed\n", __func__);
+        abort();
+    }
+    memcpy(snapshot->sub_ids,
+        aggregator->config->sub_ids,
+        aggregator->sub_count * sizeof(*snapshot->sub_ids));
+    return snapshot;
+}
+
+void free_reason_snapshot(struct betree_reason_snapshot* snapshot)
+{
+    if(snapshot == NULL) {
+        return;
+    }
+    bfree(snapshot->sub_ids);
+    bfree(snapshot->events);
+    bfree(snapshot->counts);
+    bfree(snapshot);
+}
+
+static uint64_t take_events(uint64_t* events, bool reset)
+{
+    if(reset) {
+        return __atomic_exchange_n(events, 0, __ATOMIC_RELAXED);
+    }
+    return __atomic_load_n(events, __ATOMIC_RELAXED);
+}
+
+static uint32_t take_counter(uint32_t* counter, bool reset)
+{
+    if(reset) {
+        return __atomic_exchange_n(counter, 0, __ATOMIC_RELAXED);
+    }
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+void reason_aggregator_snapshot(struct betree_reason_aggregator* aggregator,
+    struct betree_reason_snapshot* snapshot,
+    bool reset)
+{
+    size_t count = counter_count(aggregator);
+    uint64_t events = 0;
+    memset(snapshot->events, 0, aggregator->sub_count * sizeof(*snapshot->events));
+    memset(snapshot->counts, 0, count * sizeof(*snapshot->counts));
+    for(size_t i = 0; i < aggregator->shard_count; i++) {
+        struct reason_shard* shard = aggregator->shards[i];
+        events += take_events(&shard->events, reset);
+        for(size_t j = 0; j < count; j++) {
+            snapshot->counts[j] += take_counter(&shard->counts[j], reset);
+        }
+        for(size_t j = 0; j < aggregator->sub_count; j++) {
+            snapshot->events[j] += take_counter(&shard->counts[count + j], reset);
+        }
+    }
+    for(size_t j = 0; j < aggregator->sub_count; j++) {
+        snapshot->events[j] += events;
+    }
+}
+
+uint64_t reason_snapshot_events(const struct betree_reason_snapshot* snapshot, uint32_t index)
+{
+    if(index >= snapshot->sub_count) {
+        return 0;
+    }
+    return snapshot->events[index];
+}
+
+uint64_t reason_snapshot_count(
+    const struct betree_reason_snapshot* snapshot, uint32_t index, betree_var_t reason)
+{
+    if(index >= snapshot->sub_count) {
+        return 0;
+    }
+    size_t counter = find_counter(snapshot->aggregator, index, reason);
+    if(counter == SIZE_MAX) {
+        return 0;
+    }
+    return snapshot->counts[counter];
+}
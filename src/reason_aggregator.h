@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "betree_err.h"
+
+/*
+ * Counts, per sub and per reason, how many events a sub failed on across reason searches, and per
+ * sub how many events it was searched for. The tree is walked once when the aggregator is made:
+ * each sub gets a counter for the variables of its expression and for the additional reasons, which
+ * are the only reasons it can fail on. Subs inserted afterwards are not counted, and
+ * betree_make_sub_ids fails while an aggregator is attached since it would renumber the subs.
+ *
+ * Each shard holds the events searched over all subs, then the counters by sub index and reason,
+ * then per sub the events of searches restricted to ids that included it. A thread always adds to
+ * the same shard with atomic adds, so threads only share cache lines when there are more of them
+ * than shards. A snapshot taken while searches run can miss the events being added.
+ *
+ * A shard takes (sub_count * (REASON_ADDITIONAL_MAX + 1) + variable uses) * 4 bytes, e.g. 8 shards
+ * of 100k subs using 10 variables each take 45MB. Counters are 32 bits wide, so a snapshot with
+ * reset must be taken before a shard counts 2^32 events.
+ */
+struct reason_shard {
+    uint64_t events;
+    uint32_t counts[];
+};
+
+struct reason_sub_id {
+    betree_sub_t id;
+    uint32_t index;
+};
+
+struct betree_reason_aggregator {
+    struct config* config;
+    size_t sub_count;
+    size_t reason_count;
+    // The counters of sub index i are offsets[i] to offsets[i + 1], one per reason in reasons
+    uint32_t* offsets;
+    uint32_t* reasons;
+    // Sorted by id, for searches restricted to ids
+    struct reason_sub_id* sub_ids;
+    size_t shard_count;
+    struct reason_shard** shards;
+};
+
+// Counts by the layout of its aggregator, which must outlive it
+struct betree_reason_snapshot {
+    const struct betree_reason_aggregator* aggregator;
+    size_t sub_count;
+    uint64_t* sub_ids;
+    uint64_t* events;
+    uint64_t* counts;
+};
+
+struct betree_reason_aggregator* make_reason_aggregator(
+    const struct betree_err* betree, size_t shard_count);
+void free_reason_aggregator(struct betree_reason_aggregator* aggregator);
+
+// Counts one event from a report filled by a reason search over all subs
+void reason_aggregator_add(
+    struct betree_reason_aggregator* aggregator, struct report_err* report);
+// Same for a search restricted to ids, only those subs count the event
+void reason_aggregator_add_ids(struct betree_reason_aggregator* aggregator,
+    struct report_err* report,
+    const uint64_t* ids,
+    size_t sz);
+void reason_aggregator_reset(struct betree_reason_aggregator* aggregator);
+
+struct betree_reason_snapshot* make_reason_snapshot(
+    const struct betree_reason_aggregator* aggregator);
+void free_reason_snapshot(struct betree_reason_snapshot* snapshot);
+// Sums the shards into snapshot, with reset the counters taken are zeroed in the same pass
+void reason_aggregator_snapshot(struct betree_reason_aggregator* aggregator,
+    struct betree_reason_snapshot* snapshot,
+    bool reset);
+uint64_t reason_snapshot_events(const struct betree_reason_snapshot* snapshot, uint32_t index);
+uint64_t reason_snapshot_count(
+    const struct betree_reason_snapshot* snapshot, uint32_t index, betree_var_t reason);
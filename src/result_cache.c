@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "config.h"
+#include "result_cache.h"
+#include "tree.h"
+
+static const size_t NO_ENTRY = SIZE_MAX;
+
+struct betree_result_cache* make_result_cache(const struct config* config, size_t capacity)
+{
+    struct betree_result_cache* cache = bcalloc(sizeof(*cache));
+    if(cache == NULL) {
+        fprintf(stderr, "%s bcalloc failed\n", __func__);
+        abort();
+    }
+    cache->version = config->version;
+    cache->attr_count = config->attr_domain_count;
+    cache->volatile_vars = bcalloc(cache->attr_count * sizeof(*cache->volatile_vars) + 1);
+    cache->capacity = capacity == 0 ? 1 : capacity;
+    cache->entries = bcalloc(cache->capacity * sizeof(*cache->entries));
+    cache->bucket_count = 1;
+    while(cache->bucket_count < cache->capacity * 2) {
+        cache->bucket_count *= 2;
+    }
+    cache->buckets = bmalloc(cache->bucket_count * sizeof(*cache->buckets));
+    if(cache->volatile_vars == NULL || cache->entries == NULL || cache->buckets == NULL) {
+        fprintf(stderr, "%s allocation failed\n", __func__);
+        abort();
+    }
+    for(size_t i = 0; i < cache->bucket_count; i++) {
+        cache->buckets[i] = NO_ENTRY;
+    }
+    cache->lru_head = NO_ENTRY;
+    cache->lru_tail = NO_ENTRY;
+    return cache;
+}
+
+void clear_result_cache(struct betree_result_cache* cache)
+{
+    for(size_t i = 0; i < cache->count; i++) {
+        bfree(cache->entries[i].key);
+        bfree(cache->entries[i].subs);
+        cache->entries[i].key = NULL;
+        cache->entries[i].subs = NULL;
+    }
+    for(size_t i = 0; i < cache->bucket_count; i++) {
+        cache->buckets[i] = NO_ENTRY;
+    }
+    cache->count = 0;
+    cache->lru_head = NO_ENTRY;
+    cache->lru_tail = NO_ENTRY;
+}
+
+void free_result_cache(struct betree_result_cache* cache)
+{
+    if(cache == NULL) {
+        return;
+    }
+    clear_result_cache(cache);
+    bfree(cache->volatile_vars);
+    bfree(cache->entries);
+    bfree(cache->buckets);
+    bfree(cache->buffer);
+    bfree(cache);
+}
+
+static void write_bytes(struct betree_result_cache* cache, const void* bytes, size_t size)
+{
+    if(cache->buffer_size + size > cache->buffer_capacity) {
+        size_t capacity = cache->buffer_capacity == 0 ? 256 : cache->buffer_capacity;
+        while(cache->buffer_size + size > capacity) {
+            capacity *= 2;
+        }
+        unsigned char* buffer = brealloc(cache->buffer, capacity);
+        if(buffer == NULL) {
+            fprintf(stderr, "%s brealloc failed\n", __func__);
+            abort();
+        }
+        cache->buffer = buffer;
+        cache->buffer_capacity = capacity;
+    }
+    memcpy(cache->buffer + cache->buffer_size, bytes, size);
+    cache->buffer_size += size;
+}
+
+static void write_u64(struct betree_result_cache* cache, uint64_t value)
+{
+    write_bytes(cache, &value, sizeof(value));
+}
+
+static void write_string(struct betree_result_cache* cache, const char* string)
+{
+    size_t length = strlen(string);
+    write_u64(cache, length);
+    write_bytes(cache, string, length);
+}
+
+static void write_value(struct betree_result_cache* cache, const struct value* value)
+{
+    write_u64(cache, value->value_type);
+    switch(value->value_type) {
+        case BETREE_BOOLEAN:
+            write_u64(cache, value->boolean_value);
+            break;
+        case BETREE_INTEGER:
+            write_u64(cache, (uint64_t)value->integer_value);
+            break;
+        case BETREE_FLOAT:
+            write_bytes(cache, &value->float_value, sizeof(value->float_value));
+            break;
+        case BETREE_STRING:
+            write_string(cache, value->string_value.string);
+            break;
+        case BETREE_INTEGER_ENUM:
+            write_u64(cache, (uint64_t)value->integer_enum_value.integer);
+            break;
+        case BETREE_INTEGER_LIST:
+            write_u64(cache, value->integer_list_value->count);
+            write_bytes(cache,
+                value->integer_list_value->integers,
+                value->integer_list_value->count * sizeof(*value->integer_list_value->integers));
+            break;
+        case BETREE_STRING_LIST:
+            write_u64(cache, value->string_list_value->count);
+            for(size_t i = 0; i < value->string_list_value->count; i++) {
+                write_string(cache, value->string_list_value->strings[i].string);
+            }
+            break;
+        case BETREE_SEGMENTS:
+            write_u64(cache, value->segments_value->size);
+            for(size_t i = 0; i < value->segments_value->size; i++) {
+                write_u64(cache, (uint64_t)value->segments_value->ids[i]);
+                write_u64(cache, (uint64_t)value->segments_value->timestamps[i]);
+            }
+            break;
+        case BETREE_FREQUENCY_CAPS:
+            write_u64(cache, value->frequency_caps_value->size);
+            for(size_t i = 0; i < value->frequency_caps_value->size; i++) {
+                const struct betree_frequency_cap* cap = value->frequency_caps_value->content[i];
+                write_u64(cache, cap->type);
+                write_u64(cache, cap->id);
+                write_string(cache, cap->namespace.string);
+                write_u64(cache, cap->timestamp_defined);
+                write_u64(cache, (uint64_t)cap->timestamp);
+                write_u64(cache, cap->value);
+            }
+            break;
+        default:
+            abort();
+    }
+}
+
+uint64_t hash_event_key(struct betree_result_cache* cache, const struct betree_variable** preds)
+{
+    cache->buffer_size = 0;
+    for(size_t i = 0; i < cache->attr_count; i++) {
+        if(preds[i] == NULL || cache->volatile_vars[i]) {
+            continue;
+        }
+        write_u64(cache, i);
+        write_value(cache, &preds[i]->value);
+    }
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for(size_t i = 0; i < cache->buffer_size; i++) {
+        hash ^= cache->buffer[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static void lru_unlink(struct betree_result_cache* cache, size_t index)
+{
+    struct result_cache_entry* entry = &cache->entries[index];
+    if(entry->lru_prev != NO_ENTRY) {
+        cache->entries[entry->lru_prev].lru_next = entry->lru_next;
+    }
+    else {
+        cache->lru_head = entry->lru_next;
+    }
+    if(entry->lru_next != NO_ENTRY) {
+        cache->entries[entry->lru_next].lru_prev = entry->lru_prev;
+    }
+    else {
+        cache->lru_tail = entry->lru_prev;
+    }
+}
+
+static void lru_push_front(struct betree_result_cache* cache, size_t index)
+{
+    struct result_cache_entry* entry = &cache->entries[index];
+    entry->lru_prev = NO_ENTRY;
+    entry->lru_next = cache->lru_head;
+    if(cache->lru_head != NO_ENTRY) {
+        cache->entries[cache->lru_head].lru_prev = index;
+    }
+    cache->lru_head = index;
+    if(cache->lru_tail == NO_ENTRY) {
+        cache->lru_tail = index;
+    }
+}
+
+const struct result_cache_entry* find_result(struct betree_result_cache* cache, uint64_t hash)
+{
+    size_t index = cache->buckets[hash & (cache->bucket_count - 1)];
+    while(index != NO_ENTRY) {
+        struct result_cache_entry* entry = &cache->entries[index];
+        if(entry->hash == hash && entry->key_size == cache->buffer_size
+            && (cache->buffer_size == 0
+                || memcmp(entry->key, cache->buffer, cache->buffer_size) == 0)) {
+            lru_unlink(cache, index);
+            lru_push_front(cache, index);
+            return entry;
+        }
+        index = entry->chain_next;
+    }
+    return NULL;
+}
+
+static void unchain(struct betree_result_cache* cache, size_t index)
+{
+    size_t* link = &cache->buckets[cache->entries[index].hash & (cache->bucket_count - 1)];
+    while(*link != index) {
+        link = &cache->entries[*link].chain_next;
+    }
+    *link = cache->entries[index].chain_next;
+}
+
+void add_result(struct betree_result_cache* cache,
+    uint64_t hash,
+    size_t sub_count,
+    const betree_sub_t* subs)
+{
+    size_t index;
+    if(cache->count < cache->capacity) {
+        index = cache->count;
+        cache->count++;
+    }
+    else {
+        index = cache->lru_tail;
+        lru_unlink(cache, index);
+        unchain(cache, index);
+        bfree(cache->entries[index].key);
+        bfree(cache->entries[index].subs);
+    }
+    struct result_cache_entry* entry = &cache->entries[index];
+    entry->hash = hash;
+    entry->key_size = cache->buffer_size;
+    entry->key = bmalloc(cache->buffer_size + 1);
+    entry->sub_count = sub_count;
+    entry->subs = bmalloc(sub_count * sizeof(*entry->subs) + 1);
+    if(entry->key == NULL || entry->subs == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    if(cache->buffer_size != 0) {
+        memcpy(entry->key, cache->buffer, cache->buffer_size);
+    }
+    if(sub_count != 0) {
+        memcpy(entry->subs, subs, sub_count * sizeof(*entry->subs));
+    }
+    size_t bucket = hash & (cache->bucket_count - 1);
+    entry->chain_next = cache->buckets[bucket];
+    cache->buckets[bucket] = index;
+    lru_push_front(cache, index);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "betree.h"
+#include "value.h"
+
+struct config;
+struct betree_variable;
+
+struct result_cache_entry {
+    uint64_t hash;
+    struct {
+        size_t key_size;
+        unsigned char* key;
+    };
+    struct {
+        size_t sub_count;
+        betree_sub_t* subs;
+    };
+    size_t chain_next;
+    size_t lru_prev;
+    size_t lru_next;
+};
+
+struct betree_result_cache {
+    uint64_t version;
+    struct {
+        size_t attr_count;
+        bool* volatile_vars;
+    };
+    struct {
+        size_t capacity;
+        size_t count;
+        struct result_cache_entry* entries;
+    };
+    struct {
+        size_t bucket_count;
+        size_t* buckets;
+    };
+    size_t lru_head;
+    size_t lru_tail;
+    struct {
+        size_t buffer_size;
+        size_t buffer_capacity;
+        unsigned char* buffer;
+    };
+    size_t hits;
+    size_t misses;
+};
+
+struct betree_result_cache* make_result_cache(const struct config* config, size_t capacity);
+void free_result_cache(struct betree_result_cache* cache);
+void clear_result_cache(struct betree_result_cache* cache);
+
+uint64_t hash_event_key(struct betree_result_cache* cache, const struct betree_variable** preds);
+const struct result_cache_entry* find_result(struct betree_result_cache* cache, uint64_t hash);
+void add_result(struct betree_result_cache* cache,
+    uint64_t hash,
+    size_t sub_count,
+    const betree_sub_t* subs);
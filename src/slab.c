@@ -0,0 +1,199 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "slab.h"
+
+#define SLAB_CHUNK_OBJECTS 256
+#define SLAB_HEADER sizeof(struct slab_pool*)
+
+static __thread struct node_slab* current_slab = NULL;
+
+struct node_slab* make_node_slab(const struct betree_allocator* allocator)
+{
+#ifdef NIF
+    // Node memory stays with enif_alloc so the VM accounts for it
+    if(allocator == &default_allocator) {
+        return NULL;
+    }
+#endif
+    struct node_slab* slab = allocator->calloc(allocator->context, sizeof(*slab));
+    if(slab == NULL) {
+        fprintf(stderr, "%s calloc failed\n", __func__);
+        abort();
+    }
+    slab->allocator = *allocator;
+    return slab;
+}
+
+void free_node_slab(struct node_slab* slab)
+{
+    if(slab == NULL) {
+        return;
+    }
+    if(current_slab == slab) {
+        current_slab = NULL;
+    }
+    for(size_t i = 0; i < NODE_KIND_COUNT; i++) {
+        struct slab_chunk* chunk = slab->pools[i].chunks;
+        while(chunk != NULL) {
+            struct slab_chunk* next = chunk->next;
+            slab->allocator.free(slab->allocator.context, chunk);
+            chunk = next;
+        }
+    }
+    struct betree_allocator allocator = slab->allocator;
+    allocator.free(allocator.context, slab);
+}
+
+static void* pool_alloc(struct node_slab* slab, struct slab_pool* pool, size_t size)
+{
+    if(pool->object_size == 0) {
+        pool->object_size = (SLAB_HEADER + size + 7) & ~(size_t)7;
+        pool->used = SLAB_CHUNK_OBJECTS;
+    }
+    if(pool->free_list != NULL) {
+        void* block = pool->free_list;
+        pool->free_list = *(void**)((unsigned char*)block + SLAB_HEADER);
+        return block;
+    }
+    if(pool->used == SLAB_CHUNK_OBJECTS) {
+        struct slab_chunk* chunk = slab->allocator.malloc(
+            slab->allocator.context, sizeof(*chunk) + SLAB_CHUNK_OBJECTS * pool->object_size);
+        if(chunk == NULL) {
+            fprintf(stderr, "%s malloc failed\n", __func__);
+            abort();
+        }
+        chunk->next = pool->chunks;
+        pool->chunks = chunk;
+        pool->used = 0;
+        slab->chunk_count++;
+    }
+    void* block = pool->chunks->data + pool->used * pool->object_size;
+    pool->used++;
+    return block;
+}
+
+void* slab_calloc(struct node_slab* slab, enum node_kind_e kind, size_t size)
+{
+    unsigned char* block;
+    struct slab_pool* pool = NULL;
+    if(slab == NULL) {
+        block = bmalloc(SLAB_HEADER + size);
+        if(block == NULL) {
+            return NULL;
+        }
+    }
+    else {
+        pool = &slab->pools[kind];
+        if(pool->object_size != 0 && pool->object_size < SLAB_HEADER + size) {
+            fprintf(stderr, "%s object size mismatch for kind %d\n", __func__, kind);
+            abort();
+        }
+        block = pool_alloc(slab, pool, size);
+    }
+    *(struct slab_pool**)block = pool;
+    void* ptr = block + SLAB_HEADER;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+static struct node_slab* heap_slab(struct slab_pool* pool)
+{
+    return (struct node_slab*)((unsigned char*)pool - offsetof(struct node_slab, heap));
+}
+
+void slab_free(void* ptr)
+{
+    if(ptr == NULL) {
+        return;
+    }
+    unsigned char* block = (unsigned char*)ptr - SLAB_HEADER;
+    struct slab_pool* pool = *(struct slab_pool**)block;
+    if(pool == NULL) {
+        bfree(block);
+        return;
+    }
+    if(pool->object_size == 0) {
+        struct node_slab* slab = heap_slab(pool);
+        slab->allocator.free(slab->allocator.context, block);
+        return;
+    }
+    *(void**)ptr = pool->free_list;
+    pool->free_list = block;
+}
+
+void* slab_malloc(struct node_slab* slab, size_t size)
+{
+    unsigned char* block;
+    struct slab_pool* pool = NULL;
+    if(slab == NULL) {
+        block = bmalloc(SLAB_HEADER + size);
+    }
+    else {
+        pool = &slab->heap;
+        block = slab->allocator.malloc(slab->allocator.context, SLAB_HEADER + size);
+    }
+    if(block == NULL) {
+        return NULL;
+    }
+    *(struct slab_pool**)block = pool;
+    return block + SLAB_HEADER;
+}
+
+void* slab_zalloc(struct node_slab* slab, size_t size)
+{
+    void* ptr = slab_malloc(slab, size);
+    if(ptr != NULL) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void* slab_realloc(struct node_slab* slab, void* ptr, size_t size)
+{
+    if(ptr == NULL) {
+        return slab_malloc(slab, size);
+    }
+    unsigned char* block = (unsigned char*)ptr - SLAB_HEADER;
+    struct slab_pool* pool = *(struct slab_pool**)block;
+    if(pool == NULL) {
+        block = brealloc(block, SLAB_HEADER + size);
+    }
+    else if(pool->object_size == 0) {
+        struct node_slab* origin = heap_slab(pool);
+        block = origin->allocator.realloc(origin->allocator.context, block, SLAB_HEADER + size);
+    }
+    else {
+        fprintf(stderr, "%s cannot resize a node\n", __func__);
+        abort();
+    }
+    if(block == NULL) {
+        return NULL;
+    }
+    return block + SLAB_HEADER;
+}
+
+char* slab_strdup(struct node_slab* slab, const char* string)
+{
+    size_t size = strlen(string) + 1;
+    char* copy = slab_malloc(slab, size);
+    if(copy != NULL) {
+        memcpy(copy, string, size);
+    }
+    return copy;
+}
+
+struct node_slab* use_node_slab(struct node_slab* slab)
+{
+    struct node_slab* previous = current_slab;
+    current_slab = slab;
+    return previous;
+}
+
+struct node_slab* active_node_slab()
+{
+    return current_slab;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "betree.h"
+
+enum node_kind_e {
+    NODE_KIND_CNODE,
+    NODE_KIND_LNODE,
+    NODE_KIND_PDIR,
+    NODE_KIND_PNODE,
+    NODE_KIND_CDIR,
+    NODE_KIND_SUB,
+    NODE_KIND_AST,
+};
+
+#define NODE_KIND_COUNT (NODE_KIND_AST + 1)
+
+struct slab_chunk {
+    struct slab_chunk* next;
+    unsigned char data[];
+};
+
+struct slab_pool {
+    size_t object_size;
+    size_t used;
+    struct slab_chunk* chunks;
+    void* free_list;
+};
+
+// Tree-owned pools of fixed size nodes, one per node kind, released together by free_node_slab
+struct node_slab {
+    struct betree_allocator allocator;
+    struct slab_pool pools[NODE_KIND_COUNT];
+    size_t chunk_count;
+    // Marks variable sized blocks, which go to the allocator one by one
+    struct slab_pool heap;
+};
+
+struct node_slab* make_node_slab(const struct betree_allocator* allocator);
+void free_node_slab(struct node_slab* slab);
+
+// Objects carry their pool in a header, so slab_free needs no context. A NULL slab allocates from
+// the heap.
+void* slab_calloc(struct node_slab* slab, enum node_kind_e kind, size_t size);
+void slab_free(void* ptr);
+
+// Variable sized tree memory (node arrays, names, config tables), also released by slab_free. The
+// slab is only used when allocating, so slab_realloc grows a block where it came from.
+void* slab_malloc(struct node_slab* slab, size_t size);
+void* slab_zalloc(struct node_slab* slab, size_t size);
+void* slab_realloc(struct node_slab* slab, void* ptr, size_t size);
+char* slab_strdup(struct node_slab* slab, const char* string);
+
+// AST nodes are built by the parser, which has no tree at hand
+struct node_slab* use_node_slab(struct node_slab* slab);
+struct node_slab* active_node_slab();
@@ -8,6 +8,27 @@
 #include "special.h"
 #include "utils.h"
 
+static bool within_frequency_cap(
+    const struct betree_frequency_cap* cap, uint32_t value, size_t length, int64_t now)
+{
+    if(cap == NULL) {
+        return true;
+    }
+    if(length <= 0) {
+        return value > cap->value;
+    }
+    if(!cap->timestamp_defined) {
+        return true;
+    }
+    if((now - (cap->timestamp / 1000000)) > (int64_t)length) {
+        return true;
+    }
+    if(value > cap->value) {
+        return true;
+    }
+    return false;
+}
+
 bool within_frequency_caps(const struct betree_frequency_caps* caps,
     enum frequency_type_e type,
     uint32_t id,
@@ -16,27 +37,9 @@ bool within_frequency_caps(const struct betree_frequency_caps* caps,
     size_t length,
     int64_t now)
 {
-    for(size_t i = 0; i < caps->size; i++) {
-        const struct betree_frequency_cap* content = caps->content[i];
-        if(content->id == id &&
-            content->namespace.str == namespace.str &&
-            content->type == type) {
-            if(length <= 0) {
-                return value > content->value;
-            }
-            if(!content->timestamp_defined) {
-                return true;
-            }
-            if((now - (content->timestamp / 1000000)) > (int64_t)length) {
-                return true;
-            }
-            if(value > content->value) {
-                return true;
-            }
-            return false;
-        }
-    }
-    return true;
+    const struct betree_frequency_cap* cap
+        = find_frequency_cap(caps, type, id, namespace.str, NULL);
+    return within_frequency_cap(cap, value, length, now);
 }
 
 bool within_frequency_caps_counting(const struct betree_frequency_caps* caps,
@@ -48,92 +51,88 @@ bool within_frequency_caps_counting(const struct betree_frequency_caps* caps,
     int64_t now,
     int* ops_count)
 {
-    for(size_t i = 0; i < caps->size; i++) {
-        (*ops_count)++;
-        const struct betree_frequency_cap* content = caps->content[i];
-        if(content->id == id && 
-            content->namespace.str == namespace.str &&
-            content->type == type) {
-            if(length <= 0) {
-                return value > content->value;
-            }
-            if(!content->timestamp_defined) {
-                return true;
-            }
-            if((now - (content->timestamp / 1000000)) > (int64_t)length) {
-                return true;
-            }
-            if(value > content->value) {
-                return true;
-            }
-            return false;
+    const struct betree_frequency_cap* cap
+        = find_frequency_cap(caps, type, id, namespace.str, ops_count);
+    return within_frequency_cap(cap, value, length, now);
+}
+
+// Position of the first id not below segment_id in the sorted ids
+static size_t lower_segment(
+    int64_t segment_id, const struct betree_segments* segments, int* ops_count)
+{
+    size_t low = 0, high = segments->size;
+    while(low < high) {
+        if(ops_count != NULL) {
+            (*ops_count)++;
         }
+        size_t middle = low + (high - low) / 2;
+        if(segments->ids[middle] < segment_id) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Position of segment_id in the sorted ids, or the size when it is missing
+static size_t find_segment(
+    int64_t segment_id, const struct betree_segments* segments, int* ops_count)
+{
+    size_t i = lower_segment(segment_id, segments, ops_count);
+    if(i < segments->size && segments->ids[i] == segment_id) {
+        return i;
     }
-    return true;
+    return segments->size;
+}
+
+bool segments_intersect(const struct betree_segments* segments, int64_t min, int64_t max)
+{
+    size_t i = lower_segment(min, segments, NULL);
+    return i < segments->size && segments->ids[i] <= max;
 }
 
 bool segment_within(
     int64_t segment_id, int32_t after_seconds, const struct betree_segments* segments, int64_t now)
 {
-    for(size_t i = 0; i < segments->size; i++) {
-        if(segments->content[i]->id < segment_id) {
-            continue;
-        }
-        if(segments->content[i]->id == segment_id) {
-            return (now - after_seconds) <= (segments->content[i]->timestamp / 1000000);
-        }
+    size_t i = find_segment(segment_id, segments, NULL);
+    if(i == segments->size) {
         return false;
     }
-    return false;
+    return (now - after_seconds) <= (segments->timestamps[i] / 1000000);
 }
 
 bool segment_within_counting(
     int64_t segment_id, int32_t after_seconds, const struct betree_segments* segments, int64_t now,
     int* ops_count)
 {
-    for(size_t i = 0; i < segments->size; i++) {
-        (*ops_count)++;
-        if(segments->content[i]->id < segment_id) {
-            continue;
-        }
-        if(segments->content[i]->id == segment_id) {
-            return (now - after_seconds) <= (segments->content[i]->timestamp / 1000000);
-        }
+    size_t i = find_segment(segment_id, segments, ops_count);
+    if(i == segments->size) {
         return false;
     }
-    return false;
+    return (now - after_seconds) <= (segments->timestamps[i] / 1000000);
 }
 
 bool segment_before(
     int64_t segment_id, int32_t before_seconds, const struct betree_segments* segments, int64_t now)
 {
-    for(size_t i = 0; i < segments->size; i++) {
-        if(segments->content[i]->id < segment_id) {
-            continue;
-        }
-        if(segments->content[i]->id == segment_id) {
-            return (now - before_seconds) > (segments->content[i]->timestamp / 1000000);
-        }
+    size_t i = find_segment(segment_id, segments, NULL);
+    if(i == segments->size) {
         return false;
     }
-    return false;
+    return (now - before_seconds) > (segments->timestamps[i] / 1000000);
 }
 
 bool segment_before_counting(
     int64_t segment_id, int32_t before_seconds, const struct betree_segments* segments, int64_t now,
     int* ops_count)
 {
-    for(size_t i = 0; i < segments->size; i++) {
-        (*ops_count)++;
-        if(segments->content[i]->id < segment_id) {
-            continue;
-        }
-        if(segments->content[i]->id == segment_id) {
-            return (now - before_seconds) > (segments->content[i]->timestamp / 1000000);
-        }
+    size_t i = find_segment(segment_id, segments, ops_count);
+    if(i == segments->size) {
         return false;
     }
-    return false;
+    return (now - before_seconds) > (segments->timestamps[i] / 1000000);
 }
 
 #define EARTH_RADIUS 6372.8
@@ -152,31 +151,126 @@ bool geo_within_radius(double lat1, double lon1, double lat2, double lon2, doubl
     return (asin(sqrt(dx * dx + dy * dy + dz * dz) / 2) * 2 * EARTH_RADIUS) <= distance;
 }
 
-bool contains(const char* value, const char* pattern)
+// In degrees, keeps rounding in the distance from dropping points right on the circle
+#define GEO_BOX_SLACK 1e-6
+
+/*
+ * The boxes hold every point of the circle as long as the coordinates are in range: the latitude
+ * can't move by more than the radius' angle and, away from the poles, the longitude can't move by
+ * more than asin(sin(angle) / cos(latitude)).
+ */
+void init_geo_circle(struct ast_special_geo* geo)
+{
+    double latitude = geo->latitude * TO_RAD, longitude = geo->longitude * TO_RAD;
+    geo->sin_latitude = sin(latitude);
+    geo->cos_latitude = cos(latitude);
+    geo->sin_longitude = sin(longitude);
+    geo->cos_longitude = cos(longitude);
+    geo->has_latitude_box = false;
+    geo->has_longitude_box = false;
+    if(!(geo->latitude >= -90 && geo->latitude <= 90 && geo->radius >= 0)) {
+        return;
+    }
+    double angle = geo->radius / EARTH_RADIUS;
+    double degrees = angle / TO_RAD;
+    geo->has_latitude_box = true;
+    geo->latitude_min = fmax(geo->latitude - degrees - GEO_BOX_SLACK, -90);
+    geo->latitude_max = fmin(geo->latitude + degrees + GEO_BOX_SLACK, 90);
+    if(fabs(geo->latitude) + degrees < 90) {
+        geo->has_longitude_box = true;
+        geo->longitude_delta = asin(sin(angle) / geo->cos_latitude) / TO_RAD + GEO_BOX_SLACK;
+    }
+}
+
+struct geo_point {
+    bool defined;
+    double latitude;
+    double longitude;
+    double sin_latitude;
+    double cos_latitude;
+    double sin_longitude;
+    double cos_longitude;
+};
+
+// Every geo predicate of an event is checked against the same point
+static __thread struct geo_point geo_point;
+
+bool geo_within_circle(const struct ast_special_geo* geo, double latitude, double longitude)
+{
+    if(geo->has_latitude_box && latitude >= -90 && latitude <= 90) {
+        if(latitude < geo->latitude_min || latitude > geo->latitude_max) {
+            return false;
+        }
+        if(geo->has_longitude_box) {
+            double delta = fmod(fabs(longitude - geo->longitude), 360);
+            if(delta > 180) {
+                delta = 360 - delta;
+            }
+            if(delta > geo->longitude_delta) {
+                return false;
+            }
+        }
+    }
+    struct geo_point* point = &geo_point;
+    if(!point->defined || memcmp(&point->latitude, &latitude, sizeof(latitude)) != 0
+        || memcmp(&point->longitude, &longitude, sizeof(longitude)) != 0) {
+        point->defined = true;
+        point->latitude = latitude;
+        point->longitude = longitude;
+        point->sin_latitude = sin(latitude * TO_RAD);
+        point->cos_latitude = cos(latitude * TO_RAD);
+        point->sin_longitude = sin(longitude * TO_RAD);
+        point->cos_longitude = cos(longitude * TO_RAD);
+    }
+    // geo_within_radius with the sin and cos of the longitude difference expanded
+    double cos_delta
+        = geo->cos_longitude * point->cos_longitude + geo->sin_longitude * point->sin_longitude;
+    double sin_delta
+        = geo->sin_longitude * point->cos_longitude - geo->cos_longitude * point->sin_longitude;
+    double dz = geo->sin_latitude - point->sin_latitude;
+    double dx = cos_delta * geo->cos_latitude - point->cos_latitude;
+    double dy = sin_delta * geo->cos_latitude;
+
+    return (asin(sqrt(dx * dx + dy * dy + dz * dz) / 2) * 2 * EARTH_RADIUS) <= geo->radius;
+}
+
+bool contains(const char* value, size_t value_size, const char* pattern, size_t pattern_size)
 {
-    return strstr(value, pattern) != NULL;
+    if(pattern_size == 0) {
+        return true;
+    }
+    if(value_size < pattern_size) {
+        return false;
+    }
+    const char* last = value + value_size - pattern_size;
+    for(const char* candidate = value; candidate <= last; candidate++) {
+        candidate = memchr(candidate, pattern[0], last - candidate + 1);
+        if(candidate == NULL) {
+            return false;
+        }
+        if(memcmp(candidate + 1, pattern + 1, pattern_size - 1) == 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
-bool starts_with(const char* value, const char* pattern)
+bool starts_with(const char* value, size_t value_size, const char* pattern, size_t pattern_size)
 {
-    size_t value_size = strlen(value);
-    size_t pattern_size = strlen(pattern);
     if(value_size < pattern_size) {
         return false;
     }
 
-    return strncmp(value, pattern, pattern_size) == 0;
+    return memcmp(value, pattern, pattern_size) == 0;
 }
 
-bool ends_with(const char* value, const char* pattern)
+bool ends_with(const char* value, size_t value_size, const char* pattern, size_t pattern_size)
 {
-    size_t value_size = strlen(value);
-    size_t pattern_size = strlen(pattern);
     if(value_size < pattern_size) {
         return false;
     }
 
     size_t off = value_size - pattern_size;
-    return strncmp(value + off, pattern, pattern_size) == 0;
+    return memcmp(value + off, pattern, pattern_size) == 0;
 }
 
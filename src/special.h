@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "ast.h"
 #include "tree.h"
 
 bool within_frequency_caps(const struct betree_frequency_caps* caps,
@@ -30,7 +31,11 @@ bool segment_before(
 bool segment_before_counting(
     int64_t segment_id, int32_t before_seconds, const struct betree_segments* segments, int64_t now,
     int* ops_count);
+// Whether one of the segments' ids is within [min, max]
+bool segments_intersect(const struct betree_segments* segments, int64_t min, int64_t max);
 bool geo_within_radius(double lat1, double lon1, double lat2, double lon2, double distance);
-bool contains(const char* value, const char* pattern);
-bool starts_with(const char* value, const char* pattern);
-bool ends_with(const char* value, const char* pattern);
+void init_geo_circle(struct ast_special_geo* geo);
+bool geo_within_circle(const struct ast_special_geo* geo, double latitude, double longitude);
+bool contains(const char* value, size_t value_size, const char* pattern, size_t pattern_size);
+bool starts_with(const char* value, size_t value_size, const char* pattern, size_t pattern_size);
+bool ends_with(const char* value, size_t value_size, const char* pattern, size_t pattern_size);
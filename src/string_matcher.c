@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "ast.h"
+#include "string_matcher.h"
+#include "var.h"
+
+static void init_trie(struct string_trie* trie)
+{
+    trie->node_count = 0;
+    memset(trie->root_children, 0, sizeof(trie->root_children));
+}
+
+static uint32_t add_trie_node(struct string_trie* trie, unsigned char byte)
+{
+    if(trie->node_count == trie->node_capacity) {
+        size_t capacity = trie->node_capacity == 0 ? 16 : trie->node_capacity * 2;
+        struct trie_node* nodes = brealloc(trie->nodes, capacity * sizeof(*nodes));
+        if(nodes == NULL) {
+            fprintf(stderr, "%s brealloc failed\n", __func__);
+            abort();
+        }
+        trie->nodes = nodes;
+        trie->node_capacity = capacity;
+    }
+    uint32_t index = trie->node_count;
+    trie->nodes[index] = (struct trie_node) { .byte = byte, .memoize_id = INVALID_PRED };
+    trie->node_count++;
+    return index;
+}
+
+// The root is node 0, so 0 also means no child
+static uint32_t find_child(const struct string_trie* trie, uint32_t node, unsigned char byte)
+{
+    if(node == 0) {
+        return trie->root_children[byte];
+    }
+    for(uint32_t child = trie->nodes[node].first_child; child != 0;
+        child = trie->nodes[child].next_sibling) {
+        if(trie->nodes[child].byte == byte) {
+            return child;
+        }
+    }
+    return 0;
+}
+
+// False when an equal pattern already ends on the same node, it is then left out of the matcher
+static bool add_trie_pattern(struct string_trie* trie,
+    const char* pattern,
+    size_t length,
+    bool reversed,
+    betree_pred_t memoize_id)
+{
+    if(trie->node_count == 0) {
+        add_trie_node(trie, 0);
+    }
+    uint32_t node = 0;
+    for(size_t i = 0; i < length; i++) {
+        unsigned char byte = pattern[reversed ? length - 1 - i : i];
+        uint32_t child = find_child(trie, node, byte);
+        if(child == 0) {
+            child = add_trie_node(trie, byte);
+            if(node == 0) {
+                trie->root_children[byte] = child;
+            }
+            else {
+                trie->nodes[child].next_sibling = trie->nodes[node].first_child;
+                trie->nodes[node].first_child = child;
+            }
+        }
+        node = child;
+    }
+    if(trie->nodes[node].memoize_id != INVALID_PRED) {
+        return false;
+    }
+    trie->nodes[node].memoize_id = memoize_id;
+    return true;
+}
+
+static void link_trie(struct string_trie* trie)
+{
+    if(trie->node_count == 0) {
+        return;
+    }
+    uint32_t* queue = bmalloc(trie->node_count * sizeof(*queue));
+    if(queue == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    size_t head = 0, tail = 0;
+    for(size_t byte = 0; byte < 256; byte++) {
+        uint32_t child = trie->root_children[byte];
+        if(child != 0) {
+            trie->nodes[child].fail = 0;
+            trie->nodes[child].output = 0;
+            queue[tail++] = child;
+        }
+    }
+    while(head < tail) {
+        uint32_t node = queue[head++];
+        for(uint32_t child = trie->nodes[node].first_child; child != 0;
+            child = trie->nodes[child].next_sibling) {
+            unsigned char byte = trie->nodes[child].byte;
+            uint32_t fail = trie->nodes[node].fail;
+            while(fail != 0 && find_child(trie, fail, byte) == 0) {
+                fail = trie->nodes[fail].fail;
+            }
+            fail = find_child(trie, fail, byte);
+            trie->nodes[child].fail = fail;
+            trie->nodes[child].output
+                = trie->nodes[fail].memoize_id != INVALID_PRED && fail != 0
+                ? fail
+                : trie->nodes[fail].output;
+            queue[tail++] = child;
+        }
+    }
+    bfree(queue);
+}
+
+static void free_trie(struct string_trie* trie)
+{
+    bfree(trie->nodes);
+}
+
+static int memoize_id_cmp(const void* a, const void* b)
+{
+    betree_pred_t x = *(const betree_pred_t*)a;
+    betree_pred_t y = *(const betree_pred_t*)b;
+    if(x == y) {
+        return 0;
+    }
+    return x < y ? -1 : 1;
+}
+
+static void build_masks(struct string_matcher* matcher, betree_pred_t* ids, size_t id_count)
+{
+    struct memoize_mask* masks = brealloc(matcher->masks, id_count * sizeof(*masks));
+    if(masks == NULL && id_count != 0) {
+        fprintf(stderr, "%s brealloc failed\n", __func__);
+        abort();
+    }
+    qsort(ids, id_count, sizeof(*ids), memoize_id_cmp);
+    size_t count = 0;
+    for(size_t i = 0; i < id_count; i++) {
+        size_t word = ids[i] / 64;
+        if(count == 0 || masks[count - 1].word != word) {
+            masks[count] = (struct memoize_mask) { .word = word, .mask = 0 };
+            count++;
+        }
+        masks[count - 1].mask |= 1ULL << (ids[i] % 64);
+    }
+    matcher->masks = masks;
+    matcher->mask_count = count;
+}
+
+static void build_string_matcher(struct string_matcher* matcher)
+{
+    init_trie(&matcher->contains);
+    init_trie(&matcher->starts_with);
+    init_trie(&matcher->ends_with);
+    betree_pred_t* ids = bmalloc(matcher->pattern_count * sizeof(*ids));
+    if(ids == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    size_t id_count = 0;
+    for(size_t i = 0; i < matcher->pattern_count; i++) {
+        const struct ast_node* node = matcher->patterns[i];
+        const struct ast_special_string* string = &node->special_expr.string;
+        struct string_trie* trie;
+        switch(string->op) {
+            case AST_SPECIAL_CONTAINS:
+                trie = &matcher->contains;
+                break;
+            case AST_SPECIAL_STARTSWITH:
+                trie = &matcher->starts_with;
+                break;
+            case AST_SPECIAL_ENDSWITH:
+                trie = &matcher->ends_with;
+                break;
+            default: abort();
+        }
+        if(add_trie_pattern(trie,
+               string->pattern,
+               string->pattern_length,
+               string->op == AST_SPECIAL_ENDSWITH,
+               node->memoize_id)) {
+            ids[id_count] = node->memoize_id;
+            id_count++;
+        }
+    }
+    link_trie(&matcher->contains);
+    build_masks(matcher, ids, id_count);
+    bfree(ids);
+    matcher->built_count = matcher->pattern_count;
+}
+
+static struct string_matcher* find_string_matcher(
+    struct string_matchers* matchers, betree_var_t var)
+{
+    for(size_t i = 0; i < matchers->count; i++) {
+        if(matchers->matchers[i]->var == var) {
+            return matchers->matchers[i];
+        }
+    }
+    struct string_matcher* matcher = bcalloc(sizeof(*matcher));
+    struct string_matcher** all
+        = brealloc(matchers->matchers, (matchers->count + 1) * sizeof(*all));
+    if(matcher == NULL || all == NULL) {
+        fprintf(stderr, "%s allocation failed\n", __func__);
+        abort();
+    }
+    matcher->var = var;
+    all[matchers->count] = matcher;
+    matchers->matchers = all;
+    matchers->count++;
+    return matcher;
+}
+
+void add_string_pattern(struct string_matchers* matchers, const struct ast_node* node)
+{
+    struct string_matcher* matcher
+        = find_string_matcher(matchers, node->special_expr.string.attr_var.var);
+    const struct ast_node** patterns
+        = brealloc(matcher->patterns, (matcher->pattern_count + 1) * sizeof(*patterns));
+    if(patterns == NULL) {
+        fprintf(stderr, "%s brealloc failed\n", __func__);
+        abort();
+    }
+    patterns[matcher->pattern_count] = node;
+    matcher->patterns = patterns;
+    matcher->pattern_count++;
+    if(matcher->pattern_count >= STRING_MATCHER_MIN_PATTERNS
+        && matcher->pattern_count >= 2 * matcher->built_count) {
+        build_string_matcher(matcher);
+    }
+}
+
+void free_string_matchers(struct string_matchers* matchers)
+{
+    for(size_t i = 0; i < matchers->count; i++) {
+        struct string_matcher* matcher = matchers->matchers[i];
+        free_trie(&matcher->contains);
+        free_trie(&matcher->starts_with);
+        free_trie(&matcher->ends_with);
+        bfree(matcher->masks);
+        bfree(matcher->patterns);
+        bfree(matcher);
+    }
+    bfree(matchers->matchers);
+    matchers->matchers = NULL;
+    matchers->count = 0;
+}
+
+static void pass_pattern(struct memoize* memoize, betree_pred_t memoize_id)
+{
+    clear_bit(memoize->fail, memoize_id);
+    set_bit(memoize->pass, memoize_id);
+}
+
+static void match_prefixes(const struct string_trie* trie,
+    const char* value,
+    size_t length,
+    bool reversed,
+    struct memoize* memoize)
+{
+    if(trie->node_count == 0) {
+        return;
+    }
+    uint32_t node = 0;
+    for(size_t i = 0;; i++) {
+        if(trie->nodes[node].memoize_id != INVALID_PRED) {
+            pass_pattern(memoize, trie->nodes[node].memoize_id);
+        }
+        if(i == length) {
+            return;
+        }
+        node = find_child(trie, node, value[reversed ? length - 1 - i : i]);
+        if(node == 0) {
+            return;
+        }
+    }
+}
+
+static void match_contains(
+    const struct string_trie* trie, const char* value, size_t length, struct memoize* memoize)
+{
+    if(trie->node_count == 0) {
+        return;
+    }
+    if(trie->nodes[0].memoize_id != INVALID_PRED) {
+        pass_pattern(memoize, trie->nodes[0].memoize_id);
+    }
+    uint32_t node = 0;
+    for(size_t i = 0; i < length; i++) {
+        unsigned char byte = value[i];
+        uint32_t child = find_child(trie, node, byte);
+        while(child == 0 && node != 0) {
+            node = trie->nodes[node].fail;
+            child = find_child(trie, node, byte);
+        }
+        node = child;
+        uint32_t output
+            = trie->nodes[node].memoize_id != INVALID_PRED ? node : trie->nodes[node].output;
+        while(output != 0) {
+            pass_pattern(memoize, trie->nodes[output].memoize_id);
+            output = trie->nodes[output].output;
+        }
+    }
+}
+
+void eval_string_matchers(const struct string_matchers* matchers,
+    const struct betree_variable** preds,
+    struct memoize* memoize)
+{
+    for(size_t i = 0; i < matchers->count; i++) {
+        const struct string_matcher* matcher = matchers->matchers[i];
+        struct string_value value;
+        if(matcher->built_count == 0 || !get_string_var(matcher->var, preds, &value)) {
+            continue;
+        }
+        for(size_t j = 0; j < matcher->mask_count; j++) {
+            set_memoize_fail_mask(memoize, matcher->masks[j].word, matcher->masks[j].mask);
+        }
+        match_contains(&matcher->contains, value.string, value.length, memoize);
+        match_prefixes(&matcher->starts_with, value.string, value.length, false, memoize);
+        match_prefixes(&matcher->ends_with, value.string, value.length, true, memoize);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "memoize.h"
+#include "value.h"
+
+struct ast_node;
+struct betree_variable;
+
+/*
+ * Matches the contains, starts_with and ends_with patterns of one string attribute in a single pass
+ * over an event's value: an Aho-Corasick automaton for contains, a trie of the prefixes for
+ * starts_with and one of the reversed suffixes for ends_with. Every pattern node has a memoize id
+ * and the matcher fills its pass or fail bit. The tries are rebuilt from scratch each time the
+ * pattern count doubles, patterns added since the last build are evaluated one by one.
+ */
+#define STRING_MATCHER_MIN_PATTERNS 8
+
+struct trie_node {
+    uint32_t first_child;
+    uint32_t next_sibling;
+    uint32_t fail;
+    // Nearest node on the fail chain where a pattern ends, 0 when none
+    uint32_t output;
+    betree_pred_t memoize_id;
+    unsigned char byte;
+};
+
+struct string_trie {
+    size_t node_count;
+    size_t node_capacity;
+    struct trie_node* nodes;
+    uint32_t root_children[256];
+};
+
+struct memoize_mask {
+    size_t word;
+    uint64_t mask;
+};
+
+struct string_matcher {
+    betree_var_t var;
+    size_t pattern_count;
+    const struct ast_node** patterns;
+    size_t built_count;
+    struct string_trie contains;
+    struct string_trie starts_with;
+    struct string_trie ends_with;
+    size_t mask_count;
+    struct memoize_mask* masks;
+};
+
+struct string_matchers {
+    size_t count;
+    struct string_matcher** matchers;
+};
+
+void add_string_pattern(struct string_matchers* matchers, const struct ast_node* node);
+void free_string_matchers(struct string_matchers* matchers);
+
+void eval_string_matchers(const struct string_matchers* matchers,
+    const struct betree_variable** preds,
+    struct memoize* memoize);
@@ -9,12 +9,18 @@
 #include <string.h>
 
 #include "alloc.h"
+#include "arena.h"
 #include "ast.h"
 #include "betree.h"
+#include "betree_err.h"
 #include "error.h"
+#include "event_reader.h"
 #include "hashmap.h"
 #include "memoize.h"
+#include "pred_cache.h"
 #include "printer.h"
+#include "slab.h"
+#include "special.h"
 #include "tree.h"
 #include "utils.h"
 
@@ -25,7 +31,8 @@ static void search_cdir_ids(const struct attr_domain** attr_domains,
     bool open_left,
     bool open_right,
     const uint64_t* ids,
-    size_t sz);
+    size_t sz,
+    struct betree_reason_map_t* reasons);
 
 static bool is_id_in(uint64_t id, const uint64_t* ids, size_t sz);
 
@@ -75,12 +82,26 @@ static enum short_circuit_e try_short_circuit(
     return SHORT_CIRCUIT_NONE;
 }
 
-bool match_sub(size_t attr_domains_count,
+static betree_var_t short_circuit_fail_var(
+    size_t attr_domains_count, const struct short_circuit* short_circuit, const uint64_t* undefined)
+{
+    size_t count = attr_domains_count / 64 + 1;
+    for(size_t i = 0; i < count; i++) {
+        uint64_t fail = short_circuit->fail[i] & undefined[i];
+        if(fail) {
+            return i * 64 + __builtin_ctzll(fail);
+        }
+    }
+    return INVALID_VAR;
+}
+
+static inline __attribute__((always_inline)) bool match_sub_inner(size_t attr_domains_count,
     const struct betree_variable** preds,
     const struct betree_sub* sub,
     struct report* report,
     struct memoize* memoize,
-    const uint64_t* undefined)
+    const uint64_t* undefined,
+    struct match_reason* reason)
 {
     enum short_circuit_e short_circuit
         = try_short_circuit(attr_domains_count, &sub->short_circuit, undefined);
@@ -92,11 +113,35 @@ bool match_sub(size_t attr_domains_count,
             return true;
         }
         if(short_circuit == SHORT_CIRCUIT_FAIL) {
+            if(reason != NULL) {
+                reason->last
+                    = short_circuit_fail_var(attr_domains_count, &sub->short_circuit, undefined);
+            }
             return false;
         }
     }
-    bool result = match_node(preds, sub->expr, memoize, report);
-    return result;
+    // Eager preds are not evaluated when tracking reasons
+    if((sub->eager_circuit.fail & memoize->eager_fail)
+        || (sub->eager_circuit.pass & memoize->eager_pass)) {
+        if(report != NULL) {
+            report->shorted++;
+        }
+        return false;
+    }
+    if(reason == NULL) {
+        return match_node(preds, sub->expr, memoize, report);
+    }
+    return match_node_with_reason(preds, sub->expr, memoize, report, reason);
+}
+
+bool match_sub(size_t attr_domains_count,
+    const struct betree_variable** preds,
+    const struct betree_sub* sub,
+    struct report* report,
+    struct memoize* memoize,
+    const uint64_t* undefined)
+{
+    return match_sub_inner(attr_domains_count, preds, sub, report, memoize, undefined, NULL);
 }
 
 bool match_sub_counting(size_t attr_domains_count,
@@ -166,13 +211,39 @@ static struct pnode* search_pdir(betree_var_t variable_id, const struct pdir* pd
     return NULL;
 }
 
-static void search_cdir(const struct attr_domain** attr_domains,
+static void search_cdir_untracked(const struct attr_domain** attr_domains,
     const struct betree_variable** preds,
     struct cdir* cdir,
     struct subs_to_eval* subs,
     bool open_left,
     bool open_right);
 
+static void search_cdir_tracked(const struct attr_domain** attr_domains,
+    const struct betree_variable** preds,
+    struct cdir* cdir,
+    struct subs_to_eval* subs,
+    bool open_left,
+    bool open_right,
+    struct betree_reason_map_t* reasons);
+
+// Like match_node_inner, searches without reasons walk the tree through their own copy
+static inline __attribute__((always_inline)) void search_cdir(
+    const struct attr_domain** attr_domains,
+    const struct betree_variable** preds,
+    struct cdir* cdir,
+    struct subs_to_eval* subs,
+    bool open_left,
+    bool open_right,
+    struct betree_reason_map_t* reasons)
+{
+    if(reasons == NULL) {
+        search_cdir_untracked(attr_domains, preds, cdir, subs, open_left, open_right);
+    }
+    else {
+        search_cdir_tracked(attr_domains, preds, cdir, subs, open_left, open_right, reasons);
+    }
+}
+
 static void search_cdir_node_counting(const struct attr_domain** attr_domains,
     const struct betree_variable** preds,
     struct cdir* cdir,
@@ -186,10 +257,12 @@ static bool event_contains_variable(const struct betree_variable** preds, betree
     return preds[variable_id] != NULL;
 }
 
-void match_be_tree(const struct attr_domain** attr_domains,
+static inline __attribute__((always_inline)) void match_cnode(
+    const struct attr_domain** attr_domains,
     const struct betree_variable** preds,
     const struct cnode* cnode,
-    struct subs_to_eval* subs)
+    struct subs_to_eval* subs,
+    struct betree_reason_map_t* reasons)
 {
     check_sub(cnode->lnode, subs);
     if(cnode->pdir != NULL) {
@@ -199,19 +272,27 @@ void match_be_tree(const struct attr_domain** attr_domains,
                 = get_attr_domain(attr_domains, pnode->attr_var.var);
             if(attr_domain->allow_undefined
                 || event_contains_variable(preds, pnode->attr_var.var)) {
-                search_cdir(attr_domains, preds, pnode->cdir, subs, true, true);
+                search_cdir(attr_domains, preds, pnode->cdir, subs, true, true, reasons);
             }
         }
     }
 }
 
+void match_be_tree(const struct attr_domain** attr_domains,
+    const struct betree_variable** preds,
+    const struct cnode* cnode,
+    struct subs_to_eval* subs)
+{
+    match_cnode(attr_domains, preds, cnode, subs, NULL);
+}
 
 static void match_be_tree_ids(const struct attr_domain** attr_domains,
     const struct betree_variable** preds,
     const struct cnode* cnode,
     struct subs_to_eval* subs,
     const uint64_t* ids,
-    size_t sz)
+    size_t sz,
+    struct betree_reason_map_t* reasons)
 {
     check_sub_ids(cnode->lnode, subs, ids, sz);
     if(cnode->pdir != NULL) {
@@ -221,7 +302,8 @@ static void match_be_tree_ids(const struct attr_domain** attr_domains,
                 = get_attr_domain(attr_domains, pnode->attr_var.var);
             if(attr_domain->allow_undefined
                 || event_contains_variable(preds, pnode->attr_var.var)) {
-                search_cdir_ids(attr_domains, preds, pnode->cdir, subs, true, true, ids, sz);
+                search_cdir_ids(
+                    attr_domains, preds, pnode->cdir, subs, true, true, ids, sz, reasons);
             }
         }
     }
@@ -302,7 +384,11 @@ static bool is_event_enclosed(
             else {
                 return true;
             }
-        case BETREE_SEGMENTS:
+        case BETREE_SEGMENTS: {
+            int64_t bound_min = open_left ? INT64_MIN : cdir->bound.imin;
+            int64_t bound_max = open_right ? INT64_MAX : cdir->bound.imax;
+            return segments_intersect(pred->value.segments_value, bound_min, bound_max);
+        }
         case BETREE_FREQUENCY_CAPS:
             return true;
         default:
@@ -323,6 +409,7 @@ bool sub_is_enclosed(
         switch(attr_domain->bound.value_type) {
             case(BETREE_INTEGER):
             case(BETREE_INTEGER_LIST):
+            case(BETREE_SEGMENTS):
                 return cdir->bound.imin <= bound.imin && cdir->bound.imax >= bound.imax;
             case(BETREE_FLOAT): {
                 return cdir->bound.fmin <= bound.fmin && cdir->bound.fmax >= bound.fmax;
@@ -334,10 +421,6 @@ bool sub_is_enclosed(
             case(BETREE_STRING_LIST):
             case(BETREE_INTEGER_ENUM):
                 return cdir->bound.smin <= bound.smin && cdir->bound.smax >= bound.smax;
-            case(BETREE_SEGMENTS): {
-                fprintf(stderr, "%s a segments value cdir should never happen for now\n", __func__);
-                abort();
-            }
             case(BETREE_FREQUENCY_CAPS): {
                 fprintf(
                     stderr, "%s a frequency value cdir should never happen for now\n", __func__);
@@ -350,20 +433,137 @@ bool sub_is_enclosed(
     return false;
 }
 
-static void search_cdir(const struct attr_domain** attr_domains,
+static void add_cdir_reason(struct betree_reason_map_t* reasons,
+    betree_var_t reason,
+    const struct cdir* cdir,
+    const uint64_t* ids,
+    size_t sz);
+
+static void add_cnode_reason(struct betree_reason_map_t* reasons,
+    betree_var_t reason,
+    const struct cnode* cnode,
+    const uint64_t* ids,
+    size_t sz)
+{
+    for(size_t i = 0; i < cnode->lnode->sub_count; i++) {
+        const struct betree_sub* sub = cnode->lnode->subs[i];
+        if(ids == NULL || is_id_in(sub->id, ids, sz)) {
+            betree_reason_map_add(reasons, reason, sub->index);
+        }
+    }
+    if(cnode->pdir != NULL) {
+        for(size_t i = 0; i < cnode->pdir->pnode_count; i++) {
+            add_cdir_reason(reasons, reason, cnode->pdir->pnodes[i]->cdir, ids, sz);
+        }
+    }
+}
+
+static void add_cdir_reason(struct betree_reason_map_t* reasons,
+    betree_var_t reason,
+    const struct cdir* cdir,
+    const uint64_t* ids,
+    size_t sz)
+{
+    if(cdir == NULL) {
+        return;
+    }
+    if(ids == NULL && reasons->config->sub_ranges_version == reasons->config->version) {
+        betree_reason_map_add_range(reasons, reason, cdir->sub_begin, cdir->sub_end);
+        return;
+    }
+    add_cnode_reason(reasons, reason, cdir->cnode, ids, sz);
+    add_cdir_reason(reasons, reason, cdir->lchild, ids, sz);
+    add_cdir_reason(reasons, reason, cdir->rchild, ids, sz);
+}
+
+static void number_cdir_subs(struct config* config, struct cdir* cdir);
+
+static void number_cnode_subs(struct config* config, struct cnode* cnode)
+{
+    for(size_t i = 0; i < cnode->lnode->sub_count; i++) {
+        struct betree_sub* sub = cnode->lnode->subs[i];
+        sub->index = config->sub_count;
+        config->sub_ids[config->sub_count] = sub->id;
+        config->sub_count++;
+    }
+    if(cnode->pdir != NULL) {
+        for(size_t i = 0; i < cnode->pdir->pnode_count; i++) {
+            number_cdir_subs(config, cnode->pdir->pnodes[i]->cdir);
+        }
+    }
+}
+
+static void number_cdir_subs(struct config* config, struct cdir* cdir)
+{
+    if(cdir == NULL) {
+        return;
+    }
+    cdir->sub_begin = config->sub_count;
+    number_cnode_subs(config, cdir->cnode);
+    number_cdir_subs(config, cdir->lchild);
+    number_cdir_subs(config, cdir->rchild);
+    cdir->sub_end = config->sub_count;
+}
+
+void number_subs(struct config* config, struct cnode* cnode)
+{
+    config->sub_count = 0;
+    number_cnode_subs(config, cnode);
+    config->sub_ranges_version = config->version;
+}
+
+void add_tree_reason(struct betree_reason_map_t* reasons,
+    betree_var_t reason,
+    const struct cnode* cnode,
+    const uint64_t* ids,
+    size_t sz)
+{
+    add_cnode_reason(reasons, reason, cnode, ids, sz);
+}
+
+static inline __attribute__((always_inline)) void search_cdir_body(
+    const struct attr_domain** attr_domains,
     const struct betree_variable** preds,
     struct cdir* cdir,
     struct subs_to_eval* subs,
     bool open_left,
-    bool open_right)
+    bool open_right,
+    struct betree_reason_map_t* reasons)
 {
-    match_be_tree(attr_domains, preds, cdir->cnode, subs);
+    match_cnode(attr_domains, preds, cdir->cnode, subs, reasons);
     if(is_event_enclosed(preds, cdir->lchild, open_left, false)) {
-        search_cdir(attr_domains, preds, cdir->lchild, subs, open_left, false);
+        search_cdir(attr_domains, preds, cdir->lchild, subs, open_left, false, reasons);
+    }
+    else if(reasons != NULL) {
+        add_cdir_reason(reasons, cdir->attr_var.var, cdir->lchild, NULL, 0);
     }
     if(is_event_enclosed(preds, cdir->rchild, false, open_right)) {
-        search_cdir(attr_domains, preds, cdir->rchild, subs, false, open_right);
+        search_cdir(attr_domains, preds, cdir->rchild, subs, false, open_right, reasons);
     }
+    else if(reasons != NULL) {
+        add_cdir_reason(reasons, cdir->attr_var.var, cdir->rchild, NULL, 0);
+    }
+}
+
+static void search_cdir_untracked(const struct attr_domain** attr_domains,
+    const struct betree_variable** preds,
+    struct cdir* cdir,
+    struct subs_to_eval* subs,
+    bool open_left,
+    bool open_right)
+{
+    search_cdir_body(attr_domains, preds, cdir, subs, open_left, open_right, NULL);
+}
+
+static void search_cdir_tracked(const struct attr_domain** attr_domains,
+    const struct betree_variable** preds,
+    struct cdir* cdir,
+    struct subs_to_eval* subs,
+    bool open_left,
+    bool open_right,
+    struct betree_reason_map_t* reasons)
+{
+    search_cdir_body(attr_domains, preds, cdir, subs, open_left, open_right, reasons);
 }
 
 static void search_cdir_ids(const struct attr_domain** attr_domains,
@@ -373,14 +573,23 @@ static void search_cdir_ids(const struct attr_domain** attr_domains,
     bool open_left,
     bool open_right,
     const uint64_t* ids,
-    size_t sz)
+    size_t sz,
+    struct betree_reason_map_t* reasons)
 {
-    match_be_tree_ids(attr_domains, preds, cdir->cnode, subs, ids, sz);
+    match_be_tree_ids(attr_domains, preds, cdir->cnode, subs, ids, sz, reasons);
     if(is_event_enclosed(preds, cdir->lchild, open_left, false)) {
-        search_cdir_ids(attr_domains, preds, cdir->lchild, subs, open_left, false, ids, sz);
+        search_cdir_ids(
+            attr_domains, preds, cdir->lchild, subs, open_left, false, ids, sz, reasons);
+    }
+    else if(reasons != NULL) {
+        add_cdir_reason(reasons, cdir->attr_var.var, cdir->lchild, ids, sz);
     }
     if(is_event_enclosed(preds, cdir->rchild, false, open_right)) {
-        search_cdir_ids(attr_domains, preds, cdir->rchild, subs, false, open_right, ids, sz);
+        search_cdir_ids(
+            attr_domains, preds, cdir->rchild, subs, false, open_right, ids, sz, reasons);
+    }
+    else if(reasons != NULL) {
+        add_cdir_reason(reasons, cdir->attr_var.var, cdir->rchild, ids, sz);
     }
 }
 
@@ -455,19 +664,21 @@ static bool is_used_cnode(betree_var_t variable_id, const struct cnode* cnode)
     return is_used_cdir(variable_id, cnode->parent);
 }
 
-static void insert_sub(const struct betree_sub* sub, struct lnode* lnode)
+static void insert_sub(
+    const struct config* config, const struct betree_sub* sub, struct lnode* lnode)
 {
     if(lnode->sub_count == 0) {
-        lnode->subs = bcalloc(sizeof(*lnode->subs));
+        lnode->subs = slab_zalloc(config->node_slab, sizeof(*lnode->subs));
         if(lnode->subs == NULL) {
-            fprintf(stderr, "%s bcalloc failed\n", __func__);
+            fprintf(stderr, "%s slab_zalloc failed\n", __func__);
             abort();
         }
     }
     else {
-        struct betree_sub** subs = brealloc(lnode->subs, sizeof(*subs) * (lnode->sub_count + 1));
+        struct betree_sub** subs = slab_realloc(
+            config->node_slab, lnode->subs, sizeof(*subs) * (lnode->sub_count + 1));
         if(subs == NULL) {
-            fprintf(stderr, "%s brealloc failed\n", __func__);
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
             abort();
         }
         lnode->subs = subs;
@@ -513,6 +724,7 @@ static size_t domain_bound_diff(const struct attr_domain* attr_domain)
             return 1;
         case BETREE_INTEGER:
         case BETREE_INTEGER_LIST:
+        case BETREE_SEGMENTS:
             if(b->imin == INT64_MIN && b->imax == INT64_MAX) {
                 return SIZE_MAX;
             }
@@ -530,7 +742,6 @@ static size_t domain_bound_diff(const struct attr_domain* attr_domain)
         case BETREE_STRING_LIST:
         case BETREE_INTEGER_ENUM:
             return b->smax - b->smin;
-        case BETREE_SEGMENTS:
         case BETREE_FREQUENCY_CAPS:
         default:
             abort();
@@ -605,7 +816,7 @@ bool insert_be_tree(const struct config* config,
         }
     }
     if(!foundPartition) {
-        insert_sub(sub, cnode->lnode);
+        insert_sub(config, sub, cnode->lnode);
         if(is_root(cnode)) {
             space_partitioning(config, cnode);
         }
@@ -660,7 +871,7 @@ bool sub_has_attribute_str(struct config* config, const struct betree_sub* sub,
     return sub_has_attribute(sub, variable_id);
 }
 
-static bool remove_sub(betree_sub_t sub, struct lnode* lnode)
+static bool remove_sub(const struct config* config, betree_sub_t sub, struct lnode* lnode)
 {
     for(size_t i = 0; i < lnode->sub_count; i++) {
         const struct betree_sub* lnode_sub = lnode->subs[i];
@@ -670,14 +881,14 @@ static bool remove_sub(betree_sub_t sub, struct lnode* lnode)
             }
             lnode->sub_count--;
             if(lnode->sub_count == 0) {
-                bfree(lnode->subs);
+                slab_free(lnode->subs);
                 lnode->subs = NULL;
             }
             else {
-                struct betree_sub** subs
-                    = brealloc(lnode->subs, sizeof(*lnode->subs) * lnode->sub_count);
+                struct betree_sub** subs = slab_realloc(
+                    config->node_slab, lnode->subs, sizeof(*lnode->subs) * lnode->sub_count);
                 if(subs == NULL) {
-                    fprintf(stderr, "%s brealloc failed\n", __func__);
+                    fprintf(stderr, "%s slab_realloc failed\n", __func__);
                     abort();
                 }
                 lnode->subs = subs;
@@ -688,25 +899,29 @@ static bool remove_sub(betree_sub_t sub, struct lnode* lnode)
     return false;
 }
 
-static void move(const struct betree_sub* sub, struct lnode* origin, struct lnode* destination)
+static void move(const struct config* config,
+    const struct betree_sub* sub,
+    struct lnode* origin,
+    struct lnode* destination)
 {
-    bool isFound = remove_sub(sub->id, origin);
+    bool isFound = remove_sub(config, sub->id, origin);
     if(!isFound) {
         fprintf(stderr, "Could not find sub %" PRIu64 "\n", sub->id);
         abort();
     }
     if(destination->sub_count == 0) {
-        destination->subs = bcalloc(sizeof(*destination->subs));
+        destination->subs = slab_zalloc(config->node_slab, sizeof(*destination->subs));
         if(destination->subs == NULL) {
-            fprintf(stderr, "%s bcalloc failed\n", __func__);
+            fprintf(stderr, "%s slab_zalloc failed\n", __func__);
             abort();
         }
     }
     else {
-        struct betree_sub** subs = brealloc(
-            destination->subs, sizeof(*destination->subs) * (destination->sub_count + 1));
+        struct betree_sub** subs = slab_realloc(config->node_slab,
+            destination->subs,
+            sizeof(*destination->subs) * (destination->sub_count + 1));
         if(subs == NULL) {
-            fprintf(stderr, "%s brealloc failed\n", __func__);
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
             abort();
         }
         destination->subs = subs;
@@ -720,17 +935,19 @@ static struct cdir* create_cdir(const struct config* config,
     betree_var_t variable_id,
     struct value_bound bound)
 {
-    struct cdir* cdir = bcalloc(sizeof(*cdir));
+    struct cdir* cdir = slab_calloc(config->node_slab, NODE_KIND_CDIR, sizeof(*cdir));
     if(cdir == NULL) {
         fprintf(stderr, "%s bcalloc failed\n", __func__);
         abort();
     }
-    cdir->attr_var.attr = bstrdup(attr);
+    cdir->attr_var.attr = slab_strdup(config->node_slab, attr);
     cdir->attr_var.var = variable_id;
     cdir->bound = bound;
     cdir->cnode = make_cnode(config, cdir);
     cdir->lchild = NULL;
     cdir->rchild = NULL;
+    cdir->sub_begin = 0;
+    cdir->sub_end = 0;
     return cdir;
 }
 
@@ -761,7 +978,7 @@ struct pnode* create_pdir(
     }
     struct pdir* pdir = cnode->pdir;
     if(cnode->pdir == NULL) {
-        pdir = bcalloc(sizeof(*pdir));
+        pdir = slab_calloc(config->node_slab, NODE_KIND_PDIR, sizeof(*pdir));
         if(pdir == NULL) {
             fprintf(stderr, "%s pdir bcalloc failed\n", __func__);
             abort();
@@ -772,14 +989,14 @@ struct pnode* create_pdir(
         cnode->pdir = pdir;
     }
 
-    struct pnode* pnode = bcalloc(sizeof(*pnode));
+    struct pnode* pnode = slab_calloc(config->node_slab, NODE_KIND_PNODE, sizeof(*pnode));
     if(pnode == NULL) {
         fprintf(stderr, "%s pnode bcalloc failed\n", __func__);
         abort();
     }
     pnode->cdir = NULL;
     pnode->parent = pdir;
-    pnode->attr_var.attr = bstrdup(attr);
+    pnode->attr_var.attr = slab_strdup(config->node_slab, attr);
     pnode->attr_var.var = variable_id;
     pnode->score = 0.f;
     struct value_bound bound;
@@ -799,16 +1016,17 @@ struct pnode* create_pdir(
     pnode->cdir = create_cdir_with_pnode_parent(config, pnode, bound);
 
     if(pdir->pnode_count == 0) {
-        pdir->pnodes = bcalloc(sizeof(*pdir->pnodes));
+        pdir->pnodes = slab_zalloc(config->node_slab, sizeof(*pdir->pnodes));
         if(pdir->pnodes == NULL) {
-            fprintf(stderr, "%s pnodes bcalloc failed\n", __func__);
+            fprintf(stderr, "%s pnodes slab_zalloc failed\n", __func__);
             abort();
         }
     }
     else {
-        struct pnode** pnodes = brealloc(pdir->pnodes, sizeof(*pnodes) * (pdir->pnode_count + 1));
+        struct pnode** pnodes = slab_realloc(
+            config->node_slab, pdir->pnodes, sizeof(*pnodes) * (pdir->pnode_count + 1));
         if(pnodes == NULL) {
-            fprintf(stderr, "%s brealloc failed\n", __func__);
+            fprintf(stderr, "%s slab_realloc failed\n", __func__);
             abort();
         }
         pdir->pnodes = pnodes;
@@ -888,6 +1106,7 @@ static bool splitable_attr_domain(
     switch(attr_domain->bound.value_type) {
         case BETREE_INTEGER:
         case BETREE_INTEGER_LIST:
+        case BETREE_SEGMENTS:
             if(attr_domain->bound.imin == INT64_MIN || attr_domain->bound.imax == INT64_MAX) {
                 return false;
             }
@@ -909,7 +1128,6 @@ static bool splitable_attr_domain(
             }
             return (attr_domain->bound.smax - attr_domain->bound.smin)
                 < config->max_domain_for_split;
-        case BETREE_SEGMENTS:
         case BETREE_FREQUENCY_CAPS:
             return false;
         default:
@@ -995,7 +1213,7 @@ static void space_partitioning(const struct config* config, struct cnode* cnode)
             const struct betree_sub* sub = lnode->subs[i];
             if(sub_has_attribute(sub, var)) {
                 struct cdir* cdir = insert_cdir(config, sub, pnode->cdir);
-                move(sub, lnode, cdir->cnode->lnode);
+                move(config, sub, lnode, cdir->cnode->lnode);
                 i--;
             }
         }
@@ -1009,6 +1227,7 @@ static bool is_atomic(const struct cdir* cdir)
     switch(cdir->bound.value_type) {
         case(BETREE_INTEGER):
         case(BETREE_INTEGER_LIST):
+        case(BETREE_SEGMENTS):
             return cdir->bound.imin == cdir->bound.imax;
         case(BETREE_FLOAT): {
             return feq(cdir->bound.fmin, cdir->bound.fmax);
@@ -1020,10 +1239,6 @@ static bool is_atomic(const struct cdir* cdir)
         case(BETREE_STRING_LIST):
         case(BETREE_INTEGER_ENUM):
             return cdir->bound.smin == cdir->bound.smax;
-        case(BETREE_SEGMENTS): {
-            fprintf(stderr, "%s a segments value cdir should never happen for now\n", __func__);
-            abort();
-        }
         case(BETREE_FREQUENCY_CAPS): {
             fprintf(stderr, "%s a frequency value cdir should never happen for now\n", __func__);
             abort();
@@ -1035,7 +1250,7 @@ static bool is_atomic(const struct cdir* cdir)
 
 struct lnode* make_lnode(const struct config* config, struct cnode* parent)
 {
-    struct lnode* lnode = bcalloc(sizeof(*lnode));
+    struct lnode* lnode = slab_calloc(config->node_slab, NODE_KIND_LNODE, sizeof(*lnode));
     if(lnode == NULL) {
         fprintf(stderr, "%s bcalloc failed\n", __func__);
         abort();
@@ -1049,7 +1264,7 @@ struct lnode* make_lnode(const struct config* config, struct cnode* parent)
 
 struct cnode* make_cnode(const struct config* config, struct cdir* parent)
 {
-    struct cnode* cnode = bcalloc(sizeof(*cnode));
+    struct cnode* cnode = slab_calloc(config->node_slab, NODE_KIND_CNODE, sizeof(*cnode));
     if(cnode == NULL) {
         fprintf(stderr, "%s bcalloc failed\n", __func__);
         abort();
@@ -1071,7 +1286,8 @@ static struct value_bounds split_value_bound(struct value_bound bound)
     struct value_bound rbound = { .value_type = bound.value_type };
     switch(bound.value_type) {
         case(BETREE_INTEGER):
-        case(BETREE_INTEGER_LIST): {
+        case(BETREE_INTEGER_LIST):
+        case(BETREE_SEGMENTS): {
             int64_t start = bound.imin, end = bound.imax;
             lbound.imin = start;
             rbound.imax = end;
@@ -1159,10 +1375,6 @@ static struct value_bounds split_value_bound(struct value_bound bound)
             }
             break;
         }
-        case(BETREE_SEGMENTS): {
-            fprintf(stderr, "%s a segment value cdir should never happen for now\n", __func__);
-            abort();
-        }
         case(BETREE_FREQUENCY_CAPS): {
             fprintf(stderr, "%s a frequency value cdir should never happen for now\n", __func__);
             abort();
@@ -1194,12 +1406,12 @@ static void space_clustering(const struct config* config, struct cdir* cdir)
             const struct betree_sub* sub = lnode->subs[i];
             if(sub_is_enclosed(
                    (const struct attr_domain**)config->attr_domains, sub, cdir->lchild)) {
-                move(sub, lnode, cdir->lchild->cnode->lnode);
+                move(config, sub, lnode, cdir->lchild->cnode->lnode);
                 i--;
             }
             else if(sub_is_enclosed(
                         (const struct attr_domain**)config->attr_domains, sub, cdir->rchild)) {
-                move(sub, lnode, cdir->rchild->cnode->lnode);
+                move(config, sub, lnode, cdir->rchild->cnode->lnode);
                 i--;
             }
         }
@@ -1256,9 +1468,9 @@ static void free_pdir(struct pdir* pdir)
         struct pnode* pnode = pdir->pnodes[i];
         free_pnode(pnode);
     }
-    bfree(pdir->pnodes);
+    slab_free(pdir->pnodes);
     pdir->pnodes = NULL;
-    bfree(pdir);
+    slab_free(pdir);
 }
 
 static void free_pred(struct betree_variable* pred)
@@ -1276,13 +1488,13 @@ void free_sub(struct betree_sub* sub)
     if(sub == NULL) {
         return;
     }
-    bfree(sub->attr_vars);
+    slab_free(sub->attr_vars);
     sub->attr_vars = NULL;
     free_ast_node((struct ast_node*)sub->expr);
     sub->expr = NULL;
-    bfree(sub->short_circuit.pass);
-    bfree(sub->short_circuit.fail);
-    bfree(sub);
+    slab_free(sub->short_circuit.pass);
+    slab_free(sub->short_circuit.fail);
+    slab_free(sub);
 }
 
 void free_event(struct betree_event* event)
@@ -1309,9 +1521,9 @@ void free_lnode(struct lnode* lnode)
         const struct betree_sub* sub = lnode->subs[i];
         free_sub((struct betree_sub*)sub);
     }
-    bfree(lnode->subs);
+    slab_free(lnode->subs);
     lnode->subs = NULL;
-    bfree(lnode);
+    slab_free(lnode);
 }
 
 void free_cnode(struct cnode* cnode)
@@ -1323,7 +1535,7 @@ void free_cnode(struct cnode* cnode)
     cnode->lnode = NULL;
     free_pdir(cnode->pdir);
     cnode->pdir = NULL;
-    bfree(cnode);
+    slab_free(cnode);
 }
 
 static void free_cdir(struct cdir* cdir)
@@ -1331,14 +1543,14 @@ static void free_cdir(struct cdir* cdir)
     if(cdir == NULL) {
         return;
     }
-    bfree((char*)cdir->attr_var.attr);
+    slab_free((char*)cdir->attr_var.attr);
     free_cnode(cdir->cnode);
     cdir->cnode = NULL;
     free_cdir(cdir->lchild);
     cdir->lchild = NULL;
     free_cdir(cdir->rchild);
     cdir->rchild = NULL;
-    bfree(cdir);
+    slab_free(cdir);
 }
 
 /*static void try_remove_pnode_from_parent(const struct pnode* pnode)*/
@@ -1372,10 +1584,10 @@ static void free_pnode(struct pnode* pnode)
     if(pnode == NULL) {
         return;
     }
-    bfree((char*)pnode->attr_var.attr);
+    slab_free((char*)pnode->attr_var.attr);
     free_cdir(pnode->cdir);
     pnode->cdir = NULL;
-    bfree(pnode);
+    slab_free(pnode);
 }
 
 /*bool betree_delete_inner(size_t attr_domains_count,*/
@@ -1526,12 +1738,12 @@ struct betree_sub* find_sub_id(betree_sub_t id, struct cnode* cnode)
 
 struct betree_variable* make_pred(const char* attr, betree_var_t variable_id, struct value value)
 {
-    struct betree_variable* pred = bcalloc(sizeof(*pred));
+    struct betree_variable* pred = arena_calloc(sizeof(*pred));
     if(pred == NULL) {
         fprintf(stderr, "%s bcalloc failed\n", __func__);
         abort();
     }
-    pred->attr_var.attr = bstrdup(attr);
+    pred->attr_var.attr = arena_strdup(attr);
     pred->attr_var.var = variable_id;
     pred->value = value;
     return pred;
@@ -1768,25 +1980,29 @@ static void fill_short_circuit(struct config* config, struct betree_sub* sub)
 
 struct betree_sub* make_sub(struct config* config, betree_sub_t id, struct ast_node* expr)
 {
-    struct betree_sub* sub = bcalloc(sizeof(*sub));
+    struct betree_sub* sub = slab_calloc(config->node_slab, NODE_KIND_SUB, sizeof(*sub));
     if(sub == NULL) {
         fprintf(stderr, "%s bcalloc failed\n", __func__);
         abort();
     }
     sub->id = id;
+    // Given on insert, see index_sub
+    sub->index = UINT32_MAX;
     size_t count = config->attr_domain_count / 64 + 1;
-    sub->attr_vars = bcalloc(count * sizeof(*sub->attr_vars));
+    sub->attr_vars = slab_zalloc(config->node_slab, count * sizeof(*sub->attr_vars));
     sub->expr = expr;
     fill_pred(sub, sub->expr);
-    sub->short_circuit.pass = bcalloc(count * sizeof(*sub->short_circuit.pass));
-    sub->short_circuit.fail = bcalloc(count * sizeof(*sub->short_circuit.fail));
+    sub->short_circuit.pass
+        = slab_zalloc(config->node_slab, count * sizeof(*sub->short_circuit.pass));
+    sub->short_circuit.fail
+        = slab_zalloc(config->node_slab, count * sizeof(*sub->short_circuit.fail));
     fill_short_circuit(config, sub);
     return sub;
 }
 
 struct betree_event* make_empty_event()
 {
-    struct betree_event* event = bcalloc(sizeof(*event));
+    struct betree_event* event = arena_calloc(sizeof(*event));
     if(event == NULL) {
         fprintf(stderr, "%s event bcalloc failed\n", __func__);
         abort();
@@ -1804,22 +2020,6 @@ const char* get_attr_for_id(const struct config* config, betree_var_t variable_i
     return NULL;
 }
 
-betree_var_t try_get_id_for_attr(const struct config* config, const char* attr)
-{
-    char* copy = bstrdup(attr);
-    for(size_t i = 0; copy[i]; i++) {
-        copy[i] = tolower(copy[i]);
-    }
-    for(size_t i = 0; i < config->attr_domain_count; i++) {
-        if(strcmp(config->attr_domains[i]->attr_var.attr, copy) == 0) {
-            bfree(copy);
-            return i;
-        }
-    }
-    bfree(copy);
-    return INVALID_VAR;
-}
-
 void event_to_string(const struct betree_event* event, char* buffer)
 {
     size_t length = 0;
@@ -1882,8 +2082,6 @@ void event_to_string(const struct betree_event* event, char* buffer)
 }
 
 int parse(const char* text, struct ast_node** node);
-int event_parse(const char* text, struct betree_event** event);
-
 struct memoize make_memoize(size_t pred_count)
 {
     size_t count = pred_count / 64 + 1;
@@ -1908,6 +2106,152 @@ void free_memoize(struct memoize memoize)
 {
     bfree(memoize.pass);
     bfree(memoize.fail);
+    bfree(memoize.touched);
+}
+
+struct memoize_cache {
+    size_t word_count;
+    bool in_use;
+    struct memoize memoize;
+};
+
+static __thread struct memoize_cache memoize_cache;
+
+struct memoize acquire_memoize(size_t pred_count)
+{
+    if(memoize_cache.in_use) {
+        return make_memoize(pred_count);
+    }
+    size_t count = pred_count / 64 + 1;
+    if(memoize_cache.word_count < count) {
+        free_memoize(memoize_cache.memoize);
+        memoize_cache.memoize = make_memoize(pred_count);
+        memoize_cache.memoize.touched = bmalloc(count * sizeof(*memoize_cache.memoize.touched));
+        if(memoize_cache.memoize.pass == NULL || memoize_cache.memoize.fail == NULL
+            || memoize_cache.memoize.touched == NULL) {
+            fprintf(stderr, "%s allocation failed\n", __func__);
+            abort();
+        }
+        memoize_cache.word_count = count;
+    }
+    memoize_cache.in_use = true;
+    return memoize_cache.memoize;
+}
+
+void release_memoize(struct memoize memoize)
+{
+    if(memoize.touched == NULL) {
+        free_memoize(memoize);
+        return;
+    }
+    reset_memoize(&memoize);
+    memoize_cache.memoize = memoize;
+    memoize_cache.in_use = false;
+}
+
+void free_memoize_cache()
+{
+    if(memoize_cache.in_use) {
+        return;
+    }
+    free_memoize(memoize_cache.memoize);
+    memoize_cache.memoize = (struct memoize) { 0 };
+    memoize_cache.word_count = 0;
+}
+
+static size_t find_eager_index(const struct pred_map* pred_map, betree_pred_t memoize_id)
+{
+    for(size_t i = 0; i < pred_map->eager_count; i++) {
+        if(pred_map->eager_nodes[i]->memoize_id == memoize_id) {
+            return i;
+        }
+    }
+    return EAGER_PRED_MAX;
+}
+
+static void fill_eager_circuit(const struct pred_map* pred_map,
+    struct eager_circuit* eager_circuit,
+    bool inverted,
+    const struct ast_node* node)
+{
+    if(node->memoize_id != INVALID_PRED) {
+        size_t index = find_eager_index(pred_map, node->memoize_id);
+        if(index != EAGER_PRED_MAX) {
+            if(inverted) {
+                eager_circuit->pass |= 1ULL << index;
+            }
+            else {
+                eager_circuit->fail |= 1ULL << index;
+            }
+        }
+    }
+    if(node->type != AST_TYPE_BOOL_EXPR) {
+        return;
+    }
+    switch(node->bool_expr.op) {
+        case AST_BOOL_AND:
+            if(!inverted) {
+                fill_eager_circuit(pred_map, eager_circuit, inverted, node->bool_expr.binary.lhs);
+                fill_eager_circuit(pred_map, eager_circuit, inverted, node->bool_expr.binary.rhs);
+            }
+            return;
+        case AST_BOOL_OR:
+            if(inverted) {
+                fill_eager_circuit(pred_map, eager_circuit, inverted, node->bool_expr.binary.lhs);
+                fill_eager_circuit(pred_map, eager_circuit, inverted, node->bool_expr.binary.rhs);
+            }
+            return;
+        case AST_BOOL_NOT:
+            fill_eager_circuit(pred_map, eager_circuit, !inverted, node->bool_expr.unary.expr);
+            return;
+        case AST_BOOL_LITERAL:
+        case AST_BOOL_VARIABLE:
+            return;
+        default:
+            abort();
+    }
+}
+
+static void fill_eager_circuits_cdir(const struct pred_map* pred_map, struct cdir* cdir)
+{
+    if(cdir == NULL) {
+        return;
+    }
+    fill_eager_circuits(pred_map, cdir->cnode);
+    fill_eager_circuits_cdir(pred_map, cdir->lchild);
+    fill_eager_circuits_cdir(pred_map, cdir->rchild);
+}
+
+void fill_eager_circuits(const struct pred_map* pred_map, struct cnode* cnode)
+{
+    if(cnode == NULL) {
+        return;
+    }
+    for(size_t i = 0; i < cnode->lnode->sub_count; i++) {
+        struct betree_sub* sub = cnode->lnode->subs[i];
+        sub->eager_circuit.pass = 0;
+        sub->eager_circuit.fail = 0;
+        fill_eager_circuit(pred_map, &sub->eager_circuit, false, sub->expr);
+    }
+    if(cnode->pdir != NULL) {
+        for(size_t i = 0; i < cnode->pdir->pnode_count; i++) {
+            fill_eager_circuits_cdir(pred_map, cnode->pdir->pnodes[i]->cdir);
+        }
+    }
+}
+
+void eval_eager_preds(const struct pred_map* pred_map,
+    const struct betree_variable** preds,
+    struct memoize* memoize)
+{
+    for(size_t i = 0; i < pred_map->eager_count; i++) {
+        if(match_node(preds, pred_map->eager_nodes[i], memoize, NULL)) {
+            memoize->eager_pass |= 1ULL << i;
+        }
+        else {
+            memoize->eager_fail |= 1ULL << i;
+        }
+    }
 }
 
 uint64_t* make_undefined(size_t attr_domain_count, const struct betree_variable** preds)
@@ -1981,9 +2325,34 @@ bool betree_search_with_preds(const struct config* config,
     const struct betree_variable** preds,
     const struct cnode* cnode,
     struct report* report)
+{
+    return betree_search_with_preds_cache(config, preds, cnode, NULL, report);
+}
+
+bool betree_search_with_preds_cache(const struct config* config,
+    const struct betree_variable** preds,
+    const struct cnode* cnode,
+    struct betree_pred_cache* cache,
+    struct report* report)
+{
+    bool result = betree_search_with_borrowed_preds(config, preds, cnode, cache, report);
+    bfree(preds);
+    return result;
+}
+
+bool betree_search_with_borrowed_preds(const struct config* config,
+    const struct betree_variable** preds,
+    const struct cnode* cnode,
+    struct betree_pred_cache* cache,
+    struct report* report)
 {
     uint64_t* undefined = make_undefined(config->attr_domain_count, preds);
-    struct memoize memoize = make_memoize(config->pred_map->memoize_count);
+    struct memoize memoize = acquire_memoize(config->pred_map->memoize_count);
+    eval_string_matchers(&config->pred_map->string_matchers, preds, &memoize);
+    if(cache != NULL) {
+        fill_memoize_from_pred_cache(cache, preds, &memoize, report);
+    }
+    eval_eager_preds(config->pred_map, preds, &memoize);
     struct subs_to_eval subs;
     init_subs_to_eval(&subs);
     match_be_tree((const struct attr_domain**)config->attr_domains, preds, cnode, &subs);
@@ -1995,9 +2364,8 @@ bool betree_search_with_preds(const struct config* config,
         }
     }
     bfree(subs.subs);
-    free_memoize(memoize);
+    release_memoize(memoize);
     bfree(undefined);
-    bfree(preds);
     return true;
 }
 
@@ -2037,11 +2405,13 @@ bool betree_search_with_preds_ids(const struct config* config,
     size_t sz)
 {
     uint64_t* undefined = make_undefined(config->attr_domain_count, preds);
-    struct memoize memoize = make_memoize(config->pred_map->memoize_count);
+    struct memoize memoize = acquire_memoize(config->pred_map->memoize_count);
+    eval_string_matchers(&config->pred_map->string_matchers, preds, &memoize);
+    eval_eager_preds(config->pred_map, preds, &memoize);
     struct subs_to_eval subs;
     init_subs_to_eval(&subs);
     match_be_tree_ids(
-        (const struct attr_domain**)config->attr_domains, preds, cnode, &subs, ids, sz);
+        (const struct attr_domain**)config->attr_domains, preds, cnode, &subs, ids, sz, NULL);
     for(size_t i = 0; i < subs.count; i++) {
         const struct betree_sub* sub = subs.subs[i];
         report->evaluated++;
@@ -2050,7 +2420,54 @@ bool betree_search_with_preds_ids(const struct config* config,
         }
     }
     bfree(subs.subs);
-    free_memoize(memoize);
+    release_memoize(memoize);
+    bfree(undefined);
+    bfree(preds);
+    return true;
+}
+
+bool betree_search_with_preds_reasons(const struct config* config,
+    const struct betree_variable** preds,
+    const struct cnode* cnode,
+    struct report* report,
+    struct betree_reason_map_t* reasons,
+    const uint64_t* ids,
+    size_t sz)
+{
+    uint64_t* undefined = make_undefined(config->attr_domain_count, preds);
+    struct memoize memoize = acquire_memoize(config->pred_map->memoize_count);
+    struct match_reason reason = {
+        .geo = ADDITIONAL_REASON(config->attr_domain_count, REASON_GEO),
+        .memoized = bmalloc(config->pred_map->memoize_count * sizeof(*reason.memoized) + 1),
+    };
+    if(reason.memoized == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    struct subs_to_eval subs;
+    init_subs_to_eval(&subs);
+    const struct attr_domain** attr_domains = (const struct attr_domain**)config->attr_domains;
+    if(ids == NULL) {
+        match_cnode(attr_domains, preds, cnode, &subs, reasons);
+    }
+    else {
+        match_be_tree_ids(attr_domains, preds, cnode, &subs, ids, sz, reasons);
+    }
+    for(size_t i = 0; i < subs.count; i++) {
+        const struct betree_sub* sub = subs.subs[i];
+        report->evaluated++;
+        reason.last = ADDITIONAL_REASON(config->attr_domain_count, REASON_UNKNOWN);
+        if(match_sub_inner(
+               config->attr_domain_count, preds, sub, report, &memoize, undefined, &reason)) {
+            add_sub(sub->id, report);
+        }
+        else {
+            betree_reason_map_add(reasons, reason.last, sub->index);
+        }
+    }
+    bfree(subs.subs);
+    bfree(reason.memoized);
+    release_memoize(memoize);
     bfree(undefined);
     bfree(preds);
     return true;
@@ -2060,7 +2477,9 @@ bool betree_exists_with_preds(
     const struct config* config, const struct betree_variable** preds, const struct cnode* cnode)
 {
     uint64_t* undefined = make_undefined(config->attr_domain_count, preds);
-    struct memoize memoize = make_memoize(config->pred_map->memoize_count);
+    struct memoize memoize = acquire_memoize(config->pred_map->memoize_count);
+    eval_string_matchers(&config->pred_map->string_matchers, preds, &memoize);
+    eval_eager_preds(config->pred_map, preds, &memoize);
     struct subs_to_eval subs;
     init_subs_to_eval(&subs);
     match_be_tree((const struct attr_domain**)config->attr_domains, preds, cnode, &subs);
@@ -2073,7 +2492,7 @@ bool betree_exists_with_preds(
         }
     }
     bfree(subs.subs);
-    free_memoize(memoize);
+    release_memoize(memoize);
     bfree(undefined);
     bfree(preds);
     return result;
@@ -2092,17 +2511,22 @@ void sort_event_lists(struct betree_event* event)
         else if(pred->value.value_type == BETREE_STRING_LIST) {
             sort_and_remove_duplicate_string_list(pred->value.string_list_value);
         }
+        else if(pred->value.value_type == BETREE_SEGMENTS) {
+            sort_segments(pred->value.segments_value);
+        }
+        else if(pred->value.value_type == BETREE_FREQUENCY_CAPS) {
+            index_frequency_caps(pred->value.frequency_caps_value);
+        }
     }
 }
 
 struct betree_event* make_event_from_string(const struct betree* betree, const char* event_str)
 {
     struct betree_event* event;
-    if(likely(event_parse(event_str, &event))) {
+    if(likely(event_read(betree->config, event_str, &event))) {
         fprintf(stderr, "Failed to parse event: %s\n", event_str);
-        abort();
+        return NULL;
     }
-    fill_event(betree->config, event);
     sort_event_lists(event);
     return event;
 }
@@ -2137,7 +2561,7 @@ void add_variable(struct betree_variable* variable, struct betree_event* event)
         return;
     }
     if(event->variable_count == 0) {
-        event->variables = bcalloc(sizeof(*event->variables));
+        event->variables = arena_calloc(sizeof(*event->variables));
         if(event->variables == NULL) {
             fprintf(stderr, "%s bcalloc failed\n", __func__);
             abort();
@@ -2145,7 +2569,7 @@ void add_variable(struct betree_variable* variable, struct betree_event* event)
     }
     else {
         struct betree_variable** variables
-            = brealloc(event->variables, sizeof(*variables) * (event->variable_count + 1));
+            = arena_realloc(event->variables, sizeof(*variables) * (event->variable_count + 1));
         if(variables == NULL) {
             fprintf(stderr, "%s brealloc failed\n", __func__);
             abort();
@@ -2229,3 +2653,16 @@ bool validate_variables(const struct config* config, const struct betree_variabl
     }
     return true;
 }
+
+bool validate_defined_vars(const struct config* config, const uint64_t* defined_vars)
+{
+    if(config->attr_domain_count == 0) {
+        return true;
+    }
+    for(size_t i = 0; i <= (config->attr_domain_count - 1) / 64; i++) {
+        if((config->required_vars[i] & ~defined_vars[i]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -19,14 +19,23 @@ struct short_circuit {
     uint64_t* fail;
 };
 
+struct eager_circuit {
+    uint64_t pass;
+    uint64_t fail;
+};
+
 struct betree_sub {
     betree_sub_t id;
+    // Dense index of the sub in its config once inserted, see add_sub_index
+    uint32_t index;
     uint64_t* attr_vars;
     const struct ast_node* expr;
     struct short_circuit short_circuit;
+    struct eager_circuit eager_circuit;
 };
 
 struct cnode;
+struct betree_reason_map_t;
 
 struct lnode {
     struct cnode* parent;
@@ -73,6 +82,9 @@ struct cdir {
     struct cnode* cnode;
     struct cdir* lchild;
     struct cdir* rchild;
+    // Indices [sub_begin, sub_end) of the subs under this cdir, see number_subs
+    uint32_t sub_begin;
+    uint32_t sub_end;
 };
 
 struct pdir {
@@ -139,11 +151,31 @@ void add_variable(struct betree_variable* variable, struct betree_event* event);
 
 void fill_event(const struct config* config, struct betree_event* event);
 bool validate_variables(const struct config* config, const struct betree_variable* variables[]);
+bool validate_defined_vars(const struct config* config, const uint64_t* defined_vars);
 
 struct betree_event* make_event_from_string(const struct betree* betree, const char* event_str);
 
 struct memoize make_memoize(size_t pred_count);
 void free_memoize(struct memoize memoize);
+struct memoize acquire_memoize(size_t pred_count);
+void release_memoize(struct memoize memoize);
+void free_memoize_cache();
+
+void fill_eager_circuits(const struct pred_map* pred_map, struct cnode* cnode);
+void eval_eager_preds(const struct pred_map* pred_map,
+    const struct betree_variable** preds,
+    struct memoize* memoize);
+
+struct betree_bound_event {
+    const struct config* config;
+    size_t variable_count;
+    struct betree_variable* variables;
+    const struct betree_variable** preds;
+    // Bit per variable set in preds
+    uint64_t* defined_vars;
+    // Holds the values of betree_read_bound_event, created on first use
+    struct betree_event_arena* arena;
+};
 
 struct betree_constant {
     const char* name;
@@ -157,6 +189,17 @@ bool betree_search_with_preds(const struct config* config,
     const struct betree_variable** preds,
     const struct cnode* cnode,
     struct report* report);
+bool betree_search_with_preds_cache(const struct config* config,
+    const struct betree_variable** preds,
+    const struct cnode* cnode,
+    struct betree_pred_cache* cache,
+    struct report* report);
+// Same as betree_search_with_preds_cache, but leaves preds to the caller
+bool betree_search_with_borrowed_preds(const struct config* config,
+    const struct betree_variable** preds,
+    const struct cnode* cnode,
+    struct betree_pred_cache* cache,
+    struct report* report);
 bool betree_search_with_preds_ids(const struct config* config,
     const struct betree_variable** preds,
     const struct cnode* cnode,
@@ -164,6 +207,26 @@ bool betree_search_with_preds_ids(const struct config* config,
     const uint64_t* ids,
     size_t sz
     );
+/*
+ * Reason mode: same search, without eager preds or caches, recording in reasons why every sub
+ * that did not match failed. ids restricts the search like betree_search_with_preds_ids when not
+ * NULL.
+ */
+bool betree_search_with_preds_reasons(const struct config* config,
+    const struct betree_variable** preds,
+    const struct cnode* cnode,
+    struct report* report,
+    struct betree_reason_map_t* reasons,
+    const uint64_t* ids,
+    size_t sz);
+// Renumbers the subs of the tree in depth first order, so that each cdir covers a range of indices
+void number_subs(struct config* config, struct cnode* cnode);
+// Records reason for all the subs of the tree (in ids when not NULL)
+void add_tree_reason(struct betree_reason_map_t* reasons,
+    betree_var_t reason,
+    const struct cnode* cnode,
+    const uint64_t* ids,
+    size_t sz);
 bool betree_exists_with_preds(const struct config* config, const struct betree_variable** preds, const struct cnode* cnode);
 
 bool insert_be_tree(const struct config* config, const struct betree_sub* sub, struct cnode* cnode, struct cdir* cdir);
@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "alloc.h"
+#include "arena.h"
 #include "ast.h"
 #include "betree.h"
 #include "utils.h"
@@ -11,7 +12,7 @@
 
 struct betree_integer_list* make_integer_list()
 {
-    struct betree_integer_list* value = bcalloc(sizeof(*value));
+    struct betree_integer_list* value = arena_calloc(sizeof(*value));
     if(value == NULL) {
         fprintf(stderr, "%s bcalloc failed", __func__);
         abort();
@@ -21,7 +22,7 @@ struct betree_integer_list* make_integer_list()
 
 struct betree_string_list* make_string_list()
 {
-    struct betree_string_list* value = bcalloc(sizeof(*value));
+    struct betree_string_list* value = arena_calloc(sizeof(*value));
     if(value == NULL) {
         fprintf(stderr, "%s bcalloc failed", __func__);
         abort();
@@ -31,7 +32,7 @@ struct betree_string_list* make_string_list()
 
 struct betree_segments* make_segments()
 {
-    struct betree_segments* value = bcalloc(sizeof(*value));
+    struct betree_segments* value = arena_calloc(sizeof(*value));
     if(value == NULL) {
         fprintf(stderr, "%s bcalloc failed", __func__);
         abort();
@@ -41,7 +42,7 @@ struct betree_segments* make_segments()
 
 struct betree_frequency_caps* make_frequency_caps()
 {
-    struct betree_frequency_caps* value = bcalloc(sizeof(*value));
+    struct betree_frequency_caps* value = arena_calloc(sizeof(*value));
     if(value == NULL) {
         fprintf(stderr, "%s bcalloc failed", __func__);
         abort();
@@ -52,14 +53,14 @@ struct betree_frequency_caps* make_frequency_caps()
 void add_integer_list_value(int64_t integer, struct betree_integer_list* list)
 {
     if(list->count == 0) {
-        list->integers = bcalloc(sizeof(*list->integers));
+        list->integers = arena_calloc(sizeof(*list->integers));
         if(list->integers == NULL) {
             fprintf(stderr, "%s bcalloc failed", __func__);
             abort();
         }
     }
     else {
-        int64_t* integers = brealloc(list->integers, sizeof(*list->integers) * (list->count + 1));
+        int64_t* integers = arena_realloc(list->integers, sizeof(*list->integers) * (list->count + 1));
         if(integers == NULL) {
             fprintf(stderr, "%s brealloc failed", __func__);
             abort();
@@ -94,7 +95,7 @@ char* integer_list_value_to_string(struct betree_integer_list* list)
 void add_string_list_value(struct string_value string, struct betree_string_list* list)
 {
     if(list->count == 0) {
-        list->strings = bcalloc(sizeof(*list->strings));
+        list->strings = arena_calloc(sizeof(*list->strings));
         if(list->strings == NULL) {
             fprintf(stderr, "%s bcalloc failed", __func__);
             abort();
@@ -102,7 +103,7 @@ void add_string_list_value(struct string_value string, struct betree_string_list
     }
     else {
         struct string_value* strings
-            = brealloc(list->strings, sizeof(*list->strings) * (list->count + 1));
+            = arena_realloc(list->strings, sizeof(*list->strings) * (list->count + 1));
         if(strings == NULL) {
             fprintf(stderr, "%s brealloc failed", __func__);
             abort();
@@ -134,31 +135,28 @@ char* string_list_value_to_string(struct betree_string_list* list)
     return string;
 }
 
+// Copies the segment into the list and frees it
 void add_segment(struct betree_segment* segment, struct betree_segments* list)
 {
-    if(list->size == 0) {
-        list->content = bcalloc(sizeof(*list->content));
-        if(list->content == NULL) {
-            fprintf(stderr, "%s bcalloc failed", __func__);
-            abort();
-        }
-    }
-    else {
-        struct betree_segment** content = brealloc(list->content, sizeof(*list->content) * (list->size + 1));
-        if(content == NULL) {
-            fprintf(stderr, "%s brealloc failed", __func__);
-            abort();
-        }
-        list->content = content;
+    int64_t* ids = arena_realloc(list->ids, sizeof(*list->ids) * (list->size + 1));
+    int64_t* timestamps
+        = arena_realloc(list->timestamps, sizeof(*list->timestamps) * (list->size + 1));
+    if(ids == NULL || timestamps == NULL) {
+        fprintf(stderr, "%s brealloc failed", __func__);
+        abort();
     }
-    list->content[list->size] = segment;
+    ids[list->size] = segment->id;
+    timestamps[list->size] = segment->timestamp;
+    list->ids = ids;
+    list->timestamps = timestamps;
     list->size++;
+    arena_free(segment);
 }
 
 void add_frequency(struct betree_frequency_cap* frequency, struct betree_frequency_caps* list)
 {
     if(list->size == 0) {
-        list->content = bcalloc(sizeof(*list->content));
+        list->content = arena_calloc(sizeof(*list->content));
         if(list->content == NULL) {
             fprintf(stderr, "%s bcalloc failed", __func__);
             abort();
@@ -166,7 +164,7 @@ void add_frequency(struct betree_frequency_cap* frequency, struct betree_frequen
     }
     else {
         struct betree_frequency_cap** content
-            = brealloc(list->content, sizeof(*list->content) * (list->size + 1));
+            = arena_realloc(list->content, sizeof(*list->content) * (list->size + 1));
         if(content == NULL) {
             fprintf(stderr, "%s brealloc failed", __func__);
             abort();
@@ -179,7 +177,7 @@ void add_frequency(struct betree_frequency_cap* frequency, struct betree_frequen
 
 struct betree_segment* make_segment(int64_t id, int64_t timestamp)
 {
-    struct betree_segment* segment = bmalloc(sizeof(*segment));
+    struct betree_segment* segment = arena_malloc(sizeof(*segment));
     segment->id = id;
     segment->timestamp = timestamp;
     return segment;
@@ -203,7 +201,7 @@ struct betree_frequency_cap* make_frequency_cap_with_type(enum frequency_type_e
     int64_t timestamp,
     uint32_t value)
 {
-    struct betree_frequency_cap* frequency_cap = bmalloc(sizeof(*frequency_cap));
+    struct betree_frequency_cap* frequency_cap = arena_malloc(sizeof(*frequency_cap));
     frequency_cap->type = type;
     frequency_cap->id = id;
     frequency_cap->namespace = namespace;
@@ -270,12 +268,8 @@ void free_segment(struct betree_segment* value)
 
 void free_segments(struct betree_segments* value)
 {
-    for(size_t i = 0; i < value->size; i++) {
-        if(value->content[i] != NULL) {
-            bfree(value->content[i]);
-        }
-    }
-    bfree(value->content);
+    bfree(value->ids);
+    bfree(value->timestamps);
     bfree(value);
 }
 
@@ -293,6 +287,7 @@ void free_frequency_caps(struct betree_frequency_caps* value)
         }
     }
     bfree(value->content);
+    bfree(value->slots);
     bfree(value);
 }
 
@@ -342,7 +337,8 @@ char* segments_value_to_string(struct betree_segments* list)
     char* string = NULL;
     for(size_t i = 0; i < list->size; i++) {
         char* new_string;
-        char* segment = segment_value_to_string(list->content[i]);
+        struct betree_segment value = { .id = list->ids[i], .timestamp = list->timestamps[i] };
+        char* segment = segment_value_to_string(&value);
         if(i != 0) {
             if(basprintf(&new_string, "%s, %s", string, segment) < 0) {
                 abort();
@@ -435,8 +431,9 @@ void remove_duplicates_string_list(struct betree_string_list* list)
         if (list->strings[r].str != list->strings[i].str) {
             list->strings[++ r] = list->strings[i]; // copy-in next unique number
         }
-        else {
-            bfree((char*)list->strings[i].string);
+        else if(active_event_arena() == NULL) {
+            // Arena events do not own their strings, see event_read
+            arena_free((char*)list->strings[i].string);
         }
     }
     list->count = r + 1;
@@ -452,3 +449,116 @@ void sort_and_remove_duplicate_string_list(struct betree_string_list* list)
     sort_string_list(list);
     remove_duplicates_string_list(list);
 }
+
+static int segment_cmp(const void* a, const void* b)
+{
+    const struct betree_segment* x = a;
+    const struct betree_segment* y = b;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+void sort_segments(struct betree_segments* list)
+{
+    size_t i = 1;
+    while(i < list->size && list->ids[i - 1] <= list->ids[i]) {
+        i++;
+    }
+    if(i >= list->size) {
+        return;
+    }
+    struct betree_segment* segments = bmalloc(list->size * sizeof(*segments));
+    if(segments == NULL) {
+        fprintf(stderr, "%s bmalloc failed\n", __func__);
+        abort();
+    }
+    for(i = 0; i < list->size; i++) {
+        segments[i].id = list->ids[i];
+        segments[i].timestamp = list->timestamps[i];
+    }
+    qsort(segments, list->size, sizeof(*segments), segment_cmp);
+    for(i = 0; i < list->size; i++) {
+        list->ids[i] = segments[i].id;
+        list->timestamps[i] = segments[i].timestamp;
+    }
+    bfree(segments);
+}
+
+static size_t frequency_cap_slot(
+    enum frequency_type_e type, uint32_t id, betree_str_t str, size_t slot_mask)
+{
+    uint64_t hash = (((uint64_t)id << 8) | (uint64_t)type) * 0x9E3779B97F4A7C15ULL;
+    hash ^= str * 0xC2B2AE3D27D4EB4FULL;
+    return (hash ^ (hash >> 31)) & slot_mask;
+}
+
+static bool is_frequency_cap(const struct betree_frequency_cap* cap,
+    enum frequency_type_e type,
+    uint32_t id,
+    betree_str_t str)
+{
+    return cap->id == id && cap->namespace.str == str && cap->type == type;
+}
+
+void index_frequency_caps(struct betree_frequency_caps* caps)
+{
+    if(caps->size < FREQUENCY_CAPS_INDEX_MIN) {
+        return;
+    }
+    size_t slot_count = 16;
+    while(slot_count < caps->size * 2) {
+        slot_count *= 2;
+    }
+    if(caps->slots == NULL || caps->slot_mask + 1 != slot_count) {
+        uint32_t* slots = arena_realloc(caps->slots, slot_count * sizeof(*slots));
+        if(slots == NULL) {
+            fprintf(stderr, "%s arena_realloc failed\n", __func__);
+            abort();
+        }
+        caps->slots = slots;
+        caps->slot_mask = slot_count - 1;
+    }
+    memset(caps->slots, 0, slot_count * sizeof(*caps->slots));
+    for(size_t i = 0; i < caps->size; i++) {
+        const struct betree_frequency_cap* cap = caps->content[i];
+        size_t slot = frequency_cap_slot(cap->type, cap->id, cap->namespace.str, caps->slot_mask);
+        while(caps->slots[slot] != 0
+            && !is_frequency_cap(
+                caps->content[caps->slots[slot] - 1], cap->type, cap->id, cap->namespace.str)) {
+            slot = (slot + 1) & caps->slot_mask;
+        }
+        if(caps->slots[slot] == 0) {
+            caps->slots[slot] = i + 1;
+        }
+    }
+}
+
+const struct betree_frequency_cap* find_frequency_cap(const struct betree_frequency_caps* caps,
+    enum frequency_type_e type,
+    uint32_t id,
+    betree_str_t str,
+    int* ops_count)
+{
+    if(caps->slots == NULL) {
+        for(size_t i = 0; i < caps->size; i++) {
+            if(ops_count != NULL) {
+                (*ops_count)++;
+            }
+            if(is_frequency_cap(caps->content[i], type, id, str)) {
+                return caps->content[i];
+            }
+        }
+        return NULL;
+    }
+    size_t slot = frequency_cap_slot(type, id, str, caps->slot_mask);
+    while(caps->slots[slot] != 0) {
+        if(ops_count != NULL) {
+            (*ops_count)++;
+        }
+        const struct betree_frequency_cap* cap = caps->content[caps->slots[slot] - 1];
+        if(is_frequency_cap(cap, type, id, str)) {
+            return cap;
+        }
+        slot = (slot + 1) & caps->slot_mask;
+    }
+    return NULL;
+}
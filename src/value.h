@@ -17,6 +17,8 @@ static const betree_ienum_t INVALID_IENUM = UINT64_MAX;
 
 struct string_value {
     const char* string;
+    // Byte length of string, set once when the value is parsed or made
+    size_t length;
     betree_var_t var;
     betree_str_t str;
 };
@@ -42,9 +44,11 @@ struct betree_segment {
     int64_t timestamp;
 };
 
+// Sorted by id once the event is filled, timestamps[i] goes with ids[i]
 struct betree_segments {
     size_t size;
-    struct betree_segment** content;
+    int64_t* ids;
+    int64_t* timestamps;
 };
 
 enum frequency_type_e {
@@ -70,9 +74,17 @@ struct betree_frequency_cap {
     uint32_t value;
 };
 
+/*
+ * Lists of FREQUENCY_CAPS_INDEX_MIN caps or more get an open addressing index once the event is
+ * filled, from (type, id, namespace) to the position of the first such cap plus one
+ */
+#define FREQUENCY_CAPS_INDEX_MIN 8
+
 struct betree_frequency_caps {
     size_t size;
     struct betree_frequency_cap** content;
+    size_t slot_mask;
+    uint32_t* slots;
 };
 
 struct value {
@@ -156,4 +168,12 @@ void sort_and_remove_duplicate_integer_list(struct betree_integer_list* list);
 void remove_duplicates_string_list(struct betree_string_list* list);
 void sort_string_list(struct betree_string_list* list);
 void sort_and_remove_duplicate_string_list(struct betree_string_list* list);
+void sort_segments(struct betree_segments* list);
+void index_frequency_caps(struct betree_frequency_caps* caps);
+// Counts the caps looked at in ops_count when not NULL
+const struct betree_frequency_cap* find_frequency_cap(const struct betree_frequency_caps* caps,
+    enum frequency_type_e type,
+    uint32_t id,
+    betree_str_t str,
+    int* ops_count);
 
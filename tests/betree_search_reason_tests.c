@@ -7,13 +7,15 @@
 #include "alloc.h"
 #include "dyn_arr.h"
 #include "betree_err.h"
+#include "bitmap.h"
 #include "debug.h"
 #include "debug_err.h"
 #include "helper.h"
 #include "minunit.h"
 #include "printer.h"
+#include "reason_aggregator.h"
 #include "special.h"
-#include "tree_err.h"
+#include "tree.h"
 #include "utils.h"
 
 enum ATTR_DOMAIN_POSITION {
@@ -721,6 +723,198 @@ void betree_bulk_insert_with_constants(struct betree_err* tree,
 }
 
 
+int test_reason_report_reuse()
+{
+    struct betree_err* tree = betree_make_err();
+
+    make_attr_domains(tree, ATTR_CONFIG_2(ATTR_BOOL, ATTR_INT));
+
+    const char* exprs[] = { "b", "b and i = 10", "i = 10" };
+    const size_t exprs_count = 3;
+    betree_bulk_insert(tree, exprs, exprs_count);
+
+    struct report_err* report = make_report_err(tree);
+    betree_search_err(tree, "{\"b\": false, \"i\": 10}", report);
+    mu_assert(report->matched == 1 && report->subs[0] == 3, "goodMatch");
+    mu_assert(betree_reason_map_count(report->reason_sub_id_list, 0) == 2, "goodReason");
+    mu_assert(betree_reason_map_count(report->reason_sub_id_list, 1) == 0, "goodReason");
+
+    clear_report_err(report);
+    betree_search_err(tree, "{\"b\": true, \"i\": 5}", report);
+    mu_assert(report->matched == 1 && report->subs[0] == 1, "goodMatch");
+    mu_assert(betree_reason_map_count(report->reason_sub_id_list, 0) == 0, "clearedReason");
+    dynamic_array_t* rlist = betree_reason_map_get(report->reason_sub_id_list, 1);
+    mu_assert(rlist->size == 2 && rlist->data[0] == 2 && rlist->data[1] == 3, "goodReason");
+
+    struct report_err* other = make_report_err(tree);
+    betree_search_err(tree, "{\"b\": false, \"i\": 5}", other);
+    betree_reason_map_merge(report->reason_sub_id_list, other->reason_sub_id_list);
+    mu_assert(betree_reason_map_count(report->reason_sub_id_list, 0) == 2
+            && betree_reason_map_count(report->reason_sub_id_list, 1) == 2,
+        "goodMerge");
+
+    clear_report_err(other);
+    betree_reason_map_additem(other->reason_sub_id_list, 0, 3);
+    betree_reason_map_additem(other->reason_sub_id_list, 0, 42);
+    dynamic_array_t* ids = create_dynamic_array(2);
+    dynamic_array_add(ids, 1);
+    dynamic_array_add(ids, 3);
+    betree_reason_map_join(other->reason_sub_id_list, 0, ids);
+    destroy_dynamic_array(ids);
+    rlist = betree_reason_map_get(other->reason_sub_id_list, 0);
+    mu_assert(rlist->size == 2 && rlist->data[0] == 1 && rlist->data[1] == 3, "goodJoin");
+
+    const struct betree_sub* sub = betree_make_sub_err(tree, 4, 0, NULL, "i = 5");
+    mu_assert(!betree_insert_err(tree, 5, "unknown = 1"), "badInsert");
+    mu_assert(tree->config->sub_count == 3, "onlyInsertedSubsAreIndexed");
+    mu_assert(betree_insert_sub_err(tree, sub) && tree->config->sub_count == 4
+            && sub->index == 3,
+        "indexedOnInsert");
+
+    free_report_err(other);
+    free_report_err(report);
+    betree_free_err(tree);
+    return 0;
+}
+
+int test_reason_bitmap()
+{
+    struct betree_bitmap* bitmap = make_bitmap();
+    for(uint32_t i = 0; i < 3 * ARRAY_CONTAINER_MAX; i += 2) {
+        bitmap_add(bitmap, i);
+    }
+    bitmap_add(bitmap, 70000);
+    bitmap_add(bitmap, 70000);
+    mu_assert(bitmap_cardinality(bitmap) == 3 * ARRAY_CONTAINER_MAX / 2 + 1, "goodCardinality");
+    mu_assert(bitmap_contains(bitmap, 4) && !bitmap_contains(bitmap, 5), "goodContains");
+    mu_assert(bitmap_contains(bitmap, 70000), "goodContains");
+
+    uint32_t* indices = bmalloc(bitmap_cardinality(bitmap) * sizeof(*indices));
+    bitmap_to_array(bitmap, indices);
+    mu_assert(indices[0] == 0 && indices[1] == 2 && indices[3 * ARRAY_CONTAINER_MAX / 2] == 70000,
+        "goodArray");
+    bfree(indices);
+
+    bitmap_add_range(bitmap, 65000, 70010);
+    mu_assert(bitmap_cardinality(bitmap) == 3 * ARRAY_CONTAINER_MAX / 2 + 5010, "goodRange");
+    mu_assert(bitmap_contains(bitmap, 65000) && bitmap_contains(bitmap, 65536)
+            && bitmap_contains(bitmap, 70009) && !bitmap_contains(bitmap, 70010),
+        "goodRange");
+
+    clear_bitmap(bitmap);
+    mu_assert(bitmap_cardinality(bitmap) == 0 && !bitmap_contains(bitmap, 4), "goodClear");
+    bitmap_add(bitmap, 7);
+    mu_assert(bitmap_cardinality(bitmap) == 1 && bitmap_contains(bitmap, 7), "goodReuse");
+
+    free_bitmap(bitmap);
+    return 0;
+}
+
+static struct betree_event* make_bool_int_event(const struct betree_err* tree, bool b, int64_t i)
+{
+    struct betree_event* event = betree_make_event_err(tree);
+    betree_set_variable(event, 0, betree_make_boolean_variable("b", b));
+    betree_set_variable(event, 1, betree_make_integer_variable("i", i));
+    return event;
+}
+
+int test_reason_aggregator()
+{
+    struct betree_err* tree = betree_make_err();
+
+    make_attr_domains(tree, ATTR_CONFIG_2(ATTR_BOOL, ATTR_INT));
+
+    const char* exprs[] = { "b", "i = 10" };
+    const size_t exprs_count = 2;
+    betree_bulk_insert(tree, exprs, exprs_count);
+
+    struct betree_reason_aggregator* aggregator = make_reason_aggregator(tree, 2);
+    struct report_err* report = make_report_err(tree);
+    const bool bs[] = { false, true, false };
+    const int64_t is[] = { 10, 5, 5 };
+    for(size_t k = 0; k < 3; k++) {
+        struct betree_event* event = make_bool_int_event(tree, bs[k], is[k]);
+        betree_search_with_event_aggregated_err(tree, event, report, aggregator);
+        betree_free_event(event);
+    }
+
+    const uint64_t ids[] = { 2 };
+    struct betree_event* event = make_bool_int_event(tree, false, 5);
+    betree_search_with_event_ids_aggregated_err(tree, event, report, ids, 1, aggregator);
+    betree_free_event(event);
+    mu_assert(!betree_make_sub_ids(tree), "noRenumberWhileAggregating");
+
+    struct betree_reason_snapshot* snapshot = make_reason_snapshot(aggregator);
+    reason_aggregator_snapshot(aggregator, snapshot, false);
+    mu_assert(snapshot->sub_ids[0] == 1 && snapshot->sub_ids[1] == 2, "goodSubs");
+    mu_assert(reason_snapshot_events(snapshot, 0) == 3, "goodEvents");
+    mu_assert(reason_snapshot_events(snapshot, 1) == 4, "onlyEligibleSubsCountEvents");
+    mu_assert(reason_snapshot_count(snapshot, 0, 0) == 2, "goodCount");
+    mu_assert(reason_snapshot_count(snapshot, 0, 1) == 0, "onlyTheSubVariablesAreCounted");
+    mu_assert(reason_snapshot_count(snapshot, 1, 1) == 3, "goodCount");
+
+    reason_aggregator_snapshot(aggregator, snapshot, true);
+    mu_assert(reason_snapshot_events(snapshot, 1) == 4 && reason_snapshot_count(snapshot, 1, 1) == 3,
+        "goodCount");
+    reason_aggregator_snapshot(aggregator, snapshot, false);
+    mu_assert(reason_snapshot_events(snapshot, 1) == 0 && reason_snapshot_count(snapshot, 1, 1) == 0,
+        "goodReset");
+
+    free_reason_snapshot(snapshot);
+    free_report_err(report);
+    free_reason_aggregator(aggregator);
+    mu_assert(betree_make_sub_ids(tree), "renumberOnceDetached");
+    betree_free_err(tree);
+    return 0;
+}
+
+static int compare_sub_ids(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static size_t search_reason_ids(struct betree_err* tree, betree_var_t reason, uint64_t* ids)
+{
+    struct report_err* report = make_report_err(tree);
+    betree_search_err(tree, "{\"b\": true, \"i\": 42}", report);
+    dynamic_array_t* rlist = betree_reason_map_get(report->reason_sub_id_list, reason);
+    size_t count = rlist->size;
+    memcpy(ids, rlist->data, count * sizeof(*ids));
+    qsort(ids, count, sizeof(*ids), compare_sub_ids);
+    free_report_err(report);
+    return count;
+}
+
+int test_reason_sub_ranges()
+{
+    struct betree_err* tree = betree_make_err();
+
+    make_attr_domains(tree, ATTR_CONFIG_2(ATTR_BOOL, ATTR_INT));
+
+    for(size_t k = 0; k < 200; k++) {
+        char expr[64];
+        snprintf(expr, sizeof(expr), "i = %zu and b", k % 100);
+        mu_assert(betree_insert_err(tree, k + 1, expr), "goodInsert");
+    }
+
+    uint64_t walked[201], ranged[201];
+    size_t walked_count = search_reason_ids(tree, 1, walked);
+    mu_assert(walked_count == 198, "goodWalk");
+
+    betree_make_sub_ids(tree);
+    size_t ranged_count = search_reason_ids(tree, 1, ranged);
+    mu_assert(ranged_count == walked_count, "goodRanges");
+    mu_assert(memcmp(walked, ranged, walked_count * sizeof(*walked)) == 0, "goodRanges");
+
+    mu_assert(betree_insert_err(tree, 201, "i = 7 and b"), "goodInsert");
+    mu_assert(search_reason_ids(tree, 1, ranged) == walked_count + 1, "goodInsertAfterRanges");
+    mu_assert(ranged[walked_count] == 201, "goodInsertAfterRanges");
+
+    betree_free_err(tree);
+    return 0;
+}
+
 int all_tests()
 {
     mu_run_test(test_bool_fail);
@@ -744,6 +938,11 @@ int all_tests()
 
     mu_run_test(test_event_search_reason);
 
+    mu_run_test(test_reason_report_reuse);
+    mu_run_test(test_reason_bitmap);
+    mu_run_test(test_reason_aggregator);
+    mu_run_test(test_reason_sub_ranges);
+
     return 0;
 }
 
@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "alloc.h"
+#include "ast.h"
 #include "betree.h"
 #include "debug.h"
 #include "helper.h"
@@ -12,6 +13,7 @@
 #include "printer.h"
 #include "tree.h"
 #include "utils.h"
+#include "value.h"
 
 int test_search()
 {
@@ -147,6 +149,219 @@ int test_search_ids_4()
 }
 
 
+static bool has_sub(const struct report* report, betree_sub_t id)
+{
+    for(size_t i = 0; i < report->matched; i++) {
+        if(report->subs[i] == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int test_search_opcodes()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "i", false, 0, 10);
+    add_attr_domain_bounded_f(tree->config, "f", false, 0., 10.);
+    add_attr_domain_s(tree->config, "s", false);
+    add_attr_domain_ie(tree->config, "e", false);
+
+    mu_assert(betree_insert(tree, 1, "i < 5 and i >= 2"), "");
+    mu_assert(betree_insert(tree, 2, "f > 2 and f <= 3.5"), "");
+    mu_assert(betree_insert(tree, 3, "i <> 4 and f = 3"), "");
+    mu_assert(betree_insert(tree, 4, "s = \"a\" and e <> 7"), "");
+    mu_assert(betree_insert(tree, 5, "s <> \"a\" or e = 7"), "");
+
+    const struct betree_sub* sub = find_sub_id(2, tree->cnode);
+    mu_assert(sub->expr->bool_expr.binary.lhs->opcode == AST_OPCODE_FLOAT_GT, "float opcode");
+
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, "{\"i\": 4, \"f\": 3.0, \"s\": \"a\", \"e\": 8}", report), "");
+    mu_assert(report->matched == 3 && has_sub(report, 1) && has_sub(report, 2) && has_sub(report, 4),
+        "matched 1, 2 and 4");
+    free_report(report);
+
+    report = make_report();
+    mu_assert(betree_search(tree, "{\"i\": 3, \"f\": 3.0, \"s\": \"b\", \"e\": 7}", report), "");
+    mu_assert(report->matched == 4 && has_sub(report, 1) && has_sub(report, 2) && has_sub(report, 3)
+            && has_sub(report, 5),
+        "matched 1, 2, 3 and 5");
+    free_report(report);
+
+    betree_free(tree);
+    return 0;
+}
+
+int test_search_bound_event()
+{
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "i", false, 0, 10);
+    betree_add_string_variable(tree, "s", true, 5);
+    betree_add_integer_list_variable(tree, "il", true, 0, 10);
+    betree_add_boolean_variable(tree, "b", true);
+
+    mu_assert(betree_insert(tree, 1, "i = 1 and s = \"a\""), "");
+    mu_assert(betree_insert(tree, 2, "i > 2 and s <> \"a\""), "");
+    mu_assert(betree_insert(tree, 3, "il one of (3, 4)"), "");
+    mu_assert(betree_insert(tree, 4, "b and ends_with(s, \"xyz\")"), "");
+
+    size_t i = betree_get_variable_index(tree, "i");
+    size_t s = betree_get_variable_index(tree, "s");
+    size_t il = betree_get_variable_index(tree, "il");
+    size_t b = betree_get_variable_index(tree, "b");
+    mu_assert(betree_get_variable_index(tree, "x") == SIZE_MAX, "unknown variable");
+    uint64_t a = betree_intern_string(tree, s, "a");
+    mu_assert(a != INVALID_STR, "a is known");
+    mu_assert(betree_intern_string(tree, s, "wxyz") == INVALID_STR, "wxyz is not in any expression");
+
+    struct betree_bound_event* event = betree_make_bound_event(tree);
+    mu_assert(!betree_set_bound_float(event, i, 1.), "wrong type");
+    mu_assert(!betree_set_bound_integer(event, 42, 1), "out of range");
+
+    struct report* report = make_report();
+    mu_assert(!betree_search_with_bound_event(tree, event, report), "i is required");
+    mu_assert(betree_set_bound_integer(event, i, 1), "");
+    mu_assert(betree_set_bound_string(event, s, a, "a"), "");
+    mu_assert(betree_search_with_bound_event(tree, event, report), "");
+    mu_assert(report->matched == 1 && report->subs[0] == 1, "matched 1");
+    free_report(report);
+
+    betree_clear_bound_event(event);
+    struct betree_integer_list* list = betree_make_integer_list(2);
+    betree_add_integer(list, 0, 4);
+    betree_add_integer(list, 1, 4);
+    report = make_report();
+    mu_assert(betree_set_bound_integer(event, i, 5), "");
+    mu_assert(betree_set_bound_string(event, s, INVALID_STR, "wxyz"), "");
+    mu_assert(betree_set_bound_integer_list(event, il, list), "");
+    mu_assert(betree_set_bound_boolean(event, b, true), "");
+    mu_assert(betree_search_with_bound_event(tree, event, report), "");
+    mu_assert(report->matched == 3 && has_sub(report, 2) && has_sub(report, 3) && has_sub(report, 4),
+        "matched 2, 3 and 4");
+    free_report(report);
+
+    betree_free_integer_list(list);
+    betree_free_bound_event(event);
+    betree_free(tree);
+    return 0;
+}
+
+int test_search_bound_string()
+{
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "i", false, 0, 10);
+    betree_add_string_variable(tree, "s", true, 5);
+    betree_add_integer_list_variable(tree, "il", true, 0, 10);
+
+    mu_assert(betree_insert(tree, 1, "i = 1 and s = \"a\""), "");
+    mu_assert(betree_insert(tree, 2, "i > 2 and s <> \"a\""), "");
+    mu_assert(betree_insert(tree, 3, "il one of (3, 4)"), "");
+
+    struct betree_bound_event* event = betree_make_bound_event(tree);
+    struct report* report = make_report();
+    mu_assert(betree_search_with_bound_string(tree, event, "{\"i\": 1, \"s\": \"a\"}", report), "");
+    mu_assert(report->matched == 1 && report->subs[0] == 1, "matched 1");
+    free_report(report);
+
+    report = make_report();
+    mu_assert(!betree_search_with_bound_string(tree, event, "{\"s\": \"a\"}", report), "i is required");
+    free_report(report);
+    mu_assert(event->preds[0] == NULL, "previous values are cleared");
+
+    report = make_report();
+    mu_assert(betree_search_with_bound_string(tree, event, "{\"i\": 5, \"s\": \"b\", \"il\": [4, 4]}", report), "");
+    mu_assert(report->matched == 2 && has_sub(report, 2) && has_sub(report, 3), "matched 2 and 3");
+    mu_assert(event->preds[2]->value.integer_list_value->count == 1, "lists are sorted");
+    free_report(report);
+
+    mu_assert(!betree_read_bound_event(event, "{\"i\": }"), "invalid event");
+    betree_free_bound_event(event);
+    betree_free(tree);
+    return 0;
+}
+
+int test_search_binary()
+{
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "i", false, 0, 10);
+    betree_add_string_variable(tree, "s", true, 5);
+    betree_add_integer_list_variable(tree, "il", true, 0, 10);
+    betree_add_string_list_variable(tree, "sl", true, 5);
+    betree_add_boolean_variable(tree, "b", true);
+    betree_add_frequency_caps_variable(tree, "caps", true);
+
+    mu_assert(betree_insert(tree, 1, "i = 1 and s = \"a\""), "");
+    mu_assert(betree_insert(tree, 2, "il one of (3, 4) and b"), "");
+    mu_assert(betree_insert(tree, 3, "sl one of (\"x\")"), "");
+
+    size_t s_index = betree_get_variable_index(tree, "s");
+    struct betree_binary_encoder* encoder = betree_make_binary_encoder();
+    betree_encode_integer(encoder, betree_get_variable_index(tree, "i"), 1);
+    betree_encode_string(encoder, s_index, betree_intern_string(tree, s_index, "a"), "a");
+    size_t length;
+    const void* data = betree_binary_encoder_data(encoder, &length);
+    struct report* report = make_report();
+    mu_assert(betree_search_binary(tree, data, length, report), "");
+    mu_assert(report->matched == 1 && report->subs[0] == 1, "matched 1");
+    free_report(report);
+
+    betree_reset_binary_encoder(encoder);
+    struct betree_integer_list* il = betree_make_integer_list(3);
+    betree_add_integer(il, 0, 4);
+    betree_add_integer(il, 1, 1);
+    betree_add_integer(il, 2, 4);
+    struct betree_string_list* sl = betree_make_string_list(3);
+    betree_add_string(sl, 0, "x");
+    betree_add_string(sl, 1, "y");
+    betree_add_string(sl, 2, "x");
+    struct betree_frequency_caps* caps = betree_make_frequency_caps(1);
+    betree_add_frequency_cap(caps, 0, betree_make_frequency_cap("flight", 7, "ns", true, 10, 2));
+    betree_encode_integer(encoder, betree_get_variable_index(tree, "i"), 5);
+    betree_encode_string(encoder, s_index, INVALID_STR, "b");
+    betree_encode_integer_list(encoder, betree_get_variable_index(tree, "il"), il);
+    betree_encode_string_list(encoder, betree_get_variable_index(tree, "sl"), sl);
+    betree_encode_boolean(encoder, betree_get_variable_index(tree, "b"), true);
+    betree_encode_frequency_caps(encoder, betree_get_variable_index(tree, "caps"), caps);
+    free_integer_list(il);
+    free_string_list(sl);
+    free_frequency_caps(caps);
+    data = betree_binary_encoder_data(encoder, &length);
+    report = make_report();
+    mu_assert(betree_search_binary(tree, data, length, report), "");
+    mu_assert(report->matched == 2 && has_sub(report, 2) && has_sub(report, 3), "matched 2 and 3");
+    free_report(report);
+
+    struct betree_bound_event* event = betree_make_bound_event(tree);
+    mu_assert(betree_read_binary_event(event, data, length), "");
+    mu_assert(event->preds[1]->value.string_value.str == INVALID_STR, "unknown strings stay unknown");
+    mu_assert(event->preds[2]->value.integer_list_value->count == 2, "lists are sorted");
+    mu_assert(event->preds[3]->value.string_list_value->count == 2, "string lists are sorted");
+    const struct betree_frequency_cap* cap = event->preds[5]->value.frequency_caps_value->content[0];
+    mu_assert(cap->id == 7 && cap->timestamp == 10 && cap->value == 2
+            && strcmp(cap->namespace.string, "ns") == 0,
+        "caps round trip");
+
+    unsigned char* copy = malloc(length);
+    memcpy(copy, data, length);
+    mu_assert(!betree_read_binary_event(event, copy, length - 1), "truncated");
+    mu_assert(event->preds[0] == NULL, "previous values are cleared");
+    copy[0] ^= 1;
+    mu_assert(!betree_read_binary_event(event, copy, length), "bad magic");
+    free(copy);
+
+    betree_reset_binary_encoder(encoder);
+    betree_encode_float(encoder, betree_get_variable_index(tree, "i"), 1.);
+    data = betree_binary_encoder_data(encoder, &length);
+    mu_assert(!betree_read_binary_event(event, data, length), "type mismatch");
+
+    betree_free_bound_event(event);
+    betree_free_binary_encoder(encoder);
+    betree_free_search_cache();
+    betree_free(tree);
+    return 0;
+}
+
 int all_tests()
 {
     mu_run_test(test_search);
@@ -155,6 +370,10 @@ int all_tests()
     mu_run_test(test_search_ids_2);
     mu_run_test(test_search_ids_3);
     mu_run_test(test_search_ids_4);
+    mu_run_test(test_search_opcodes);
+    mu_run_test(test_search_bound_event);
+    mu_run_test(test_search_bound_string);
+    mu_run_test(test_search_binary);
     return 0;
 }
 
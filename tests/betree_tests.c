@@ -10,6 +10,7 @@
 #include "helper.h"
 #include "minunit.h"
 #include "printer.h"
+#include "slab.h"
 #include "tree.h"
 #include "utils.h"
 
@@ -1748,6 +1749,191 @@ int test_cdir_not_or()
     return 0;
 }
 
+int test_attr_lookup()
+{
+    struct config* config = make_default_config();
+    mu_assert(try_get_id_for_attr(config, "a") == INVALID_VAR, "empty config");
+    char name[16];
+    for(size_t i = 0; i < 100; i++) {
+        sprintf(name, "attr_%zu", i);
+        add_attr_domain_i(config, name, false);
+    }
+    add_attr_domain_b(config, "attr_0", false);
+    for(size_t i = 0; i < 100; i++) {
+        sprintf(name, "ATTR_%zu", i);
+        mu_assert(try_get_id_for_attr(config, name) == i, "case folded lookup for %zu", i);
+    }
+    mu_assert(try_get_id_for_attr(config, "attr_0") == 0, "first domain wins");
+    mu_assert(try_get_id_for_attr(config, "attr_100") == INVALID_VAR, "missing");
+    mu_assert(try_get_id_for_attr(config, "attr_") == INVALID_VAR, "prefix");
+    free_config(config);
+    return 0;
+}
+
+int test_value_maps_by_var()
+{
+    struct config* config = make_default_config();
+    add_attr_domain_s(config, "s", false);
+    add_attr_domain_ie(config, "ie", false);
+    add_attr_domain_s(config, "t", false);
+    struct attr_var s = make_attr_var("s", config);
+    struct attr_var ie = make_attr_var("ie", config);
+    struct attr_var t = make_attr_var("t", config);
+    mu_assert(try_get_id_for_string(config, s, "a") == INVALID_STR, "no string map yet");
+    mu_assert(try_get_id_for_ienum(config, ie, 1) == INVALID_IENUM, "no integer map yet");
+    char string[16];
+    for(size_t i = 0; i < 1000; i++) {
+        sprintf(string, "s%zu", i);
+        mu_assert(get_id_for_string(config, t, string, true) == i, "t string %zu", i);
+        mu_assert(get_id_for_ienum(config, ie, (int64_t)i * 7919 - 50000, true) == i, "ienum %zu", i);
+    }
+    mu_assert(get_id_for_string(config, s, "s1", true) == 0, "maps are per var");
+    for(size_t i = 0; i < 1000; i++) {
+        sprintf(string, "s%zu", i);
+        mu_assert(try_get_id_for_string(config, t, string) == i, "t string lookup %zu", i);
+        mu_assert(try_get_id_for_ienum(config, ie, (int64_t)i * 7919 - 50000) == i, "ienum lookup %zu", i);
+    }
+    mu_assert(try_get_id_for_ienum(config, ie, 1) == INVALID_IENUM, "missing ienum");
+    mu_assert(try_get_id_for_string(config, s, "s0") == INVALID_STR, "missing string");
+    free_attr_var(s);
+    free_attr_var(ie);
+    free_attr_var(t);
+    free_config(config);
+    return 0;
+}
+
+int test_string_interner()
+{
+    struct string_interner interner;
+    init_string_interner(&interner);
+    mu_assert(find_interned_string(&interner, "a") == INVALID_STR, "empty interner");
+    reserve_string_interner(&interner, 4);
+    char string[16];
+    for(size_t i = 0; i < 100; i++) {
+        sprintf(string, "s%zu", i);
+        mu_assert(intern_string(&interner, string) == i, "new id %zu", i);
+    }
+    mu_assert(intern_string(&interner, "s42") == 42, "existing id");
+    mu_assert(intern_string(&interner, "") == 100, "empty string");
+    mu_assert(strcmp(get_interned_string(&interner, 7), "s7") == 0, "key storage");
+    mu_assert(get_interned_string(&interner, 101) == NULL, "missing id");
+    const char* key = get_interned_string(&interner, 7);
+    for(size_t i = 0; i < 10000; i++) {
+        sprintf(string, "t%zu", i);
+        intern_string(&interner, string);
+    }
+    mu_assert(get_interned_string(&interner, 7) == key && strcmp(key, "s7") == 0, "stable keys");
+    mu_assert(find_interned_slice(&interner, "s7 and more", 2) == 7, "slice");
+    mu_assert(find_interned_slice(&interner, "s", 1) == INVALID_STR, "shorter slice");
+    mu_assert(find_interned_slice(&interner, "s7x", 3) == INVALID_STR, "longer slice");
+    deinit_string_interner(&interner);
+
+    struct betree* tree = betree_make();
+    betree_add_string_variable(tree, "s", false, 8);
+    mu_assert(!betree_reserve_string_values(tree, "t", 8), "unknown variable");
+    mu_assert(betree_reserve_string_values(tree, "s", 1000), "");
+    mu_assert(betree_insert(tree, 1, "s = \"a\""), "");
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, "{\"s\": \"a\"}", report), "");
+    mu_assert(report->matched == 1, "matched");
+    free_report(report);
+    betree_free(tree);
+    return 0;
+}
+
+int test_node_slab()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "a", false, 0, 1000);
+    add_attr_domain_bounded_i(tree->config, "b", false, 0, 1000);
+    char expr[64];
+    for(size_t i = 0; i < 1000; i++) {
+        sprintf(expr, "a = %zu and b <> %zu", i, i);
+        mu_assert(betree_insert(tree, i, expr), "");
+    }
+    const struct node_slab* slab = tree->config->node_slab;
+    mu_assert(slab->pools[NODE_KIND_SUB].chunks != NULL, "subs come from the slab");
+    mu_assert(slab->chunk_count < 100, "nodes are allocated in chunks");
+
+    struct ast_node* node = ast_node_create();
+    mu_assert(node != NULL, "no active slab");
+    free_ast_node(node);
+
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, "{\"a\": 7, \"b\": 8}", report), "");
+    mu_assert(report->matched == 1 && report->subs[0] == 7, "matched 7");
+    free_report(report);
+    betree_free(tree);
+    return 0;
+}
+
+struct counting_allocator {
+    size_t allocated;
+    size_t reallocated;
+    size_t freed;
+};
+
+static void* counting_malloc(void* context, size_t size)
+{
+    ((struct counting_allocator*)context)->allocated++;
+    return malloc(size);
+}
+
+static void* counting_calloc(void* context, size_t size)
+{
+    ((struct counting_allocator*)context)->allocated++;
+    return calloc(1, size);
+}
+
+static void* counting_realloc(void* context, void* ptr, size_t size)
+{
+    if(ptr == NULL) {
+        ((struct counting_allocator*)context)->allocated++;
+    }
+    else {
+        ((struct counting_allocator*)context)->reallocated++;
+    }
+    return realloc(ptr, size);
+}
+
+static void counting_free(void* context, void* ptr)
+{
+    if(ptr != NULL) {
+        ((struct counting_allocator*)context)->freed++;
+    }
+    free(ptr);
+}
+
+int test_allocator()
+{
+    struct counting_allocator counts = { 0, 0, 0 };
+    struct betree_allocator allocator = {
+        .malloc = counting_malloc,
+        .calloc = counting_calloc,
+        .realloc = counting_realloc,
+        .free = counting_free,
+        .context = &counts,
+    };
+    struct betree* tree = betree_make_with_allocator(&allocator);
+    add_attr_domain_bounded_i(tree->config, "a", false, 0, 1000);
+    char expr[64];
+    for(size_t i = 0; i < 1000; i++) {
+        sprintf(expr, "a = %zu", i);
+        mu_assert(betree_insert(tree, i, expr), "");
+    }
+    mu_assert(tree->config->node_slab->chunk_count < 100, "nodes come from the allocator in chunks");
+    mu_assert(counts.allocated > 3000, "so do the arrays of each sub");
+    mu_assert(counts.reallocated > 0, "and arrays grow through realloc");
+
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, "{\"a\": 7}", report), "");
+    mu_assert(report->matched == 1 && report->subs[0] == 7, "matched 7");
+    free_report(report);
+    betree_free(tree);
+    mu_assert(counts.freed == counts.allocated, "everything is given back");
+    return 0;
+}
+
 int all_tests()
 {
     mu_run_test(test_int_enum);
@@ -1795,6 +1981,11 @@ int all_tests()
     mu_run_test(test_duplicate_unsorted_string_list);
     mu_run_test(test_cdir_not_and);
     mu_run_test(test_cdir_not_or);
+    mu_run_test(test_attr_lookup);
+    mu_run_test(test_value_maps_by_var);
+    mu_run_test(test_string_interner);
+    mu_run_test(test_node_slab);
+    mu_run_test(test_allocator);
 
     return 0;
 }
@@ -315,6 +315,74 @@ int test_string_list_bounds()
     return 0;
 }
 
+static bool match_float_near(struct config* config, const char* expr, double min, double max)
+{
+    struct value_bound bound = get_bound(config, expr);
+    bool result = bound.value_type == BETREE_FLOAT && fabs(bound.fmin - min) < 1e-3
+        && fabs(bound.fmax - max) < 1e-3;
+    if(!result) {
+        fprintf(stderr,
+            "Min: Expected %.6f, Got %.6f. Max: Expected %.6f, Got %.6f\n",
+            min,
+            bound.fmin,
+            max,
+            bound.fmax);
+    }
+    return result;
+}
+
+int test_geo_bounds()
+{
+    // 111.2 km is close to one degree of latitude
+    struct betree* latitude_tree = betree_make();
+    add_attr_domain_bounded_f(latitude_tree->config, "latitude", false, -90., 90.);
+    add_attr_domain_bounded_f(latitude_tree->config, "longitude", false, -180., 180.);
+    struct config* config = latitude_tree->config;
+
+    mu_assert(match_float_near(config, "geo_within_radius(45., 10., 111.2)", 44., 46.), "lat");
+    mu_assert(match_float_near(config, "not geo_within_radius(45., 10., 111.2)", -90., 90.),
+        "lat not");
+    mu_assert(match_float_near(config, "geo_within_radius(89.5, 10., 111.2)", 88.5, 90.),
+        "lat pole");
+    mu_assert(match_float_near(config, "geo_within_radius(100., 10., 111.2)", -90., 90.),
+        "lat out of range");
+    mu_assert(match_float_near(config, "geo_within_radius(45., 10., 111.2) or latitude > 0.", 0., 90.),
+        "lat or");
+
+    struct betree* longitude_tree = betree_make();
+    add_attr_domain_bounded_f(longitude_tree->config, "longitude", false, -180., 180.);
+    add_attr_domain_bounded_f(longitude_tree->config, "latitude", false, -90., 90.);
+    config = longitude_tree->config;
+
+    mu_assert(match_float_near(config, "geo_within_radius(0., 10., 111.2)", 9., 11.), "lon");
+    mu_assert(match_float_near(config, "geo_within_radius(60., 10., 111.2)", 8., 12.),
+        "lon widened");
+    mu_assert(match_float_near(config, "geo_within_radius(0., 179.5, 111.2)", -180., 180.),
+        "lon wraps");
+    mu_assert(match_float_near(config, "geo_within_radius(89.5, 10., 111.2)", -180., 180.),
+        "lon pole");
+
+    // Domains that allow out of range coordinates are not bound by the box
+    struct betree* wide_latitude_tree = betree_make();
+    add_attr_domain_bounded_f(wide_latitude_tree->config, "latitude", false, -100., 100.);
+    add_attr_domain_bounded_f(wide_latitude_tree->config, "longitude", false, -180., 180.);
+    mu_assert(match_float_near(wide_latitude_tree->config, "geo_within_radius(45., 10., 111.2)", -100., 100.),
+        "lat wide domain");
+
+    struct betree* wide_longitude_tree = betree_make();
+    add_attr_domain_bounded_f(wide_longitude_tree->config, "longitude", false, -360., 360.);
+    add_attr_domain_bounded_f(wide_longitude_tree->config, "latitude", false, -90., 90.);
+    mu_assert(match_float_near(wide_longitude_tree->config, "geo_within_radius(0., 10., 111.2)", -360., 360.),
+        "lon wide domain");
+
+    betree_free(latitude_tree);
+    betree_free(longitude_tree);
+    betree_free(wide_latitude_tree);
+    betree_free(wide_longitude_tree);
+
+    return 0;
+}
+
 int test_complex_bounds()
 {
     struct betree* tree = betree_make();
@@ -347,6 +415,7 @@ int all_tests()
     mu_run_test(test_integer_list_bounds);
     mu_run_test(test_string_list_bounds);
     mu_run_test(test_complex_bounds);
+    mu_run_test(test_geo_bounds);
 
     return 0;
 }
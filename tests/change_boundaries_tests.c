@@ -228,6 +228,27 @@ int test_integer_list()
     return 0;
 }
 
+int test_segments()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_segments(tree->config, "seg", false);
+    add_attr_domain_i(tree->config, "now", false);
+
+    const char* expr1 = "segment_within(seg, 7, 20) or segment_before(seg, 3, 20)";
+    const char* expr2 = "segment_within(seg, 12, 20) and not segment_within(seg, 40, 20)";
+
+    betree_change_boundaries(tree, expr1);
+    betree_change_boundaries(tree, expr2);
+
+    struct value_bound bound = tree->config->attr_domains[0]->bound;
+    mu_assert(bound.imin == 3, "");
+    mu_assert(bound.imax == 12, "");
+
+    betree_free(tree);
+
+    return 0;
+}
+
 int test_normal()
 {
     struct betree* tree = betree_make();
@@ -273,6 +294,7 @@ int all_tests()
     mu_run_test(test_string);
     mu_run_test(test_integer_set_left);
     mu_run_test(test_integer_set_right);
+    mu_run_test(test_segments);
     mu_run_test(test_normal);
 
     return 0;
@@ -2,7 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "ast.h"
+#include "betree.h"
+#include "config.h"
+#include "event_reader.h"
 #include "minunit.h"
 #include "tree.h"
 #include "utils.h"
@@ -147,9 +151,8 @@ bool test_segment_list_pred(
         && (test_empty_list(pred) || pred->value.value_type == BETREE_SEGMENTS)) {
         if(list->size == pred->value.segments_value->size) {
             for(size_t i = 0; i < list->size; i++) {
-                struct betree_segment* target = list->content[i];
-                struct betree_segment* value = pred->value.segments_value->content[i];
-                if(target->id != value->id || target->timestamp != value->timestamp) {
+                const struct betree_segments* value = pred->value.segments_value;
+                if(list->ids[i] != value->ids[i] || list->timestamps[i] != value->timestamps[i]) {
                     return false;
                 }
             }
@@ -416,6 +419,146 @@ int test_null()
     return 0;
 }
 
+int test_arena()
+{
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "i", false, 0, 10);
+    betree_add_string_variable(tree, "s", true, 5);
+    betree_add_integer_list_variable(tree, "il", true, 0, 1000);
+    betree_add_string_list_variable(tree, "sl", true, 5);
+    mu_assert(betree_insert(tree, 1, "i = 1 and s = \"a\""), "");
+    mu_assert(betree_insert(tree, 2, "999 in il and \"b\" in sl"), "");
+
+    struct betree_event_arena* arena = betree_make_event_arena(0);
+    struct betree_event* event
+        = betree_make_event_in_arena(tree, arena, "{\"i\": 1, \"s\": \"a\", \"il\": [3, 1, 3]}");
+    mu_assert(event->variable_count == 3 && test_integer_pred("i", 1, event, 0)
+            && test_string_pred("s", "a", event, 1),
+        "parsed in the arena");
+    const struct betree_integer_list* il = event->variables[2]->value.integer_list_value;
+    mu_assert(il->count == 2 && il->integers[0] == 1 && il->integers[1] == 3, "list is sorted");
+    betree_reset_event_arena(arena);
+    mu_assert(betree_make_event_in_arena(tree, arena, "{\"i\": ") == NULL, "invalid event");
+    betree_reset_event_arena(arena);
+
+    char* large;
+    size_t length = 0;
+    large = malloc(16 * 1024);
+    length += sprintf(large, "{\"i\": 2, \"sl\": [\"b\", \"c\", \"b\"], \"il\": [");
+    for(size_t i = 0; i < 1000; i++) {
+        length += sprintf(large + length, i == 0 ? "%zu" : ", %zu", i);
+    }
+    sprintf(large + length, "]}");
+    for(size_t i = 0; i < 3; i++) {
+        struct report* report = make_report();
+        mu_assert(betree_search_with_arena(tree, arena, "{\"i\": 1, \"s\": \"a\"}", report), "");
+        mu_assert(report->matched == 1 && report->subs[0] == 1, "matched 1");
+        free_report(report);
+        report = make_report();
+        mu_assert(betree_search_with_arena(tree, arena, large, report), "");
+        mu_assert(report->matched == 1 && report->subs[0] == 2, "matched 2 with chunks added");
+        free_report(report);
+    }
+    size_t chunk_count = 0;
+    for(const struct arena_chunk* chunk = arena->chunks; chunk != NULL; chunk = chunk->next) {
+        mu_assert(chunk->used == 0, "reset");
+        chunk_count++;
+    }
+    mu_assert(chunk_count > 1, "chunks are kept across resets");
+    free(large);
+
+    event = betree_make_event_in_arena(tree, arena, "{\"i\": 1, \"s\": \"a\"}");
+    mu_assert(event->variables[1]->value.string_value.str != INVALID_STR, "filled");
+    betree_free_event_arena(arena);
+    betree_free(tree);
+    return 0;
+}
+
+int test_arena_origin()
+{
+    struct betree_event_arena* arena = betree_make_event_arena(0);
+    int64_t* heap = arena_malloc(4 * sizeof(*heap));
+    heap[3] = 7;
+    struct betree_event_arena* previous = use_event_arena(arena);
+    int64_t* carved = arena_malloc(4 * sizeof(*carved));
+    carved[3] = 9;
+    heap = arena_realloc(heap, 1024 * sizeof(*heap));
+    mu_assert(heap[3] == 7, "heap pointers grow on the heap");
+    arena_free(heap);
+    use_event_arena(previous);
+
+    mu_assert(active_event_arena() == previous, "no arena");
+    int64_t* copy = arena_realloc(carved, 1024 * sizeof(*copy));
+    mu_assert(copy != carved && copy[3] == 9, "arena pointers are copied out");
+    arena_free(carved);
+    arena_free(copy);
+    betree_free_event_arena(arena);
+    return 0;
+}
+
+int test_reader()
+{
+    struct betree_event* event;
+    mu_assert(event_read(NULL,
+                  "{ \"b\": true, \"i\": - 4, \"f\": 1.5, \"s\": 'a\\'b', \"n\": null,"
+                  "\"il\": [1, 2], \"sl\": [\"x,]\"], \"seg\": [[1,2],[3,4]],"
+                  "\"caps\": [[\"flight\",1,\"ns\",2,3], [[\"campaign\", 4, \"ns\"], 5, 6]], \"e\": [] }\n",
+                  &event)
+            == 0,
+        "read");
+    mu_assert(event->variable_count == 9 && test_bool_pred("b", true, event, 0)
+            && test_integer_pred("i", -4, event, 1) && test_float_pred("f", 1.5, event, 2)
+            && test_string_pred("s", "a\\'b", event, 3)
+            && test_integer_list_pred2("il", 1, 2, event, 4)
+            && test_string_list_pred1("sl", "x,]", event, 5)
+            && test_segment_list_pred2("seg", 1, 2, 3, 4, event, 6)
+            && test_frequency_list_pred2("caps", "flight", 1, "ns", 3, 2, "campaign", 4, "ns", 6, 5, event, 7)
+            && test_integer_list_pred0("e", event, 8),
+        "same event as event_parse");
+    free_event(event);
+
+    const char* invalid[] = { "", "{", "{\"a\": }", "{\"a\": 1,}", "{\"a\": 1} x", "{\"a\": [1, \"b\"]}",
+        "{\"a\": [[1, 2], [\"flight\", 1, \"ns\", 2, 3]]}", "{\"a\": \"open}", "{\"a\": 1e5}" };
+    for(size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); i++) {
+        mu_assert(event_read(NULL, invalid[i], &event) != 0, "invalid event");
+    }
+
+    struct betree* tree = betree_make();
+    betree_add_float_variable(tree, "f", false, 0., 10.);
+    betree_add_string_variable(tree, "s", false, 5);
+    betree_add_integer_variable(tree, "i", true, 0, 10);
+    mu_assert(betree_insert(tree, 1, "f > 1. and s = \"known\""), "");
+    mu_assert(event_read(tree->config, "{\"F\": 2, \"s\": \"known\"}", &event) == 0, "read filled");
+    mu_assert(event->variables[0]->attr_var.var == 0 && feq(event->variables[0]->value.float_value, 2.)
+            && event->variables[1]->value.string_value.str == 0,
+        "variables and strings are resolved");
+    free_event(event);
+    mu_assert(event_read(tree->config, "{\"f\": \"text\"}", &event) != 0, "type mismatch");
+    struct report* report = make_report();
+    mu_assert(!betree_search(tree, "{\"f\": \"text\", \"s\": \"known\"}", report)
+            && !betree_search(tree, "{\"f\": 2., \"s\": \"known\", \"i\": 2.0}", report)
+            && !betree_exists(tree, "{\"f\": 2., \"s\": \"known\", \"i\": 2.0}")
+            && !betree_search_ids(tree, "{\"f\": \"text\", \"s\": \"known\"}", report, NULL, 0)
+            && report->matched == 0,
+        "mistyped events fail the search");
+    mu_assert(betree_search(tree, "{\"f\": 2, \"s\": \"known\", \"i\": 2}", report)
+            && report->matched == 1,
+        "well typed event");
+    free_report(report);
+
+    struct betree_event_arena* arena = betree_make_event_arena(0);
+    struct betree_event_arena* previous = use_event_arena(arena);
+    mu_assert(event_read(tree->config, "{\"f\": 2., \"s\": \"known\"}", &event) == 0, "");
+    const struct string_map* string_map = get_string_map(tree->config, 1);
+    mu_assert(event->variables[1]->value.string_value.string
+            == get_interned_string(&string_map->strings, 0),
+        "known strings are not copied in an arena");
+    use_event_arena(previous);
+    betree_free_event_arena(arena);
+    betree_free(tree);
+    return 0;
+}
+
 int all_tests()
 {
     mu_run_test(test_bool);
@@ -427,6 +570,9 @@ int all_tests()
     mu_run_test(test_segment);
     mu_run_test(test_frequency);
     mu_run_test(test_null);
+    mu_run_test(test_arena);
+    mu_run_test(test_arena_origin);
+    mu_run_test(test_reader);
     return 0;
 }
 
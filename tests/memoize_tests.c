@@ -306,6 +306,62 @@ int test_sub()
     return 0;
 }
 
+int test_eager()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "i", false, 0, 10);
+    add_attr_domain_b(tree->config, "b", false);
+
+    mu_assert(betree_insert(tree, 1, "i = 0 and b"), "");
+    mu_assert(betree_insert(tree, 2, "not (i = 0) and b"), "");
+    mu_assert(betree_insert(tree, 3, "i = 0 or b"), "");
+    betree_set_eager_predicates(tree, 1);
+    mu_assert(tree->config->pred_map->eager_count == 1, "one eager pred");
+
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, "{\"i\": 1, \"b\": true}", report), "");
+    mu_assert(report->matched == 2, "matched 2 and 3");
+    mu_assert(report->shorted == 1, "sub 1 rejected before evaluation");
+    mu_assert(report->memoized == 3, "subs 2 and 3 reuse the eager result");
+    free_report(report);
+
+    report = make_report();
+    mu_assert(betree_search(tree, "{\"i\": 0, \"b\": false}", report), "");
+    mu_assert(report->matched == 1 && report->subs[0] == 3, "matched 3");
+    mu_assert(report->shorted == 1, "sub 2 rejected before evaluation");
+    free_report(report);
+
+    betree_free(tree);
+    return 0;
+}
+
+int test_eager_counts_inserted_subs()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "i", false, 0, 10);
+    add_attr_domain_b(tree->config, "b", false);
+
+    mu_assert(betree_insert(tree, 1, "i = 0 and b"), "");
+    mu_assert(betree_insert(tree, 2, "i = 0 or b"), "");
+    const struct betree_sub* dropped[3];
+    for(size_t i = 0; i < 3; i++) {
+        dropped[i] = betree_make_sub(tree, 10 + i, 0, NULL, "i = 5");
+        mu_assert(dropped[i] != NULL, "");
+    }
+    betree_set_eager_predicates(tree, 1);
+    mu_assert(tree->config->pred_map->eager_count == 1, "one eager pred");
+    const struct ast_node* eager = tree->config->pred_map->eager_nodes[0];
+    mu_assert(eager->type == AST_TYPE_EQUALITY_EXPR
+            && eager->equality_expr.value.integer_value == 0,
+        "subs that were never inserted do not count");
+
+    for(size_t i = 0; i < 3; i++) {
+        free_sub((struct betree_sub*)dropped[i]);
+    }
+    betree_free(tree);
+    return 0;
+}
+
 int test_bit_logic()
 {
     enum { pred_count = 250 };
@@ -338,6 +394,32 @@ int test_bit_logic()
     return 0;
 }
 
+int test_reset()
+{
+    enum { pred_count = 250 };
+    struct memoize memoize = acquire_memoize(pred_count);
+    mu_assert(memoize.touched != NULL, "reusable memoize tracks touched words");
+    set_memoize_pass(&memoize, 3);
+    set_memoize_fail(&memoize, 5);
+    set_memoize_pass(&memoize, 200);
+    mu_assert(memoize.touched_count == 2, "two words touched");
+    release_memoize(memoize);
+
+    struct memoize reused = acquire_memoize(pred_count);
+    mu_assert(reused.pass == memoize.pass && reused.fail == memoize.fail, "buffers are reused");
+    mu_assert(reused.touched_count == 0, "touched list is reset");
+    for(size_t i = 0; i < pred_count; i++) {
+        mu_assert(!test_bit(reused.pass, i) && !test_bit(reused.fail, i), "cleared %zu", i);
+    }
+
+    struct memoize nested = acquire_memoize(pred_count);
+    mu_assert(nested.touched == NULL && nested.pass != reused.pass, "nested use allocates");
+    release_memoize(nested);
+    release_memoize(reused);
+    free_memoize_cache();
+    return 0;
+}
+
 int all_tests() 
 {
     mu_run_test(test_compare_integer);
@@ -357,7 +439,10 @@ int all_tests()
     mu_run_test(test_special_string);
     mu_run_test(test_bool);
     mu_run_test(test_sub);
+    mu_run_test(test_eager);
+    mu_run_test(test_eager_counts_inserted_subs);
     mu_run_test(test_bit_logic);
+    mu_run_test(test_reset);
 
     return 0;
 }
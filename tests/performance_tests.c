@@ -4,14 +4,52 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "alloc.h"
+#include "arena.h"
 #include "betree.h"
+#include "betree_err.h"
 #include "debug.h"
+#include "event_reader.h"
+#include "helper.h"
+#include "interner.h"
+#include "map.h"
 #include "minunit.h"
+#include "tree.h"
 #include "utils.h"
 
 #define COUNT 1000
+#define VOCABULARY_COUNT 1000000
+#define ALLOCATOR_SUB_COUNT 20000
+#define ALLOCATOR_SEARCH_COUNT 10
+#define BUMP_ARENA_SIZE (256 * 1024 * 1024)
+#define PARSE_COUNT 100000
+#define REASON_SUB_COUNT 5000
+#define REASON_SEARCH_COUNT 2000
+#define REASON_ROUND_COUNT 20
+#define SEGMENT_COUNT 5000
+#define SEGMENT_SUB_COUNT 1000
+#define SEGMENT_SEARCH_COUNT 200
+#define SEGMENT_ID_COUNT 1000
+#define SEGMENT_PARTITION_SUB_COUNT 5000
+#define SEGMENT_PARTITION_SEARCH_COUNT 2000
+#define FREQUENCY_CAP_COUNT 500
+#define FREQUENCY_SUB_COUNT 1000
+#define FREQUENCY_SEARCH_COUNT 200
+#define GEO_SUB_COUNT 5000
+#define GEO_SEARCH_COUNT 2000
+#define STRING_PATTERN_COUNT 600
+#define STRING_SEARCH_COUNT 2000
+#define LONG_USER_AGENT_LENGTH 4096
+#define LONG_USER_AGENT_SEARCH_COUNT 200000
+
+int event_parse(const char* text, struct betree_event** event);
+
+static uint64_t elapsed_us(const struct timespec* from, const struct timespec* to)
+{
+    return (to->tv_sec - from->tv_sec) * 1000000 + (to->tv_nsec - from->tv_nsec) / 1000;
+}
 
 int test_cdir_split()
 {
@@ -113,12 +151,783 @@ int test_pdir_split()
     return 0;
 }
 
+int test_string_interning()
+{
+    char** strings = malloc(VOCABULARY_COUNT * sizeof(*strings));
+    for(size_t i = 0; i < VOCABULARY_COUNT; i++) {
+        if(basprintf(&strings[i], "campaign-%zu-%zx", i, i * 2654435761u) < 0) {
+            abort();
+        }
+    }
+
+    struct timespec start, insert_done, search_done;
+
+    map_t(betree_str_t) map;
+    map_init(&map);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t i = 0; i < VOCABULARY_COUNT; i++) {
+        map_set(&map, strings[i], i);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &insert_done);
+    size_t found = 0;
+    for(size_t i = 0; i < VOCABULARY_COUNT; i++) {
+        betree_str_t* str = map_get(&map, strings[(i * 7919) % VOCABULARY_COUNT]);
+        found += str != NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &search_done);
+    mu_assert(found == VOCABULARY_COUNT, "map found all strings");
+    printf("    Map insert took %" PRIu64 "\n", elapsed_us(&start, &insert_done));
+    printf("    Map search took %" PRIu64 "\n", elapsed_us(&insert_done, &search_done));
+    map_deinit(&map);
+
+    struct string_interner interner;
+    init_string_interner(&interner);
+    reserve_string_interner(&interner, VOCABULARY_COUNT);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t i = 0; i < VOCABULARY_COUNT; i++) {
+        intern_string(&interner, strings[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &insert_done);
+    found = 0;
+    for(size_t i = 0; i < VOCABULARY_COUNT; i++) {
+        size_t index = (i * 7919) % VOCABULARY_COUNT;
+        found += find_interned_string(&interner, strings[index]) == index;
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &search_done);
+    mu_assert(found == VOCABULARY_COUNT, "interner found all strings");
+    mu_assert(find_interned_string(&interner, "campaign") == INVALID_STR, "missing string");
+    printf("    Interner insert took %" PRIu64 "\n", elapsed_us(&start, &insert_done));
+    printf("    Interner search took %" PRIu64 "\n", elapsed_us(&insert_done, &search_done));
+    deinit_string_interner(&interner);
+
+    for(size_t i = 0; i < VOCABULARY_COUNT; i++) {
+        free(strings[i]);
+    }
+    free(strings);
+    return 0;
+}
+
+static size_t read_lines(const char* path, char*** lines)
+{
+    FILE* file = fopen(path, "r");
+    if(file == NULL) {
+        return 0;
+    }
+    size_t count = 0;
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while((length = getline(&line, &capacity, file)) > 0) {
+        if(line[length - 1] == '\n') {
+            line[length - 1] = '\0';
+        }
+        *lines = realloc(*lines, (count + 1) * sizeof(**lines));
+        (*lines)[count] = strdup(line);
+        count++;
+    }
+    free(line);
+    fclose(file);
+    return count;
+}
+
+static void free_lines(size_t count, char** lines)
+{
+    for(size_t i = 0; i < count; i++) {
+        free(lines[i]);
+    }
+    free(lines);
+}
+
+// The files real_tests.c reads, or the sample of the same format under data/ when they are absent
+struct real_data {
+    size_t def_count;
+    char** defs;
+    size_t expr_count;
+    char** exprs;
+    size_t constant_count;
+    char** constants;
+    size_t event_count;
+    char** events;
+};
+
+static size_t read_real_data_file(const char* name, char*** lines)
+{
+    char path[64];
+    sprintf(path, "data/%s_basic", name);
+    if(access(path, F_OK) == -1) {
+        sprintf(path, "data/%s", name);
+    }
+    return read_lines(path, lines);
+}
+
+static void read_real_data(struct real_data* data)
+{
+    memset(data, 0, sizeof(*data));
+    data->def_count = read_real_data_file("betree_defs", &data->defs);
+    data->expr_count = read_real_data_file("betree_exprs", &data->exprs);
+    data->constant_count = read_real_data_file("betree_constants", &data->constants);
+    data->event_count = read_real_data_file("betree_events", &data->events);
+}
+
+static void free_real_data(struct real_data* data)
+{
+    free_lines(data->def_count, data->defs);
+    free_lines(data->expr_count, data->exprs);
+    free_lines(data->constant_count, data->constants);
+    free_lines(data->event_count, data->events);
+}
+
+static bool insert_real_exprs(struct betree* tree, const struct real_data* data)
+{
+    enum e { constant_count = 4 };
+    for(size_t i = 0; i < data->expr_count; i++) {
+        int64_t ids[5];
+        if(sscanf(data->constants[i], "%ld,%ld,%ld,%ld,%ld", &ids[0], &ids[1], &ids[2], &ids[3], &ids[4])
+            != 5) {
+            return false;
+        }
+        const struct betree_constant* constants[constant_count] = {
+            betree_make_integer_constant("campaign_group_id", ids[1]),
+            betree_make_integer_constant("campaign_id", ids[2]),
+            betree_make_integer_constant("advertiser_id", ids[3]),
+            betree_make_integer_constant("flight_id", ids[4]),
+        };
+        const struct betree_sub* sub
+            = betree_make_sub(tree, ids[0], constant_count, constants, data->exprs[i]);
+        betree_free_constants(constant_count, (struct betree_constant**)constants);
+        if(sub == NULL || !betree_insert_sub(tree, sub)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct bump_arena {
+    size_t used;
+    size_t calls;
+    unsigned char* data;
+};
+
+static void* bump_malloc(void* context, size_t size)
+{
+    struct bump_arena* arena = context;
+    size_t aligned = (size + sizeof(size_t) + 15) & ~(size_t)15;
+    if(arena->used + aligned > BUMP_ARENA_SIZE) {
+        return NULL;
+    }
+    unsigned char* block = arena->data + arena->used;
+    *(size_t*)block = size;
+    arena->used += aligned;
+    arena->calls++;
+    return block + sizeof(size_t);
+}
+
+static void* bump_calloc(void* context, size_t size)
+{
+    void* ptr = bump_malloc(context, size);
+    if(ptr != NULL) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+static void* bump_realloc(void* context, void* ptr, size_t size)
+{
+    void* copy = bump_malloc(context, size);
+    if(copy != NULL && ptr != NULL) {
+        size_t old_size = *(size_t*)((unsigned char*)ptr - sizeof(size_t));
+        memcpy(copy, ptr, old_size < size ? old_size : size);
+    }
+    return copy;
+}
+
+static void bump_free(void* context, void* ptr)
+{
+    (void)context;
+    (void)ptr;
+}
+
+// Builds, searches and frees a tree from the data set in rounds. The bump arena is rewound after
+// each round, as a caller owning the arena would.
+static int run_allocator_workload(
+    const struct real_data* data, const struct betree_allocator* allocator, const char* name)
+{
+    size_t round_count = smax(1, ALLOCATOR_SUB_COUNT / smax(1, data->expr_count));
+    uint64_t insert_us = 0, search_us = 0, free_us = 0;
+    size_t matched = 0;
+    for(size_t round = 0; round < round_count; round++) {
+        struct betree* tree
+            = allocator == NULL ? betree_make() : betree_make_with_allocator(allocator);
+        for(size_t i = 0; i < data->def_count; i++) {
+            add_variable_from_string(tree, data->defs[i]);
+        }
+        struct timespec start, insert_done, search_done, free_done;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+        mu_assert(insert_real_exprs(tree, data), "inserted the data set");
+        clock_gettime(CLOCK_MONOTONIC_RAW, &insert_done);
+        for(size_t i = 0; i < ALLOCATOR_SEARCH_COUNT; i++) {
+            struct report* report = make_report();
+            mu_assert(betree_search(tree, data->events[i % data->event_count], report), "searched");
+            matched += report->matched;
+            free_report(report);
+        }
+        clock_gettime(CLOCK_MONOTONIC_RAW, &search_done);
+        betree_free(tree);
+        clock_gettime(CLOCK_MONOTONIC_RAW, &free_done);
+        insert_us += elapsed_us(&start, &insert_done);
+        search_us += elapsed_us(&insert_done, &search_done);
+        free_us += elapsed_us(&search_done, &free_done);
+        if(allocator != NULL) {
+            ((struct bump_arena*)allocator->context)->used = 0;
+        }
+    }
+    printf("    %s: %zu rounds, matched %zu\n", name, round_count, matched);
+    printf("    %s insert took %" PRIu64 "\n", name, insert_us);
+    printf("    %s search took %" PRIu64 "\n", name, search_us);
+    printf("    %s free took %" PRIu64 "\n", name, free_us);
+    return 0;
+}
+
+int test_allocator()
+{
+    struct real_data data;
+    read_real_data(&data);
+    if(data.expr_count == 0 || data.event_count == 0 || data.constant_count < data.expr_count) {
+        printf("    Missing data set, skipping\n");
+        free_real_data(&data);
+        return 0;
+    }
+    printf("    %zu expressions, %zu events\n", data.expr_count, data.event_count);
+    mu_assert(run_allocator_workload(&data, NULL, "Default") == 0, "");
+
+    struct bump_arena arena = { .used = 0, .calls = 0, .data = malloc(BUMP_ARENA_SIZE) };
+    mu_assert(arena.data != NULL, "bump arena");
+    struct betree_allocator allocator = {
+        .malloc = bump_malloc,
+        .calloc = bump_calloc,
+        .realloc = bump_realloc,
+        .free = bump_free,
+        .context = &arena,
+    };
+    mu_assert(run_allocator_workload(&data, &allocator, "Bump") == 0, "");
+    printf("    Bump arena served %zu allocations\n", arena.calls);
+    free(arena.data);
+    free_real_data(&data);
+    return 0;
+}
+
+static uint64_t time_event_parsing(const struct config* config,
+    struct betree_event_arena* arena,
+    char** events,
+    size_t event_count,
+    bool use_reader)
+{
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    struct betree_event_arena* previous = use_event_arena(arena);
+    for(size_t i = 0; i < PARSE_COUNT; i++) {
+        struct betree_event* event;
+        const char* text = events[i % event_count];
+        int rc = use_reader ? event_read(config, text, &event) : event_parse(text, &event);
+        if(rc != 0) {
+            abort();
+        }
+        if(arena == NULL) {
+            free_event(event);
+        }
+        else {
+            reset_event_arena(arena);
+        }
+    }
+    use_event_arena(previous);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    return elapsed_us(&start, &done);
+}
+
+int test_event_parsing()
+{
+    char** events = NULL;
+    size_t event_count = read_lines("data/betree_events", &events);
+    if(event_count != 0) {
+        printf("    %zu events from data/betree_events\n", event_count);
+        printf("    Bison took %" PRIu64 "\n", time_event_parsing(NULL, NULL, events, event_count, false));
+        printf("    Reader took %" PRIu64 "\n", time_event_parsing(NULL, NULL, events, event_count, true));
+        free_lines(event_count, events);
+    }
+
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "i", false, 0, 100);
+    betree_add_float_variable(tree, "f", false, 0., 10.);
+    betree_add_string_variable(tree, "s", false, 10);
+    betree_add_integer_list_variable(tree, "il", false, 0, 100);
+    betree_add_string_list_variable(tree, "sl", false, 10);
+    betree_add_segments_variable(tree, "seg", false);
+    betree_add_frequency_caps_variable(tree, "caps", false);
+    mu_assert(betree_insert(tree, 1, "s = \"s1\" or s = \"s2\" or s = \"s3\""), "");
+    mu_assert(betree_insert(tree, 2, "\"s1\" in sl or \"s2\" in sl"), "");
+    char rich_event[] = "{\"i\": 12, \"f\": 1.5, \"s\": \"s3\", \"il\": [1, 2, 3, 4, 5, 6, 7, 8],"
+                 " \"sl\": [\"s1\", \"s2\", \"unknown\"], \"seg\": [[1, 100], [2, 200], [3, 300]],"
+                 " \"caps\": [[\"flight\", 1, \"s1\", 2, 3], [[\"campaign\", 4, \"s2\"], 5, 6]]}";
+    char* rich = rich_event;
+    struct betree_event_arena* arena = make_event_arena(0);
+    printf("    Rich event\n");
+    printf("    Bison took %" PRIu64 "\n", time_event_parsing(NULL, NULL, &rich, 1, false));
+    printf("    Bison in an arena took %" PRIu64 "\n", time_event_parsing(NULL, arena, &rich, 1, false));
+    printf("    Reader took %" PRIu64 "\n", time_event_parsing(NULL, NULL, &rich, 1, true));
+    printf("    Reader filled took %" PRIu64 "\n", time_event_parsing(tree->config, NULL, &rich, 1, true));
+    printf("    Reader filled in an arena took %" PRIu64 "\n", time_event_parsing(tree->config, arena, &rich, 1, true));
+    free_event_arena(arena);
+
+    struct timespec start, done;
+    struct betree_bound_event* bound = betree_make_bound_event(tree);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t i = 0; i < PARSE_COUNT; i++) {
+        if(!betree_read_bound_event(bound, rich)) {
+            abort();
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Reader into a bound event took %" PRIu64 "\n", elapsed_us(&start, &done));
+    betree_free_bound_event(bound);
+    betree_free(tree);
+    return 0;
+}
+
+static uint64_t time_search(const struct betree* tree, const char* event, const void* buffer, size_t length)
+{
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t i = 0; i < PARSE_COUNT; i++) {
+        struct report* report = make_report();
+        bool found = buffer == NULL ? betree_search(tree, event, report)
+                                    : betree_search_binary(tree, buffer, length, report);
+        if(!found || report->matched != 2) {
+            abort();
+        }
+        free_report(report);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    return elapsed_us(&start, &done);
+}
+
+int test_binary_event()
+{
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "i", false, 0, 100);
+    betree_add_float_variable(tree, "f", false, 0., 10.);
+    betree_add_string_variable(tree, "s", false, 10);
+    betree_add_integer_list_variable(tree, "il", false, 0, 100);
+    betree_add_string_list_variable(tree, "sl", false, 10);
+    betree_add_segments_variable(tree, "seg", false);
+    mu_assert(betree_insert(tree, 1, "s = \"s1\" or s = \"s3\""), "");
+    mu_assert(betree_insert(tree, 2, "\"s1\" in sl and 4 in il"), "");
+    const char* event = "{\"i\": 12, \"f\": 1.5, \"s\": \"s3\", \"il\": [1, 2, 3, 4, 5, 6, 7, 8],"
+                        " \"sl\": [\"s1\", \"s2\", \"unknown\"], \"seg\": [[1, 100], [2, 200], [3, 300]]}";
+
+    struct betree_integer_list* il = betree_make_integer_list(8);
+    for(size_t i = 0; i < 8; i++) {
+        betree_add_integer(il, i, i + 1);
+    }
+    struct betree_string_list* sl = betree_make_string_list(3);
+    betree_add_string(sl, 0, "s1");
+    betree_add_string(sl, 1, "s2");
+    betree_add_string(sl, 2, "unknown");
+    struct betree_segments* seg = betree_make_segments(3);
+    for(size_t i = 0; i < 3; i++) {
+        betree_add_segment(seg, i, betree_make_segment(i + 1, (i + 1) * 100));
+    }
+    size_t s_index = betree_get_variable_index(tree, "s");
+    struct betree_binary_encoder* encoder = betree_make_binary_encoder();
+    betree_encode_integer(encoder, betree_get_variable_index(tree, "i"), 12);
+    betree_encode_float(encoder, betree_get_variable_index(tree, "f"), 1.5);
+    betree_encode_string(encoder, s_index, betree_intern_string(tree, s_index, "s3"), "s3");
+    betree_encode_integer_list(encoder, betree_get_variable_index(tree, "il"), il);
+    betree_encode_string_list(encoder, betree_get_variable_index(tree, "sl"), sl);
+    betree_encode_segments(encoder, betree_get_variable_index(tree, "seg"), seg);
+    free_integer_list(il);
+    free_string_list(sl);
+    free_segments(seg);
+    size_t length;
+    const void* buffer = betree_binary_encoder_data(encoder, &length);
+
+    printf("    JSON search took %" PRIu64 "\n", time_search(tree, event, NULL, 0));
+    printf("    Binary search took %" PRIu64 "\n", time_search(tree, NULL, buffer, length));
+    betree_free_binary_encoder(encoder);
+    betree_free_search_cache();
+    betree_free(tree);
+    return 0;
+}
+
+int test_reason_mode()
+{
+    struct betree_err* tree = betree_make_err();
+    betree_add_integer_variable_err(tree, "i", false, 0, 100);
+    betree_add_integer_variable_err(tree, "j", false, 0, 100);
+    betree_add_boolean_variable_err(tree, "b", false);
+    for(size_t k = 0; k < REASON_SUB_COUNT; k++) {
+        char* expr;
+        if(basprintf(&expr, "i = %zu and (j > %zu or b)", k % 100, k % 37) < 0) {
+            abort();
+        }
+        mu_assert(betree_insert_err(tree, k + 1, expr), "");
+        free(expr);
+    }
+    const char* event = "{\"i\": 42, \"j\": 20, \"b\": false}";
+
+    // Best of several rounds, to compare the plain search across builds on a noisy host
+    struct timespec start, done;
+    uint64_t best = UINT64_MAX;
+    for(size_t round = 0; round < REASON_ROUND_COUNT; round++) {
+        clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+        for(size_t k = 0; k < REASON_SEARCH_COUNT; k++) {
+            struct report* report = make_report();
+            mu_assert(betree_search(tree->betree, event, report), "");
+            free_report(report);
+        }
+        clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+        uint64_t elapsed = elapsed_us(&start, &done);
+        best = elapsed < best ? elapsed : best;
+    }
+    printf("    Search took %" PRIu64 " (best of %d rounds)\n", best, REASON_ROUND_COUNT);
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < REASON_SEARCH_COUNT; k++) {
+        struct report_err* report = make_report_err(tree);
+        mu_assert(betree_search_err(tree, event, report), "");
+        free_report_err(report);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Search with reasons took %" PRIu64 "\n", elapsed_us(&start, &done));
+
+    struct report_err* report = make_report_err(tree);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < REASON_SEARCH_COUNT; k++) {
+        clear_report_err(report);
+        mu_assert(betree_search_err(tree, event, report), "");
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Search with reasons reusing the report took %" PRIu64 "\n",
+        elapsed_us(&start, &done));
+
+    betree_make_sub_ids(tree);
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < REASON_SEARCH_COUNT; k++) {
+        clear_report_err(report);
+        mu_assert(betree_search_err(tree, event, report), "");
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Search with reasons and sub ranges took %" PRIu64 "\n", elapsed_us(&start, &done));
+    free_report_err(report);
+    betree_free_err(tree);
+    return 0;
+}
+
+int test_segment_lookup()
+{
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "now", false, 0, 100);
+    betree_add_segments_variable(tree, "seg", false);
+    for(size_t k = 0; k < SEGMENT_SUB_COUNT; k++) {
+        char* expr;
+        if(basprintf(&expr, "segment_within(seg, %zu, 20) or segment_before(seg, %zu, 20)",
+               k * 7 % (2 * SEGMENT_COUNT), k * 13 % (2 * SEGMENT_COUNT))
+            < 0) {
+            abort();
+        }
+        mu_assert(betree_insert(tree, k + 1, expr), "");
+        free(expr);
+    }
+    struct betree_event* event = betree_make_event(tree);
+    struct betree_segments* segments = betree_make_segments(SEGMENT_COUNT);
+    for(size_t i = 0; i < SEGMENT_COUNT; i++) {
+        betree_add_segment(segments, i, betree_make_segment(2 * i, (int64_t)(i % 60) * 1000000));
+    }
+    betree_set_variable(event, 0, betree_make_integer_variable("now", 60));
+    betree_set_variable(event, 1, betree_make_segments_variable("seg", segments));
+
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < SEGMENT_SEARCH_COUNT; k++) {
+        struct report* report = make_report();
+        mu_assert(betree_search_with_event(tree, event, report), "");
+        free_report(report);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Segment search took %" PRIu64 "\n", elapsed_us(&start, &done));
+    betree_free_event(event);
+    betree_free(tree);
+    return 0;
+}
+
+int test_segment_partition()
+{
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "now", false, 0, 100);
+    betree_add_bounded_segments_variable(tree, "seg", false, 0, SEGMENT_ID_COUNT - 1);
+    for(size_t k = 0; k < SEGMENT_PARTITION_SUB_COUNT; k++) {
+        char* expr;
+        if(basprintf(&expr, "segment_within(seg, %zu, 20)", k * 7 % SEGMENT_ID_COUNT) < 0) {
+            abort();
+        }
+        mu_assert(betree_insert(tree, k + 1, expr), "");
+        bfree(expr);
+    }
+    srand(11);
+    struct betree_event** events = bmalloc(SEGMENT_PARTITION_SEARCH_COUNT * sizeof(*events));
+    for(size_t k = 0; k < SEGMENT_PARTITION_SEARCH_COUNT; k++) {
+        struct betree_segments* segments = betree_make_segments(10);
+        for(size_t i = 0; i < 10; i++) {
+            int64_t id = (int64_t)(i * (SEGMENT_ID_COUNT / 10) + rand() % (SEGMENT_ID_COUNT / 10));
+            betree_add_segment(segments, i, betree_make_segment(id, 50 * 1000000));
+        }
+        events[k] = betree_make_event(tree);
+        betree_set_variable(events[k], 0, betree_make_integer_variable("now", 60));
+        betree_set_variable(events[k], 1, betree_make_segments_variable("seg", segments));
+    }
+
+    size_t matched = 0;
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < SEGMENT_PARTITION_SEARCH_COUNT; k++) {
+        struct report* report = make_report();
+        mu_assert(betree_search_with_event(tree, events[k], report), "");
+        matched += report->matched;
+        free_report(report);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Partitioned segment search took %" PRIu64 ", %zu matched\n",
+        elapsed_us(&start, &done),
+        matched);
+    for(size_t k = 0; k < SEGMENT_PARTITION_SEARCH_COUNT; k++) {
+        betree_free_event(events[k]);
+    }
+    bfree(events);
+    betree_free(tree);
+    return 0;
+}
+
+int test_frequency_lookup()
+{
+    struct betree* tree = betree_make();
+    betree_add_integer_variable(tree, "now", false, 0, 100);
+    betree_add_frequency_caps_variable(tree, "frequency_caps", false);
+    for(size_t k = 0; k < FREQUENCY_SUB_COUNT; k++) {
+        const struct betree_constant* constants[]
+            = { betree_make_integer_constant("flight_id", k) };
+        mu_assert(betree_insert_with_constants(
+                      tree, k + 1, 1, constants, "within_frequency_cap(\"flight\", \"ns\", 5, 0)"),
+            "");
+        betree_free_constant((struct betree_constant*)constants[0]);
+    }
+    struct betree_event* event = betree_make_event(tree);
+    struct betree_frequency_caps* caps = betree_make_frequency_caps(FREQUENCY_CAP_COUNT);
+    for(size_t i = 0; i < FREQUENCY_CAP_COUNT; i++) {
+        betree_add_frequency_cap(caps, i, betree_make_frequency_cap("flight", 2 * i, "ns", false, 0, i % 10));
+    }
+    betree_set_variable(event, 0, betree_make_integer_variable("now", 60));
+    betree_set_variable(event, 1, betree_make_frequency_caps_variable("frequency_caps", caps));
+
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < FREQUENCY_SEARCH_COUNT; k++) {
+        struct report* report = make_report();
+        mu_assert(betree_search_with_event(tree, event, report), "");
+        free_report(report);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Frequency cap search took %" PRIu64 "\n", elapsed_us(&start, &done));
+    betree_free_event(event);
+    betree_free(tree);
+    return 0;
+}
+
+int test_geo_lookup()
+{
+    struct betree* tree = betree_make();
+    betree_add_float_variable(tree, "latitude", false, -90., 90.);
+    betree_add_float_variable(tree, "longitude", false, -180., 180.);
+    srand(7);
+    for(size_t k = 0; k < GEO_SUB_COUNT; k++) {
+        char* expr;
+        if(basprintf(&expr,
+               "geo_within_radius(%.3f, %.3f, %d.0)",
+               25. + (rand() % 25000) / 1000.,
+               -125. + (rand() % 60000) / 1000.,
+               5 + rand() % 95)
+            < 0) {
+            abort();
+        }
+        mu_assert(betree_insert(tree, k + 1, expr), "");
+        bfree(expr);
+    }
+    struct betree_event** events = bmalloc(GEO_SEARCH_COUNT * sizeof(*events));
+    for(size_t k = 0; k < GEO_SEARCH_COUNT; k++) {
+        events[k] = betree_make_event(tree);
+        betree_set_variable(events[k], 0,
+            betree_make_float_variable("latitude", 25. + (rand() % 25000) / 1000.));
+        betree_set_variable(events[k], 1,
+            betree_make_float_variable("longitude", -125. + (rand() % 60000) / 1000.));
+    }
+
+    size_t matched = 0;
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < GEO_SEARCH_COUNT; k++) {
+        struct report* report = make_report();
+        mu_assert(betree_search_with_event(tree, events[k], report), "");
+        matched += report->matched;
+        free_report(report);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Geo search took %" PRIu64 ", %zu matched\n", elapsed_us(&start, &done), matched);
+    for(size_t k = 0; k < GEO_SEARCH_COUNT; k++) {
+        betree_free_event(events[k]);
+    }
+    bfree(events);
+    betree_free(tree);
+    return 0;
+}
+
+static const char* user_agents[] = {
+    "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/118.0.0.0 Safari/537.36",
+    "Mozilla/5.0 (iPhone; CPU iPhone OS 17_0 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like "
+    "Gecko) Version/17.0 Mobile/15E148 Safari/604.1",
+    "Mozilla/5.0 (Linux; Android 13; SM-S908B) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/112.0.0.0 Mobile Safari/537.36",
+    "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/605.1.15 (KHTML, like Gecko) "
+    "Version/16.1 Safari/605.1.15",
+    "Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/119.0",
+};
+
+int test_string_patterns()
+{
+    struct betree* tree = betree_make();
+    betree_add_string_variable(tree, "user_agent", false, SIZE_MAX);
+    const char* ops[] = { "contains", "starts_with", "ends_with" };
+    for(size_t k = 0; k < STRING_PATTERN_COUNT; k++) {
+        char* expr;
+        if(basprintf(&expr,
+               "%s(user_agent, \"%s/%zu\")",
+               ops[k % 3],
+               k % 2 == 0 ? "Chrome" : "Version",
+               k % 200)
+            < 0) {
+            abort();
+        }
+        mu_assert(betree_insert(tree, k + 1, expr), "");
+        bfree(expr);
+    }
+    size_t user_agent_count = sizeof(user_agents) / sizeof(user_agents[0]);
+    struct betree_event** events = bmalloc(user_agent_count * sizeof(*events));
+    for(size_t k = 0; k < user_agent_count; k++) {
+        events[k] = betree_make_event(tree);
+        betree_set_variable(
+            events[k], 0, betree_make_string_variable("user_agent", user_agents[k]));
+    }
+
+    size_t matched = 0;
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < STRING_SEARCH_COUNT; k++) {
+        struct report* report = make_report();
+        mu_assert(betree_search_with_event(tree, events[k % user_agent_count], report), "");
+        matched += report->matched;
+        free_report(report);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    String pattern search took %" PRIu64 ", %zu matched\n",
+        elapsed_us(&start, &done),
+        matched);
+    for(size_t k = 0; k < user_agent_count; k++) {
+        betree_free_event(events[k]);
+    }
+    bfree(events);
+    betree_free(tree);
+    return 0;
+}
+
+int test_long_user_agents()
+{
+    struct betree* tree = betree_make();
+    betree_add_string_variable(tree, "user_agent", false, SIZE_MAX);
+    const char* exprs[] = { "starts_with(user_agent, \"Mozilla/5.0 (Windows\")",
+        "starts_with(user_agent, \"Mozilla/5.0 (iPhone\")",
+        "ends_with(user_agent, \"Safari/537.36\")",
+        "ends_with(user_agent, \"Firefox/119.0\")",
+        "ends_with(user_agent, \"Mobile/15E148 Safari/604.1\")",
+        "contains(user_agent, \"Android 13\")" };
+    size_t expr_count = sizeof(exprs) / sizeof(exprs[0]);
+    for(size_t k = 0; k < expr_count; k++) {
+        mu_assert(betree_insert(tree, k + 1, exprs[k]), "");
+    }
+    size_t user_agent_count = sizeof(user_agents) / sizeof(user_agents[0]);
+    struct betree_event** events = bmalloc(user_agent_count * sizeof(*events));
+    char* long_user_agent = bmalloc(LONG_USER_AGENT_LENGTH + 1);
+    for(size_t k = 0; k < user_agent_count; k++) {
+        // Padded in the middle so the prefix and suffix patterns still apply
+        size_t length = strlen(user_agents[k]), half = length / 2;
+        memcpy(long_user_agent, user_agents[k], half);
+        size_t padding = LONG_USER_AGENT_LENGTH - length;
+        for(size_t i = 0; i < padding; i++) {
+            long_user_agent[half + i] = "abcdefgh; "[i % 10];
+        }
+        memcpy(long_user_agent + half + padding, user_agents[k] + half, length - half + 1);
+        events[k] = betree_make_event(tree);
+        betree_set_variable(
+            events[k], 0, betree_make_string_variable("user_agent", long_user_agent));
+    }
+    bfree(long_user_agent);
+
+    size_t matched = 0;
+    struct timespec start, done;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+    for(size_t k = 0; k < LONG_USER_AGENT_SEARCH_COUNT; k++) {
+        struct report* report = make_report();
+        mu_assert(betree_search_with_event(tree, events[k % user_agent_count], report), "");
+        matched += report->matched;
+        free_report(report);
+    }
+    clock_gettime(CLOCK_MONOTONIC_RAW, &done);
+    printf("    Long user agent search took %" PRIu64 ", %zu matched\n",
+        elapsed_us(&start, &done),
+        matched);
+    for(size_t k = 0; k < user_agent_count; k++) {
+        betree_free_event(events[k]);
+    }
+    bfree(events);
+    betree_free(tree);
+    return 0;
+}
+
 int all_tests()
 {
     mu_run_test(test_cdir_split);
     printf("\n");
     mu_run_test(test_pdir_split);
     printf("\n");
+    mu_run_test(test_string_interning);
+    printf("\n");
+    mu_run_test(test_allocator);
+    printf("\n");
+    mu_run_test(test_event_parsing);
+    printf("\n");
+    mu_run_test(test_binary_event);
+    printf("\n");
+    mu_run_test(test_reason_mode);
+    printf("\n");
+    mu_run_test(test_segment_lookup);
+    printf("\n");
+    mu_run_test(test_segment_partition);
+    printf("\n");
+    mu_run_test(test_frequency_lookup);
+    printf("\n");
+    mu_run_test(test_geo_lookup);
+    printf("\n");
+    mu_run_test(test_string_patterns);
+    printf("\n");
+    mu_run_test(test_long_user_agents);
+    printf("\n");
 
     return 0;
 }
@@ -0,0 +1,96 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "ast.h"
+#include "betree.h"
+#include "minunit.h"
+#include "pred_cache.h"
+#include "tree.h"
+
+static struct report* search(struct betree* tree, struct betree_pred_cache* cache, const char* event_str)
+{
+    struct betree_event* event = make_event_from_string(tree, event_str);
+    struct report* report = make_report();
+    if(betree_search_with_event_cache(tree, event, cache, report) == false) {
+        fprintf(stderr, "Failed to search for event\n");
+        abort();
+    }
+    betree_free_event(event);
+    return report;
+}
+
+int test_hit_miss()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "i", false, 0, 10);
+    add_attr_domain_s(tree->config, "s", false);
+
+    mu_assert(betree_insert(tree, 1, "i = 1 and s = \"a\""), "");
+    mu_assert(betree_insert(tree, 2, "i = 1 and s = \"b\""), "");
+    mu_assert(betree_insert(tree, 3, "i > 5 and s = \"a\""), "");
+    mu_assert(betree_insert(tree, 4, "i > 5 and s = \"b\""), "");
+
+    struct betree_pred_cache* cache = betree_make_pred_cache(tree, 16);
+    mu_assert(cache->attrs[0].pred_count == 2, "i = 1 and i > 5 are cached");
+    mu_assert(cache->attrs[1].pred_count == 2, "s = a and s = b are cached");
+
+    struct report* report = search(tree, cache, "{\"i\": 1, \"s\": \"a\"}");
+    mu_assert(report->pred_cache_hits == 0 && report->pred_cache_misses == 2, "cold cache");
+    mu_assert(report->matched == 1 && report->subs[0] == 1, "matched 1");
+    free_report(report);
+
+    report = search(tree, cache, "{\"i\": 1, \"s\": \"b\"}");
+    mu_assert(report->pred_cache_hits == 1 && report->pred_cache_misses == 1, "i hits, s misses");
+    mu_assert(report->matched == 1 && report->subs[0] == 2, "matched 2");
+    free_report(report);
+
+    report = search(tree, cache, "{\"i\": 7, \"s\": \"b\"}");
+    mu_assert(report->pred_cache_hits == 1 && report->pred_cache_misses == 1, "s hits, i misses");
+    mu_assert(report->matched == 1 && report->subs[0] == 4, "matched 4");
+    free_report(report);
+
+    report = search(tree, cache, "{\"i\": 7, \"s\": \"c\"}");
+    mu_assert(report->pred_cache_hits == 1 && report->pred_cache_misses == 0, "unknown strings are not cached");
+    mu_assert(report->matched == 0, "matched none");
+    free_report(report);
+
+    betree_free_pred_cache(cache);
+    betree_free(tree);
+    return 0;
+}
+
+int test_bounded()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "i", false, 0, 10);
+
+    mu_assert(betree_insert(tree, 1, "i = 1 or i = 2"), "");
+    mu_assert(betree_insert(tree, 2, "i = 1 or i = 3"), "");
+
+    struct betree_pred_cache* cache = betree_make_pred_cache(tree, 2);
+    const char* events[] = { "{\"i\": 1}", "{\"i\": 2}", "{\"i\": 3}" };
+    size_t matched[] = { 2, 1, 1 };
+    for(size_t i = 0; i < 6; i++) {
+        struct report* report = search(tree, cache, events[i % 3]);
+        mu_assert(report->pred_cache_misses == 1, "least recently used entry is replaced");
+        mu_assert(report->matched == matched[i % 3], "results stay correct");
+        free_report(report);
+    }
+    struct report* report = search(tree, cache, events[2]);
+    mu_assert(report->pred_cache_hits == 1, "most recent value is kept");
+    free_report(report);
+
+    betree_free_pred_cache(cache);
+    betree_free(tree);
+    return 0;
+}
+
+int all_tests()
+{
+    mu_run_test(test_hit_miss);
+    mu_run_test(test_bounded);
+
+    return 0;
+}
+
+RUN_TESTS()
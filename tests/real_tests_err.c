@@ -20,7 +20,6 @@
 #include "helper_err.h"
 #include "printer.h"
 #include "tree.h"
-#include "tree_err.h"
 #include "utils.h"
 
 #define MAX_EXPRS 10000
@@ -0,0 +1,102 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "betree.h"
+#include "minunit.h"
+#include "result_cache.h"
+#include "tree.h"
+
+static struct report* search(struct betree* tree, struct betree_result_cache* cache, const char* event_str)
+{
+    struct betree_event* event = make_event_from_string(tree, event_str);
+    struct report* report = make_report();
+    if(betree_search_with_event_result_cache(tree, event, cache, report) == false) {
+        fprintf(stderr, "Failed to search for event\n");
+        abort();
+    }
+    betree_free_event(event);
+    return report;
+}
+
+int test_hit()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "i", false, 0, 10);
+    add_attr_domain_sl(tree->config, "sl", true);
+    add_attr_domain_bounded_i(tree->config, "now", true, 0, 1000);
+
+    mu_assert(betree_insert(tree, 1, "i = 1"), "");
+    mu_assert(betree_insert(tree, 2, "sl one of (\"a\", \"b\")"), "");
+
+    struct betree_result_cache* cache = betree_make_result_cache(tree, 4);
+    mu_assert(betree_result_cache_add_volatile(cache, tree, "now"), "");
+    mu_assert(!betree_result_cache_add_volatile(cache, tree, "unknown"), "");
+
+    struct report* report = search(tree, cache, "{\"i\": 1, \"sl\": [\"b\", \"c\"], \"now\": 10}");
+    mu_assert(cache->misses == 1 && cache->hits == 0, "cold cache");
+    mu_assert(report->matched == 2 && report->evaluated == 2, "matched 1 and 2");
+    free_report(report);
+
+    report = search(tree, cache, "{\"now\": 20, \"sl\": [\"c\", \"b\"], \"i\": 1}");
+    mu_assert(cache->misses == 1 && cache->hits == 1, "same event modulo order and now");
+    mu_assert(report->matched == 2 && report->evaluated == 0, "tree not touched");
+    mu_assert(report->subs[0] == 1 && report->subs[1] == 2, "cached ids");
+    free_report(report);
+
+    report = search(tree, cache, "{\"i\": 2, \"sl\": [\"b\", \"c\"]}");
+    mu_assert(cache->misses == 2, "different event");
+    mu_assert(report->matched == 1 && report->subs[0] == 2, "matched 2");
+    free_report(report);
+
+    mu_assert(betree_insert(tree, 3, "i = 2"), "");
+    report = search(tree, cache, "{\"i\": 2, \"sl\": [\"b\", \"c\"]}");
+    mu_assert(cache->misses == 3, "insert invalidates");
+    mu_assert(report->matched == 2, "matched 2 and 3");
+    free_report(report);
+
+    betree_free_result_cache(cache);
+    betree_free(tree);
+    return 0;
+}
+
+int test_lru()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "i", false, 0, 10);
+
+    mu_assert(betree_insert(tree, 1, "i > 1"), "");
+
+    struct betree_result_cache* cache = betree_make_result_cache(tree, 2);
+    struct report* report = search(tree, cache, "{\"i\": 1}");
+    free_report(report);
+    report = search(tree, cache, "{\"i\": 2}");
+    free_report(report);
+    report = search(tree, cache, "{\"i\": 1}");
+    free_report(report);
+    mu_assert(cache->hits == 1 && cache->misses == 2, "");
+    report = search(tree, cache, "{\"i\": 3}");
+    free_report(report);
+    mu_assert(cache->count == 2, "bounded");
+    report = search(tree, cache, "{\"i\": 1}");
+    mu_assert(cache->hits == 2, "most recently used kept");
+    mu_assert(report->matched == 0, "");
+    free_report(report);
+    report = search(tree, cache, "{\"i\": 2}");
+    mu_assert(cache->misses == 4, "least recently used evicted");
+    mu_assert(report->matched == 1, "");
+    free_report(report);
+
+    betree_free_result_cache(cache);
+    betree_free(tree);
+    return 0;
+}
+
+int all_tests()
+{
+    mu_run_test(test_hit);
+    mu_run_test(test_lru);
+
+    return 0;
+}
+
+RUN_TESTS()
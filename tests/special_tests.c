@@ -1,4 +1,5 @@
 #include <inttypes.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -282,6 +283,51 @@ static bool segment_before_b(int64_t id, int64_t seconds) { return segment(false
 static bool not_segment_within(int64_t id, int64_t seconds, int64_t segment_id, int64_t segment_seconds) { return segment(true, SEGMENT_WITHIN, NO_VAR, id, seconds, segment_id, segment_seconds); }
 static bool not_segment_before(int64_t id, int64_t seconds, int64_t segment_id, int64_t segment_seconds) { return segment(true, SEGMENT_BEFORE, NO_VAR, id, seconds, segment_id, segment_seconds); }
 
+int test_frequency_indexed()
+{
+    const struct betree_constant* constants[] = {
+        betree_make_integer_constant("flight_id", 10),
+        betree_make_integer_constant("campaign_id", 30),
+    };
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "now", false, 0, 10);
+    add_attr_domain_frequency(tree->config, "frequency_caps", false);
+    betree_insert_with_constants(tree, 1, 2, constants, "within_frequency_cap(\"flight\", \"ns\", 5, 0)");
+    betree_insert_with_constants(tree, 2, 2, constants, "within_frequency_cap(\"flight\", \"other\", 5, 0)");
+    betree_insert_with_constants(tree, 3, 2, constants, "within_frequency_cap(\"campaign\", \"ns\", 5, 0)");
+    betree_insert_with_constants(tree, 4, 2, constants, "within_frequency_cap(\"flight\", \"ns\", 2, 0)");
+    char event_str[1024] = "{\"now\": 0, \"frequency_caps\": [";
+    for(size_t i = 0; i < 12; i++) {
+        char cap[64];
+        snprintf(cap, sizeof(cap), "[\"flight\", %zu, \"ns\", 100, 0], ", i + 11);
+        strcat(event_str, cap);
+    }
+    // Only the first of the two flight 10 caps counts
+    strcat(event_str,
+        "[\"flight\", 10, \"ns\", 3, 0], [\"flight\", 10, \"ns\", 9, 0], "
+        "[\"campaign\", 30, \"ns\", 7, 0]]}");
+
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, event_str, report), "goodSearch");
+    mu_assert(report->matched == 2, "goodMatched");
+    mu_assert(report->subs[0] + report->subs[1] == 3, "goodSubs");
+    free_report(report);
+
+    report = make_report();
+    struct betree_bound_event* bound = betree_make_bound_event(tree);
+    mu_assert(betree_search_with_bound_string(tree, bound, event_str, report), "goodBoundSearch");
+    mu_assert(report->matched == 2, "goodBoundMatched");
+    mu_assert(report->subs[0] + report->subs[1] == 3, "goodBoundSubs");
+    betree_free_bound_event(bound);
+    free_report(report);
+
+    for(size_t i = 0; i < 2; i++) {
+        betree_free_constant((struct betree_constant*)constants[i]);
+    }
+    betree_free(tree);
+    return 0;
+}
+
 int test_segment()
 {
     mu_assert(segment_within(1, 20, 1, 30), "segment_within_id_eq");
@@ -311,6 +357,146 @@ int test_segment()
     return 0;
 }
 
+int test_segment_unsorted()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "now", false, 0.0, 10.0);
+    add_attr_domain_segments(tree->config, "seg", false);
+    betree_insert(tree, 1, "segment_within(seg, 7, 20)");
+    betree_insert(tree, 2, "segment_before(seg, 3, 20)");
+    betree_insert(tree, 3, "segment_within(seg, 4, 20)");
+    betree_insert(tree, 4, "segment_within(seg, 9, 20)");
+    int64_t usec = 1000 * 1000;
+    char* event_str;
+    if(basprintf(&event_str,
+           "{\"now\": 40, \"seg\": [[9, %ld], [3, %ld], [7, %ld], [1, %ld], [5, %ld]]}",
+           30 * usec,
+           10 * usec,
+           30 * usec,
+           30 * usec,
+           30 * usec)
+        < 0) {
+        abort();
+    }
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, event_str, report), "goodSearch");
+    mu_assert(report->matched == 3, "goodMatched");
+    for(size_t i = 0; i < report->matched; i++) {
+        mu_assert(report->subs[i] != 3, "missingSegment");
+    }
+    free_report(report);
+    report = make_report();
+    struct betree_bound_event* bound = betree_make_bound_event(tree);
+    mu_assert(betree_search_with_bound_string(tree, bound, event_str, report), "goodBoundSearch");
+    mu_assert(report->matched == 3, "goodBoundMatched");
+    betree_free_bound_event(bound);
+    free(event_str);
+    free_report(report);
+    betree_free(tree);
+    return 0;
+}
+
+// Segment ids found in the event, each within the last 20 seconds or not
+static bool has_segment(const int64_t* ids, const bool* recent, size_t count, int64_t id, bool within)
+{
+    for(size_t i = 0; i < count; i++) {
+        if(ids[i] == id) {
+            return recent[i] == within;
+        }
+    }
+    return false;
+}
+
+int test_segment_partitioned()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_i(tree->config, "now", false, 0, 1000);
+    add_attr_domain_bounded_segments(tree->config, "seg", false, 0, 255);
+    const size_t count = 400;
+    int64_t first[count], second[count];
+    srand(42);
+    for(size_t i = 0; i < count; i++) {
+        first[i] = rand() % 256;
+        second[i] = rand() % 256;
+        char* expr;
+        int result;
+        switch(i % 4) {
+            case 0: result = basprintf(&expr, "segment_within(seg, %ld, 20)", first[i]); break;
+            case 1: result = basprintf(&expr, "segment_before(seg, %ld, 20)", first[i]); break;
+            case 2:
+                result = basprintf(&expr,
+                    "segment_within(seg, %ld, 20) or segment_within(seg, %ld, 20)",
+                    first[i],
+                    second[i]);
+                break;
+            case 3: result = basprintf(&expr, "not segment_within(seg, %ld, 20)", first[i]); break;
+            default: abort();
+        }
+        if(result < 0) {
+            abort();
+        }
+        mu_assert(betree_insert(tree, i, expr), "insert");
+        free(expr);
+    }
+    mu_assert(tree->cnode->pdir != NULL, "partitioned on the segments");
+    for(size_t e = 0; e < 200; e++) {
+        size_t segment_count = e % 7;
+        int64_t ids[8];
+        bool recent[8];
+        char* event;
+        if(basprintf(&event, "{\"now\": 100, \"seg\": [") < 0) {
+            abort();
+        }
+        for(size_t j = 0; j < segment_count; j++) {
+            ids[j] = e < 100 ? first[rand() % count] : rand() % 256;
+            for(size_t k = 0; k < j; k++) {
+                if(ids[k] == ids[j]) {
+                    ids[j] = (ids[j] + 1) % 256;
+                    k = -1;
+                }
+            }
+            recent[j] = rand() % 2 == 0;
+            char* next;
+            if(basprintf(&next, "%s%s[%ld, %ld]", event, j == 0 ? "" : ", ", ids[j],
+                   (recent[j] ? 90 : 50) * 1000000L) < 0) {
+                abort();
+            }
+            free(event);
+            event = next;
+        }
+        char* next;
+        if(basprintf(&next, "%s]}", event) < 0) {
+            abort();
+        }
+        free(event);
+        event = next;
+        size_t expected = 0;
+        for(size_t i = 0; i < count; i++) {
+            bool match;
+            switch(i % 4) {
+                case 0: match = has_segment(ids, recent, segment_count, first[i], true); break;
+                case 1: match = has_segment(ids, recent, segment_count, first[i], false); break;
+                case 2:
+                    match = has_segment(ids, recent, segment_count, first[i], true)
+                        || has_segment(ids, recent, segment_count, second[i], true);
+                    break;
+                case 3: match = !has_segment(ids, recent, segment_count, first[i], true); break;
+                default: abort();
+            }
+            if(match) {
+                expected++;
+            }
+        }
+        struct report* report = make_report();
+        mu_assert(betree_search(tree, event, report), "search");
+        mu_assert(report->matched == expected, "same matches as every sub");
+        free(event);
+        free_report(report);
+    }
+    betree_free(tree);
+    return 0;
+}
+
 static bool geo(bool has_not, const char* latitude, const char* longitude, const char* radius, double latitude_value, double longitude_value)
 {
     struct betree* tree = betree_make();
@@ -359,6 +545,104 @@ int test_geo()
     return 0;
 }
 
+static double distance(double lat1, double lon1, double lat2, double lon2)
+{
+    double to_rad = 3.1415926536 / 180;
+    lon1 -= lon2;
+    lon1 *= to_rad, lat1 *= to_rad, lat2 *= to_rad;
+    double dz = sin(lat1) - sin(lat2);
+    double dx = cos(lon1) * cos(lat1) - cos(lat2);
+    double dy = sin(lon1) * cos(lat1);
+    return asin(sqrt(dx * dx + dy * dy + dz * dz) / 2) * 2 * 6372.8;
+}
+
+int test_geo_partitioned()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_f(tree->config, "latitude", false, -90.0, 90.0);
+    add_attr_domain_bounded_f(tree->config, "longitude", false, -180.0, 180.0);
+    const size_t count = 400;
+    double latitudes[count], longitudes[count], radiuses[count];
+    srand(42);
+    for(size_t i = 0; i < count; i++) {
+        latitudes[i] = i == 0 ? 0.0 : i == 1 ? 89.5 : (rand() % 17000) / 100.0 - 85.0;
+        longitudes[i] = i == 0 ? 179.9 : (rand() % 36000) / 100.0 - 180.0;
+        radiuses[i] = 10.0 + rand() % 2000;
+        char* expr;
+        if(basprintf(&expr, "geo_within_radius(%.2f, %.2f, %.1f)", latitudes[i], longitudes[i], radiuses[i]) < 0) {
+            abort();
+        }
+        mu_assert(betree_insert(tree, i, expr), "insert");
+        free(expr);
+    }
+    for(size_t e = 0; e < 300; e++) {
+        double latitude, longitude;
+        if(e < 100) {
+            // On both sides of a circle's edge toward the equator
+            size_t i = e % count;
+            double degrees = radiuses[i] / 6372.8 * 180 / 3.1415926536;
+            double side = latitudes[i] > 0 ? -1.0 : 1.0;
+            latitude = latitudes[i] + side * degrees * (e % 2 == 0 ? 0.999 : 1.001);
+            longitude = longitudes[i];
+        }
+        else if(e == 100) {
+            // Across the antimeridian from the first circle
+            latitude = 0.0;
+            longitude = -179.95;
+        }
+        else {
+            latitude = (rand() % 18000) / 100.0 - 90.0;
+            longitude = (rand() % 36000) / 100.0 - 180.0;
+        }
+        size_t expected = 0;
+        for(size_t i = 0; i < count; i++) {
+            if(distance(latitudes[i], longitudes[i], latitude, longitude) <= radiuses[i]) {
+                expected++;
+            }
+        }
+        char* event;
+        if(basprintf(&event, "{\"latitude\": %.17g, \"longitude\": %.17g}", latitude, longitude) < 0) {
+            abort();
+        }
+        struct report* report = make_report();
+        mu_assert(betree_search(tree, event, report), "search");
+        mu_assert(report->matched == expected, "same matches as the full distance");
+        if(e == 100) {
+            bool found = false;
+            for(size_t i = 0; i < report->matched; i++) {
+                found |= report->subs[i] == 0;
+            }
+            mu_assert(found, "antimeridian");
+        }
+        free(event);
+        free_report(report);
+    }
+    betree_free(tree);
+    return 0;
+}
+
+int test_geo_out_of_range()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_bounded_f(tree->config, "latitude", false, -90.0, 90.0);
+    add_attr_domain_bounded_f(tree->config, "longitude", false, -360.0, 360.0);
+    mu_assert(betree_insert(tree, 0, "geo_within_radius(0.0, -170.0, 200.0)"), "insert");
+    for(size_t i = 1; i < 400; i++) {
+        char* expr;
+        if(basprintf(&expr, "geo_within_radius(0.0, %.2f, 10.0)", (i % 360) - 179.5) < 0) {
+            abort();
+        }
+        mu_assert(betree_insert(tree, i, expr), "insert");
+        free(expr);
+    }
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, "{\"latitude\": 0.0, \"longitude\": 190.0}", report), "search");
+    mu_assert(report->matched == 1 && report->subs[0] == 0, "longitude past 180 wraps");
+    free_report(report);
+    betree_free(tree);
+    return 0;
+}
+
 static bool contains(bool has_not, const char* attr, bool allow_undefined, const char* pattern, const char* value)
 {
     struct betree* tree = betree_make();
@@ -528,14 +812,134 @@ static int test_ends_with()
     return 0;
 }
 
+static void random_string(char* buffer, size_t max_length)
+{
+    size_t length = rand() % (max_length + 1);
+    for(size_t i = 0; i < length; i++) {
+        buffer[i] = "abc"[rand() % 3];
+    }
+    buffer[length] = '\0';
+}
+
+int test_string_matcher()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_s(tree->config, "a", true);
+    const size_t count = 150;
+    const char* ops[] = { "contains", "starts_with", "ends_with" };
+    char patterns[count][8];
+    srand(11);
+    for(size_t i = 0; i < count; i++) {
+        random_string(patterns[i], 5);
+        char* expr;
+        if(basprintf(&expr, "%s%s(a, \"%s\")", i % 7 == 0 ? "not " : "", ops[i % 3], patterns[i]) < 0) {
+            abort();
+        }
+        mu_assert(betree_insert(tree, i, expr), "insert");
+        free(expr);
+    }
+    for(size_t e = 0; e < 500; e++) {
+        char value[32];
+        random_string(value, 30);
+        bool expected[count];
+        size_t expected_count = 0;
+        for(size_t i = 0; i < count; i++) {
+            size_t value_length = strlen(value), pattern_length = strlen(patterns[i]);
+            bool result;
+            switch(i % 3) {
+                case 0: result = strstr(value, patterns[i]) != NULL; break;
+                case 1: result = strncmp(value, patterns[i], pattern_length) == 0; break;
+                default:
+                    result = value_length >= pattern_length
+                        && strcmp(value + value_length - pattern_length, patterns[i]) == 0;
+                    break;
+            }
+            expected[i] = i % 7 == 0 ? !result : result;
+            expected_count += expected[i];
+        }
+        char* event;
+        if(basprintf(&event, "{\"a\": \"%s\"}", value) < 0) {
+            abort();
+        }
+        struct report* report = make_report();
+        mu_assert(betree_search(tree, event, report), "search");
+        mu_assert(report->matched == expected_count, "same match count as the string functions");
+        for(size_t i = 0; i < report->matched; i++) {
+            mu_assert(expected[report->subs[i]], "same matches as the string functions");
+        }
+        free(event);
+        free_report(report);
+    }
+    betree_free(tree);
+    return 0;
+}
+
+// The string specials use the value's length, check it is set by every way to give an event
+int test_string_lengths()
+{
+    struct betree* tree = betree_make();
+    add_attr_domain_s(tree->config, "ua", false);
+    const char* exprs[] = { "starts_with(ua, \"Mozilla/\")",
+        "ends_with(ua, \"Firefox/1.0\")",
+        "contains(ua, \"Gecko/\")",
+        "contains(ua, \"Firefox/1.0 \")",
+        "ends_with(ua, \"Mozilla/5.0 Gecko/2010 Firefox/1.0\")",
+        "starts_with(ua, \"Mozilla/5.0 Gecko/2010 Firefox/1.0 \")" };
+    size_t expr_count = sizeof(exprs) / sizeof(exprs[0]);
+    for(size_t i = 0; i < expr_count; i++) {
+        mu_assert(betree_insert(tree, i, exprs[i]), "insert");
+    }
+    const char* value = "Mozilla/5.0 Gecko/2010 Firefox/1.0";
+
+    struct report* report = make_report();
+    mu_assert(betree_search(tree, "{\"ua\": \"Mozilla/5.0 Gecko/2010 Firefox/1.0\"}", report), "read");
+    mu_assert(report->matched == 4, "read matched");
+    free_report(report);
+
+    struct betree_event* event = betree_make_event(tree);
+    betree_set_variable(event, 0, betree_make_string_variable("ua", value));
+    report = make_report();
+    mu_assert(betree_search_with_event(tree, event, report), "made");
+    mu_assert(report->matched == 4, "made matched");
+    free_report(report);
+    betree_free_event(event);
+
+    struct betree_bound_event* bound = betree_make_bound_event(tree);
+    mu_assert(betree_set_bound_string(bound, 0, INVALID_STR, value), "bind");
+    report = make_report();
+    mu_assert(betree_search_with_bound_event(tree, bound, report), "bound");
+    mu_assert(report->matched == 4, "bound matched");
+    free_report(report);
+    betree_free_bound_event(bound);
+
+    struct betree_binary_encoder* encoder = betree_make_binary_encoder();
+    betree_encode_string(encoder, 0, INVALID_STR, value);
+    size_t length;
+    const void* buffer = betree_binary_encoder_data(encoder, &length);
+    report = make_report();
+    mu_assert(betree_search_binary(tree, buffer, length, report), "binary");
+    mu_assert(report->matched == 4, "binary matched");
+    free_report(report);
+    betree_free_binary_encoder(encoder);
+    betree_free(tree);
+    return 0;
+}
+
 int all_tests() 
 {
     mu_run_test(test_frequency);
+    mu_run_test(test_frequency_indexed);
     mu_run_test(test_segment);
+    mu_run_test(test_segment_unsorted);
+    mu_run_test(test_segment_partitioned);
     mu_run_test(test_geo);
+    mu_run_test(test_geo_partitioned);
+    mu_run_test(test_geo_out_of_range);
     mu_run_test(test_contains);
     mu_run_test(test_starts_with);
     mu_run_test(test_ends_with);
+    mu_run_test(test_string_matcher);
+    mu_run_test(test_string_lengths);
 
     return 0;
 }